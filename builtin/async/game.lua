@@ -70,3 +70,21 @@ setmetatable(core.registered_craftitems, alias_metatable)
 setmetatable(core.registered_tools, alias_metatable)
 
 builtin_shared.cache_content_ids()
+
+-- Read-only map access, see also builtin/game/item.lua
+if core.get_node_raw then
+	local get_node_raw = core.get_node_raw
+	local get_name_from_content_id = core.get_name_from_content_id
+
+	function core.get_node(pos)
+		local content, param1, param2 = get_node_raw(pos.x, pos.y, pos.z)
+		return {name = get_name_from_content_id(content), param1 = param1, param2 = param2}
+	end
+
+	function core.get_node_or_nil(pos)
+		local content, param1, param2, pos_ok = get_node_raw(pos.x, pos.y, pos.z)
+		return pos_ok and
+				{name = get_name_from_content_id(content), param1 = param1, param2 = param2}
+				or nil
+	end
+end
@@ -53,6 +53,12 @@ core.features = {
 	generate_decorations_biomes = true,
 	chunksize_vector = true,
 	item_inventory_image_animation = true,
+	voxel_buffer = true,
+	find_nodes_in_area_raw = true,
+	async_map_access = true,
+	entity_step_batch = true,
+	object_xyz_accessors = true,
+	ipc_wait = true,
 }
 
 function core.has_feature(arg)
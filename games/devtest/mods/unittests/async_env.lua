@@ -167,6 +167,61 @@ local function test_userdata_passing2(cb, _, pos)
 end
 unittests.register("test_userdata_passing2", test_userdata_passing2, {map=true, async=true})
 
+local function test_async_map_access(cb, _, pos)
+	core.swap_node(pos, {name="basenodes:stone"})
+	core.swap_node(pos:offset(1, 0, 0), {name="air"})
+	core.swap_node(pos:offset(2, 0, 0), {name="air"})
+
+	-- Changes become visible to the async environment after the server step
+	core.after(0, function()
+		core.handle_async(function(pos_)
+			local from = pos_:offset(2, 0, 0)
+			local ray = core.raycast(from, pos_, false, false)
+			local pointed = ray:next()
+			local _, blocked_at = core.line_of_sight(from, pos_)
+			return core.get_node(pos_).name,
+				core.find_nodes_in_area(pos_:offset(0, 0, 0), from, "basenodes:stone"),
+				blocked_at, pointed and pointed.under
+		end, function(name, found, blocked_at, under)
+			core.remove_node(pos)
+			if name ~= "basenodes:stone" then
+				return cb("Wrong node read: " .. name)
+			end
+			if #found ~= 1 or found[1] ~= pos then
+				return cb("find_nodes_in_area failed")
+			end
+			if blocked_at ~= pos then
+				return cb("line_of_sight failed")
+			end
+			if under ~= pos then
+				return cb("raycast failed")
+			end
+			cb()
+		end, pos)
+	end)
+end
+unittests.register("test_async_map_access", test_async_map_access, {map=true, async=true})
+
+local function test_voxel_buffer_passing(cb)
+	-- Elements are shared, but modifying either side must not affect the other
+	local buf = VoxelBuffer("u8", "abc")
+	core.handle_async(function(buf_)
+		local seen = buf_:to_string()
+		buf_[1] = 120
+		return buf_, seen
+	end, function(ret, seen)
+		if seen ~= "abc" or ret:to_string() ~= "xbc" then
+			return cb("Buffer contents not transferred")
+		end
+		if buf:to_string() ~= "abx" then
+			return cb("Buffer modified in other environment")
+		end
+		cb()
+	end, buf)
+	buf[3] = 120
+end
+unittests.register("test_voxel_buffer_passing", test_voxel_buffer_passing, {async=true})
+
 local function test_portable_metatable_override()
 	assert(pcall(core.register_portable_metatable, "__builtin:vector", vector.metatable),
 			"Metatable name aliasing throws an error when it should be allowed")
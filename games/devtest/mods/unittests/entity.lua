@@ -161,6 +161,60 @@ unittests.register("test_entity_attach", test_entity_attach, {player=true, map=t
 
 ---------
 
+local batch_log
+
+core.register_entity("unittests:step_batch", {
+	initial_properties = {
+		physical = true,
+		visual = "upright_sprite",
+		textures = { "no_texture.png" },
+		static_save = false,
+	},
+
+	on_step = function(self, dtime, moveresult)
+		error("on_step called despite on_step_batch")
+	end,
+	on_step_batch = function(entities, dtime, moveresults)
+		assert(dtime > 0)
+		for i, self in ipairs(entities) do
+			assert(self.name == "unittests:step_batch")
+			assert(type(moveresults[i]) == "table")
+			if batch_log then
+				batch_log[self.object] = true
+			end
+		end
+		if batch_log then
+			batch_log.calls = batch_log.calls + 1
+		end
+	end,
+})
+
+local function test_entity_step_batch(cb, _, pos)
+	local objs = {}
+	for i = 1, 3 do
+		objs[i] = core.add_entity(pos:offset(i, 0, 0), "unittests:step_batch")
+	end
+	batch_log = {calls = 0}
+	local function check()
+		if batch_log.calls < 2 then
+			core.after(0, check)
+			return
+		end
+		for _, obj in ipairs(objs) do
+			if not batch_log[obj] then
+				return cb("Entity was not stepped")
+			end
+			obj:remove()
+		end
+		batch_log = nil
+		cb()
+	end
+	core.after(0, check)
+end
+unittests.register("test_entity_step_batch", test_entity_step_batch, {map=true, async=true})
+
+---------
+
 core.register_entity("unittests:dummy", {
 	initial_properties = {
 		hp_max = 1,
@@ -186,6 +240,21 @@ local function test_entity_raycast(_, pos)
 end
 unittests.register("test_entity_raycast", test_entity_raycast, {map=true})
 
+local function test_object_xyz_accessors(_, pos)
+	local obj = core.add_entity(pos, "unittests:dummy")
+	local x, y, z = obj:get_pos_xyz()
+	assert(vector.equals(vector.new(x, y, z), obj:get_pos()))
+
+	obj:set_velocity_xyz(1, 2.5, -3)
+	assert(vector.equals(obj:get_velocity(), vector.new(1, 2.5, -3)))
+	x, y, z = obj:get_velocity_xyz()
+	assert(x == 1 and y == 2.5 and z == -3)
+
+	obj:remove()
+	assert(obj:get_pos_xyz() == nil)
+end
+unittests.register("test_object_xyz_accessors", test_object_xyz_accessors, {map=true})
+
 local function test_object_iterator(pos, make_iterator)
 	local obj1 = core.add_entity(pos, "unittests:dummy")
 	local obj2 = core.add_entity(pos, "unittests:dummy")
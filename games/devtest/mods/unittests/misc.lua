@@ -36,6 +36,39 @@ local function test_pcg_random()
 end
 unittests.register("test_pcg_random", test_pcg_random)
 
+local function test_voxel_buffer()
+	local vm = VoxelManip()
+	local emin = vm:initialize(vector.zero(), vector.new(15, 15, 15), {name = "air", param2 = 3})
+	local volume = 16 * 16 * 16
+	local c_stone = core.get_content_id("basenodes:stone")
+
+	local data = VoxelBuffer("u16")
+	assert(data:get_type() == "u16")
+	assert(vm:get_data(data) == data)
+	assert(#data == volume)
+	assert(data[1] == core.CONTENT_AIR)
+	assert(data[0] == nil and data[volume + 1] == nil)
+	data[2] = c_stone
+	vm:set_data(data)
+	assert(vm:get_data()[2] == c_stone)
+	local t = data:to_table()
+	assert(#t == volume and t[2] == c_stone)
+
+	local param2 = VoxelBuffer("u8", volume)
+	vm:get_param2_data(param2)
+	assert(param2[1] == 3)
+	param2[1] = 5
+	vm:set_param2_data(param2)
+	assert(vm:get_node_at(emin).param2 == 5)
+
+	-- wrong type, too small, out of range
+	assert(not pcall(vm.get_data, vm, param2))
+	assert(not pcall(vm.set_data, vm, VoxelBuffer("u16", 1)))
+	assert(not pcall(function() data[volume + 1] = 0 end))
+	vm:close()
+end
+unittests.register("test_voxel_buffer", test_voxel_buffer)
+
 local function test_dynamic_media(cb, player)
 	if core.get_player_information(player:get_player_name()).protocol_version < 40 then
 		core.log("warning", "test_dynamic_media: Client too old, skipping test.")
@@ -107,6 +140,47 @@ local function test_node_callbacks(_, pos)
 end
 unittests.register("test_node_callbacks", test_node_callbacks, {map=true})
 
+local function test_find_nodes_in_area_raw(_, pos)
+	local minp, maxp = pos, pos:add(2)
+	local c_dirt = core.get_content_id("basenodes:dirt")
+	local c_stone = core.get_content_id("basenodes:stone")
+	for x = minp.x, maxp.x do
+	for y = minp.y, maxp.y do
+	for z = minp.z, maxp.z do
+		core.swap_node(vector.new(x, y, z), {name="air"})
+	end
+	end
+	end
+	core.swap_node(pos:add(vector.new(2, 0, 0)), {name="basenodes:dirt", param2=3})
+	core.swap_node(pos:add(vector.new(0, 1, 0)), {name="basenodes:stone"})
+	core.swap_node(pos:add(vector.new(0, 0, 2)), {name="basenodes:dirt", param2=8})
+
+	local area = VoxelArea(minp, maxp)
+	local indices, ids = core.find_nodes_in_area_raw(maxp, minp,
+		{"basenodes:dirt", c_stone})
+	assert(#indices == 3 and #ids == 3)
+	assert(area:position(indices[1]) == pos:add(vector.new(2, 0, 0)))
+	assert(ids[1] == c_dirt)
+	assert(area:position(indices[2]) == pos:add(vector.new(0, 1, 0)))
+	assert(ids[2] == c_stone)
+	assert(area:position(indices[3]) == pos:add(vector.new(0, 0, 2)))
+	assert(ids[3] == c_dirt)
+
+	indices, ids = core.find_nodes_in_area_raw(minp, maxp, c_dirt,
+		{param2_mask=7, param2_max=2})
+	assert(#indices == 1 and ids[1] == c_dirt)
+	assert(area:position(indices[1]) == pos:add(vector.new(0, 0, 2)))
+
+	for x = minp.x, maxp.x do
+	for y = minp.y, maxp.y do
+	for z = minp.z, maxp.z do
+		core.remove_node(vector.new(x, y, z))
+	end
+	end
+	end
+end
+unittests.register("test_find_nodes_in_area_raw", test_find_nodes_in_area_raw, {map=true})
+
 local function test_hashing()
 	local input = "hello\000world"
 	assert(core.sha1(input) == "f85b420f1e43ebf88649dfcab302b898d889606c")
@@ -343,6 +417,31 @@ local function test_ipc_poll()
 end
 unittests.register("test_ipc_poll", test_ipc_poll)
 
+local function test_ipc_wait()
+	core.ipc_set("unittests:counter", nil)
+	assert(core.ipc_version("unittests:counter") == 0)
+	assert(core.ipc_wait("unittests:counter", 0, 1) == false)
+
+	core.ipc_set("unittests:counter", 1)
+	local version = core.ipc_version("unittests:counter")
+	assert(version > 0)
+	assert(core.ipc_wait("unittests:counter", 0, 1) == true)
+	assert(core.ipc_wait("unittests:counter", version, 1) == false)
+
+	-- cas bumps the version too
+	assert(core.ipc_cas("unittests:counter", 1, 2))
+	assert(core.ipc_version("unittests:counter") > version)
+	version = core.ipc_version("unittests:counter")
+
+	core.handle_async(function()
+		core.ipc_set("unittests:counter", 3)
+	end, function() end)
+	assert(core.ipc_wait("unittests:counter", version, 1000) == true, "Wait failed (or slow machine?)")
+	assert(core.ipc_get("unittests:counter") == 3)
+	core.ipc_set("unittests:counter", nil)
+end
+unittests.register("test_ipc_wait", test_ipc_wait)
+
 local function test_sandbox()
 	if not core.settings:get_bool("secure.enable_security") then
 		core.log("warning", "Lua sandbox disabled, skipping test")
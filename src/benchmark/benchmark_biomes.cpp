@@ -0,0 +1,83 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "unittest/mock_mapgen.h"
+#include "noise.h"
+
+namespace {
+	// Biomes like games register them: climates with an underground, ocean,
+	// shore and surface variant each
+	void addBiomes(BiomeManager *bmgr, u32 count)
+	{
+		PcgRandom pr(count);
+		const struct {
+			s16 y_min, y_max, vertical_blend;
+		} layers[] = {
+			{ -31000, -256, 0 },
+			{ -255, -2, 0 },
+			{ -1, 3, 0 },
+			{ 4, 31000, 6 },
+		};
+		float heat = 0, humidity = 0;
+		for (u32 i = 0; i < count; i++) {
+			const auto &layer = layers[i % 4];
+			if (i % 4 == 0) {
+				heat = pr.range(0, 100);
+				humidity = pr.range(0, 100);
+			}
+			Biome *b = BiomeManager::create(BIOMETYPE_NORMAL);
+			b->name = "biome" + std::to_string(i);
+			b->heat_point = heat;
+			b->humidity_point = humidity;
+			b->min_pos.Y = layer.y_min;
+			b->max_pos.Y = layer.y_max;
+			b->vertical_blend = layer.vertical_blend;
+			bmgr->add(b);
+		}
+	}
+}
+
+// Biomes of the columns of a 80³ chunk
+TEST_CASE("benchmark_biomes")
+{
+	for (u32 count : {10, 50, 200}) {
+		MockMapgen mg;
+		BiomeManager *bmgr = mg.emerge()->getWritableBiomeManager();
+		addBiomes(bmgr, count);
+
+		std::unique_ptr<BiomeParams> params(
+			BiomeManager::createBiomeParams(BIOMEGEN_ORIGINAL));
+		params->seed = 1234;
+		const v3s16 csize(80, 80, 80);
+		BiomeGenOriginal biomegen(bmgr,
+			static_cast<BiomeParamsOriginal *>(params.get()), csize);
+
+		// Around sea level
+		std::vector<s16> heightmap(csize.X * csize.Z);
+		PcgRandom pr(42);
+		for (s16 &height : heightmap)
+			height = pr.range(-20, 40);
+		const s16 x = 0;
+		biomegen.calcBiomeNoise(v3s16(x, 0, 0));
+
+		const std::string suffix = "_" + std::to_string(count) + "biomes";
+		BENCHMARK("getBiomes" + suffix, i) {
+			return biomegen.getBiomes(heightmap.data(), v3s16(x, 0, 0))[i % 6400];
+		};
+
+		// Checking every biome, as before
+		BENCHMARK("getBiomes_linear" + suffix, i) {
+			biome_t ret = 0;
+			for (s16 z = 0; z < csize.Z; z++)
+			for (s16 xr = 0; xr < csize.X; xr++) {
+				const u32 index = z * csize.X + xr;
+				ret ^= biomegen.calcBiomeFromNoiseLinear(biomegen.heatmap[index],
+					biomegen.humidmap[index],
+					v3s16(x + xr, heightmap[index], z))->index;
+			}
+			return ret;
+		};
+	}
+}
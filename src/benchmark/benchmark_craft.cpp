@@ -0,0 +1,127 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "dummygamedef.h"
+#include "craftdef.h"
+#include "inventory.h"
+#include "itemdef.h"
+#include "noise.h"
+
+namespace {
+	constexpr int NUM_ITEMS = 2000;
+	constexpr int NUM_GROUPS = 40;
+
+	std::string itemName(int i)
+	{
+		return "mod" + std::to_string(i % 50) + ":item" + std::to_string(i);
+	}
+
+	// Any item of the group
+	std::string itemOfGroup(PcgRandom &rand, int group)
+	{
+		return itemName(group + NUM_GROUPS * rand.range(0, NUM_ITEMS / NUM_GROUPS - 1));
+	}
+
+	CraftInput makeInput(const std::vector<std::string> &names, u32 width,
+			IItemDefManager *idef)
+	{
+		std::vector<ItemStack> items;
+		for (const std::string &name : names)
+			items.emplace_back(name, name.empty() ? 0 : 1, 0, idef);
+		return CraftInput(CRAFT_METHOD_NORMAL, width, items);
+	}
+}
+
+// Recipe set of a large modpack: 2000 items in 40 groups, with 2500 recipes
+// for items and 1500 using groups
+TEST_CASE("benchmark_craft")
+{
+	DummyGameDef gamedef;
+	auto *idef = static_cast<IWritableItemDefManager *>(gamedef.getItemDefManager());
+	auto *cdef = static_cast<IWritableCraftDefManager *>(gamedef.getCraftDefManager());
+
+	// Each item is in two groups
+	for (int i = 0; i < NUM_ITEMS; i++) {
+		ItemDefinition def;
+		def.type = ITEM_CRAFT;
+		def.name = itemName(i);
+		def.groups["group" + std::to_string(i % NUM_GROUPS)] = 1;
+		def.groups["group" + std::to_string((i / NUM_GROUPS + 7) % NUM_GROUPS)] = 1;
+		idef->registerItem(def);
+	}
+
+	PcgRandom rand(42);
+	std::vector<CraftInput> group_grids, item_grids;
+	for (int r = 0; r < 4000; r++) {
+		const bool groups = r % 8 < 3;
+		const u32 width = rand.range(1, 3);
+		const u32 slots = width * rand.range(1, 3);
+		std::vector<std::string> recipe, grid;
+		for (u32 i = 0; i < slots; i++) {
+			if (rand.range(0, 3) == 0) {
+				recipe.emplace_back();
+				grid.emplace_back();
+			} else if (groups && rand.range(0, 1) == 0) {
+				int group = rand.range(0, NUM_GROUPS - 1);
+				recipe.push_back("group:group" + std::to_string(group));
+				grid.push_back(itemOfGroup(rand, group));
+			} else {
+				recipe.push_back(itemName(rand.range(0, NUM_ITEMS - 1)));
+				grid.push_back(recipe.back());
+			}
+		}
+		const std::string output = itemName(rand.range(0, NUM_ITEMS - 1));
+		if (r % 2 == 0)
+			cdef->registerCraft(new CraftDefinitionShaped(output, width, recipe,
+					CraftReplacements()), &gamedef);
+		else
+			cdef->registerCraft(new CraftDefinitionShapeless(output, recipe,
+					CraftReplacements()), &gamedef);
+
+		auto &grids = groups ? group_grids : item_grids;
+		grids.push_back(makeInput(grid, width, idef));
+	}
+	cdef->registerCraft(new CraftDefinitionToolRepair(0.02f), &gamedef);
+	cdef->initHashes(&gamedef);
+
+	// Random grids, mostly without a recipe
+	std::vector<CraftInput> random_grids;
+	for (int g = 0; g < 1024; g++) {
+		std::vector<std::string> names;
+		for (int i = 0; i < 9; i++)
+			names.push_back(rand.range(0, 2) == 0 ? itemName(rand.range(0, NUM_ITEMS - 1)) : "");
+		random_grids.push_back(makeInput(names, 3, idef));
+	}
+
+	auto lookup = [&] (std::vector<CraftInput> &grids, size_t count) {
+		int found = 0;
+		CraftOutput output;
+		std::vector<ItemStack> replacements;
+		for (size_t i = 0; i < count; i++) {
+			found += cdef->getCraftResult(grids[i % grids.size()], output,
+					replacements, false, &gamedef);
+		}
+		return found;
+	};
+
+	// A few grids, as when players craft
+	std::vector<CraftInput> few_grids(group_grids.begin(), group_grids.begin() + 32);
+	BENCHMARK("getCraftResult_repeated_x1000", i) {
+		return lookup(few_grids, 1000);
+	};
+
+	// More grids than are cached
+	BENCHMARK("getCraftResult_groups_x1000", i) {
+		return lookup(group_grids, 1000);
+	};
+
+	BENCHMARK("getCraftResult_items_x1000", i) {
+		return lookup(item_grids, 1000);
+	};
+
+	BENCHMARK("getCraftResult_random_x1000", i) {
+		return lookup(random_grids, 1000);
+	};
+}
@@ -0,0 +1,68 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "script/cpp_api/s_entity.h"
+
+namespace {
+	class BenchScriptApi : public ScriptApiEntity {
+	public:
+		BenchScriptApi() : ScriptApiBase(ScriptingType::Server) {}
+		using ScriptApiBase::getStack;
+	};
+
+	// Entities of two types that do the same, one of them batched
+	const char *setup_script = R"(
+		core.luaentities = {}
+		core.registered_entities = {}
+
+		local function update(self, dtime)
+			self.timer = self.timer + dtime
+			if self.timer > 1 then
+				self.timer = 0
+			end
+		end
+
+		local single = {name = "single", on_step = update}
+		single.__index = single
+		local batched = {name = "batched", on_step_batch = function(entities, dtime)
+			for i = 1, #entities do
+				update(entities[i], dtime)
+			end
+		end}
+		batched.__index = batched
+		core.registered_entities.single = single
+		core.registered_entities.batched = batched
+
+		for id = 1, 3000 do
+			core.luaentities[id] = setmetatable({timer = 0}, single)
+			core.luaentities[id + 3000] = setmetatable({timer = 0}, batched)
+		end
+	)";
+}
+
+TEST_CASE("benchmark_entitystep")
+{
+	BenchScriptApi script;
+	lua_State *L = script.getStack();
+	REQUIRE(luaL_dostring(L, setup_script) == 0);
+
+	REQUIRE(!script.luaentity_HasStepBatch(1));
+	REQUIRE(script.luaentity_HasStepBatch(3001));
+
+	const std::string name = "batched";
+
+	BENCHMARK("on_step_3000", i) {
+		for (u16 id = 1; id <= 3000; id++)
+			script.luaentity_Step(id, 0.05f, nullptr);
+		return i;
+	};
+
+	BENCHMARK("on_step_batch_3000", i) {
+		for (u16 id = 3001; id <= 6000; id++)
+			script.luaentity_QueueStep(name, id, nullptr);
+		script.luaentity_StepBatches(0.05f);
+		return i;
+	};
+}
@@ -0,0 +1,138 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "script/common/c_packer.h"
+#include "server/modipcstore.h"
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C" {
+#include <lauxlib.h>
+#include <lualib.h>
+}
+
+namespace {
+	constexpr int WORKERS = 8;
+	constexpr int OPS_PER_WORKER = 5000;
+	constexpr int KEYS = 64;
+
+	// The store as it was before sharding: one lock, values unpacked under it
+	class GlobalLockStore {
+	public:
+		void get(lua_State *L, const std::string &key)
+		{
+			std::shared_lock lock(m_mutex);
+			auto it = m_map.find(key);
+			if (it == m_map.end())
+				lua_pushnil(L);
+			else
+				script_unpack(L, const_cast<PackedValue *>(it->second.get()));
+		}
+
+		void set(const std::string &key, ModIPCStore::Value value)
+		{
+			std::unique_lock lock(m_mutex);
+			m_map[key] = std::move(value);
+		}
+
+	private:
+		std::shared_mutex m_mutex;
+		std::unordered_map<std::string, ModIPCStore::Value> m_map;
+	};
+
+	// A table like mods would share: a few fields and a list
+	ModIPCStore::Value make_value()
+	{
+		lua_State *L = luaL_newstate();
+		REQUIRE(luaL_dostring(L, R"(
+			local t = {name = "job", state = "running", progress = 0.5, list = {}}
+			for i = 1, 32 do t.list[i] = i * 2 end
+			return t
+		)") == 0);
+		ModIPCStore::Value ret(script_pack(L, -1));
+		lua_close(L);
+		return ret;
+	}
+
+	// Every worker reads, and writes one out of `write_every` times
+	template <typename F>
+	void run_workers(int write_every, F op)
+	{
+		std::vector<std::thread> workers;
+		for (int w = 0; w < WORKERS; w++) {
+			workers.emplace_back([&, w] {
+				lua_State *L = luaL_newstate();
+				for (int i = 0; i < OPS_PER_WORKER; i++) {
+					const std::string key = "bench:" + std::to_string((w * 7 + i) % KEYS);
+					op(L, key, i % write_every == 0);
+					lua_settop(L, 0);
+				}
+				lua_close(L);
+			});
+		}
+		for (auto &t : workers)
+			t.join();
+	}
+}
+
+// 8 threads, like async workers, working on the same 64 keys
+TEST_CASE("benchmark_ipc")
+{
+	const ModIPCStore::Value value = make_value();
+
+	ModIPCStore store;
+	GlobalLockStore old_store;
+	for (int k = 0; k < KEYS; k++) {
+		store.set("bench:" + std::to_string(k), value);
+		old_store.set("bench:" + std::to_string(k), value);
+	}
+
+	for (int write_every : {2, 10, 100}) {
+		const std::string suffix = "_" + std::to_string(100 / write_every) + "pct_writes";
+
+		BENCHMARK("global_lock" + suffix, i) {
+			run_workers(write_every, [&] (lua_State *L, const std::string &key, bool write) {
+				if (write)
+					old_store.set(key, value);
+				else
+					old_store.get(L, key);
+			});
+			return i;
+		};
+
+		BENCHMARK("sharded" + suffix, i) {
+			run_workers(write_every, [&] (lua_State *L, const std::string &key, bool write) {
+				if (write) {
+					store.set(key, value);
+				} else {
+					auto pv = store.get(key);
+					script_unpack(L, const_cast<PackedValue *>(pv.get()));
+				}
+			});
+			return i;
+		};
+	}
+
+	// Ping-pong between two threads, each waiting for a change of the other
+	BENCHMARK("wait_for_change_1000", i) {
+		const std::string ping_key = "bench:ping", pong_key = "bench:pong";
+		const auto timeout = std::chrono::seconds(10);
+		u64 ping = store.getVersion(ping_key), pong = store.getVersion(pong_key);
+		std::thread other([&, ping] () mutable {
+			for (int n = 0; n < 1000; n++) {
+				store.waitForChange(ping_key, ping, timeout);
+				ping = store.getVersion(ping_key);
+				store.set(pong_key, value);
+			}
+		});
+		for (int n = 0; n < 1000; n++) {
+			store.set(ping_key, value);
+			store.waitForChange(pong_key, pong, timeout);
+			pong = store.getVersion(pong_key);
+		}
+		other.join();
+		return i;
+	};
+}
@@ -0,0 +1,97 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "unittest/mock_mapgen.h"
+#include "mapgen/mapgen_carpathian.h"
+#include "mapgen/mapgen_v7.h"
+#include "settings.h"
+
+namespace {
+	Mapgen *initMapgen(MockMapgen &mg, MapgenType type, u32 spflags)
+	{
+		MapgenParams *params = Mapgen::createMapgenParams(type);
+		params->mgtype = type;
+		params->seed = 1234567;
+		params->flags = MG_CAVES | MG_DUNGEONS | MG_LIGHT | MG_DECORATIONS |
+			MG_BIOMES | MG_ORES;
+		params->spflags = spflags;
+		return mg.init(params);
+	}
+}
+
+// Generation of a single 80³ chunk
+TEST_CASE("benchmark_mapgen")
+{
+	struct Chunk {
+		const char *name;
+		v3s16 blockpos;
+	};
+	auto bench = [] (MockMapgen &mg, const std::string &prefix,
+			std::initializer_list<Chunk> chunks) {
+		for (const Chunk &chunk : chunks) {
+			BENCHMARK(prefix + chunk.name, i) {
+				return MockMapgen::hashNodes(mg.makeChunk(chunk.blockpos)->vmanip);
+			};
+		}
+	};
+
+	// Also with the chunk split between threads, which is only faster with
+	// as many free cores
+	for (const char *chunk_threads : {"1", "4"}) {
+		g_settings->set("mapgen_chunk_threads", chunk_threads);
+		const std::string suffix = std::string(chunk_threads) + "thread_";
+
+		MockMapgen mg_v7;
+		initMapgen(mg_v7, MAPGEN_V7, MGV7_MOUNTAINS | MGV7_RIDGES |
+			MGV7_FLOATLANDS | MGV7_CAVERNS);
+		bench(mg_v7, "v7_" + suffix, {
+			{ "surface", v3s16(-7, 0, 12) },
+			{ "mountains", v3s16(25, 10, 0) },
+			{ "sky", v3s16(25, 40, 0) },
+			{ "floatlands", v3s16(0, 80, -25) },
+			{ "deep", v3s16(-7, -100, 12) },
+		});
+
+		MockMapgen mg_carpathian;
+		initMapgen(mg_carpathian, MAPGEN_CARPATHIAN, MGCARPATHIAN_CAVERNS |
+			MGCARPATHIAN_RIVERS);
+		bench(mg_carpathian, "carpathian_" + suffix, {
+			{ "surface", v3s16(-7, 0, 12) },
+			{ "mountains", v3s16(-50, 10, -50) },
+			{ "sky", v3s16(-50, 40, -50) },
+			{ "deep", v3s16(-7, -100, 12) },
+		});
+	}
+	g_settings->remove("mapgen_chunk_threads");
+
+	// Stacks of chunks, which have the same 2D noise
+	for (const char *cache_size : {"0", "32"}) {
+		g_settings->set("mapgen_column_cache_size", cache_size);
+		MockMapgen mg_v7;
+		initMapgen(mg_v7, MAPGEN_V7, MGV7_MOUNTAINS | MGV7_RIDGES |
+			MGV7_FLOATLANDS | MGV7_CAVERNS);
+		s16 x = 0;
+		BENCHMARK(std::string("v7_stack_of_4_cache") + cache_size, i) {
+			// A new column every time
+			x += 5;
+			u64 hash = 0;
+			for (s16 y : {-12, -7, -2, 3})
+				hash ^= MockMapgen::hashNodes(mg_v7.makeChunk(v3s16(x, y, 0))->vmanip);
+			return hash;
+		};
+	}
+	g_settings->remove("mapgen_column_cache_size");
+
+	// Many decorations, which look at the same columns
+	MockMapgen mg_decorations;
+	mg_decorations.addDecorations(400);
+	initMapgen(mg_decorations, MAPGEN_V7, MGV7_MOUNTAINS | MGV7_RIDGES |
+		MGV7_CAVERNS);
+	bench(mg_decorations, "v7_400_decorations_", {
+		{ "surface", v3s16(-7, 0, 12) },
+		{ "water", v3s16(-30, 0, 30) },
+		{ "caves", v3s16(-7, -5, 12) },
+	});
+}
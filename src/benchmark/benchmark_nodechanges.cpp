@@ -0,0 +1,113 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "dummygamedef.h"
+#include "dummymap.h"
+#include "mapblock.h"
+#include "serialization.h"
+#include "network/networkpacket.h"
+#include "network/networkprotocol.h"
+#include "server/nodechanges.h"
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+// Area edited in one server step, e.g. by a WorldEdit command
+static const v3s16 edit_min(-10, -10, -10), edit_max(9, 9, 9);
+
+namespace {
+	struct SendStats {
+		size_t packets = 0;
+		size_t bytes = 0;
+	};
+}
+
+// One TOCLIENT_ADDNODE packet per node, like the server used to send
+static SendStats sendSingle(MapNode n)
+{
+	SendStats stats;
+	for (s16 z = edit_min.Z; z <= edit_max.Z; z++)
+	for (s16 y = edit_min.Y; y <= edit_max.Y; y++)
+	for (s16 x = edit_min.X; x <= edit_max.X; x++) {
+		NetworkPacket pkt(TOCLIENT_ADDNODE, 6 + 2 + 1 + 1 + 1);
+		pkt << v3s16(x, y, z) << n.param0 << n.param1 << n.param2 << (u8) 0;
+		stats.packets++;
+		stats.bytes += 2 + pkt.getSize();
+	}
+	return stats;
+}
+
+// Per block either a TOCLIENT_NODE_CHANGES or a TOCLIENT_BLOCKDATA packet
+static SendStats sendCoalesced(Map &map, u8 ver, MapNode n)
+{
+	std::unordered_map<v3s16, NodeChangeList> node_changes;
+	for (s16 z = edit_min.Z; z <= edit_max.Z; z++)
+	for (s16 y = edit_min.Y; y <= edit_max.Y; y++)
+	for (s16 x = edit_min.X; x <= edit_max.X; x++) {
+		v3s16 p(x, y, z);
+		v3s16 block_pos = getNodeBlockPos(p);
+		node_changes[block_pos].add(p - block_pos * MAP_BLOCKSIZE, n, false);
+	}
+
+	SendStats stats;
+	for (const auto &[block_pos, changes] : node_changes) {
+		MapBlock *block = map.getBlockNoCreateNoEx(block_pos);
+		std::ostringstream os(std::ios_base::binary);
+		block->serialize(os, ver, false, -1);
+		block->serializeNetworkSpecific(os);
+		const size_t block_size = 6 + static_cast<size_t>(os.tellp());
+
+		NetworkPacket pkt(TOCLIENT_NODE_CHANGES, changes.getPacketSize(ver));
+		changes.serialize(pkt, block_pos, ver);
+
+		stats.packets++;
+		stats.bytes += 2 + std::min<size_t>(pkt.getSize(), block_size);
+	}
+	return stats;
+}
+
+TEST_CASE("benchmark_nodechanges")
+{
+	DummyGameDef gamedef;
+	NodeDefManager *ndef = gamedef.getWritableNodeDefManager();
+
+	content_t content_stone;
+	{
+		ContentFeatures f;
+		f.name = "stone";
+		content_stone = ndef->set(f.name, f);
+	}
+
+	v3s16 bpmin = getNodeBlockPos(edit_min), bpmax = getNodeBlockPos(edit_max);
+	DummyMap map(&gamedef, bpmin, bpmax);
+	map.fill(bpmin, bpmax, MapNode(CONTENT_AIR));
+
+	// Apply the edit, so that block sizes reflect the result
+	const MapNode n(content_stone);
+	for (s16 z = edit_min.Z; z <= edit_max.Z; z++)
+	for (s16 y = edit_min.Y; y <= edit_max.Y; y++)
+	for (s16 x = edit_min.X; x <= edit_max.X; x++)
+		map.setNode(v3s16(x, y, z), n);
+
+	const u8 ver = SER_FMT_VER_HIGHEST_WRITE;
+	{
+		SendStats single = sendSingle(n);
+		SendStats coalesced = sendCoalesced(map, ver, n);
+		std::cout << "20x20x20 edit, per player: single node packets: "
+			<< single.packets << " packets, " << single.bytes << " bytes; "
+			<< "coalesced: " << coalesced.packets << " packets, "
+			<< coalesced.bytes << " bytes" << std::endl;
+		CHECK(coalesced.packets < single.packets);
+		CHECK(coalesced.bytes < single.bytes);
+	}
+
+	BENCHMARK("single_node_packets_20x20x20") {
+		return sendSingle(n).bytes;
+	};
+
+	BENCHMARK("coalesced_node_changes_20x20x20") {
+		return sendCoalesced(map, ver, n).bytes;
+	};
+}
@@ -0,0 +1,111 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "dummygamedef.h"
+#include "filesys.h"
+#include "nodedef.h"
+#include "server.h"
+#include "voxel.h"
+#include "script/cpp_api/s_base.h"
+#include "script/lua_api/l_env.h"
+#include "script/lua_api/l_settings.h"
+#include "script/lua_api/l_util.h"
+
+namespace {
+	class BenchScriptApi : virtual public ScriptApiBase {
+	public:
+		BenchScriptApi() : ScriptApiBase(ScriptingType::Async) {}
+		using ScriptApiBase::getStack;
+
+		// Loads builtin, which is needed to push vectors
+		void init()
+		{
+			lua_State *L = getStack();
+			lua_getglobal(L, "core");
+			int top = lua_gettop(L);
+			lua_pushstring(L, "async");
+			lua_setglobal(L, "INIT");
+			LuaSettings::Register(L);
+			ModApiUtil::InitializeAsync(L, top);
+			lua_pop(L, 1);
+
+			loadMod(Server::getBuiltinLuaPath() + DIR_DELIM + "init.lua",
+					BUILTIN_MOD_NAME);
+		}
+	};
+
+	class BenchEnvApi : public ModApiEnvBase {
+	public:
+		using ModApiEnvBase::RawNodeFilter;
+		using ModApiEnvBase::findNodesInVManip;
+		using ModApiEnvBase::findNodesInVManipRaw;
+	};
+}
+
+// Scan of 64³ nodes for 5 out of 8 node types
+TEST_CASE("benchmark_nodequery")
+{
+	DummyGameDef gamedef;
+	NodeDefManager *ndef = gamedef.getWritableNodeDefManager();
+
+	std::vector<content_t> ids;
+	for (int i = 0; i < 8; i++) {
+		ContentFeatures f;
+		f.name = "node" + std::to_string(i);
+		ids.push_back(ndef->set(f.name, f));
+	}
+	const std::vector<content_t> filter(ids.begin(), ids.begin() + 5);
+
+	BenchEnvApi::RawNodeFilter raw_filter;
+	raw_filter.ndef = ndef;
+	for (content_t c : filter) {
+		if (c >= raw_filter.contents.size())
+			raw_filter.contents.resize(c + 1, false);
+		raw_filter.contents[c] = true;
+	}
+
+	// Mostly air, with the node types scattered around
+	const VoxelArea area(v3s16(0), v3s16(63));
+	VoxelManipulator vm;
+	vm.addArea(area);
+	for (u32 i = 0; i < area.getVolume(); i++) {
+		u32 r = (i * 2654435761U) >> 24;
+		vm.m_data[i] = MapNode(r < 32 ? ids[r % ids.size()] : CONTENT_AIR);
+	}
+
+	BenchScriptApi script;
+	script.init();
+	lua_State *L = script.getStack();
+	const int top = lua_gettop(L);
+
+	BENCHMARK("find_nodes_in_area", i) {
+		BenchEnvApi::findNodesInVManip(L, ndef, &vm, area, filter, false);
+		size_t found = lua_objlen(L, -1);
+		lua_settop(L, top);
+		return found;
+	};
+
+	BENCHMARK("find_nodes_in_area_grouped", i) {
+		BenchEnvApi::findNodesInVManip(L, ndef, &vm, area, filter, true);
+		lua_settop(L, top);
+		return i;
+	};
+
+	BENCHMARK("find_nodes_in_area_raw", i) {
+		BenchEnvApi::findNodesInVManipRaw(L, &vm, area, raw_filter);
+		size_t found = lua_objlen(L, -1);
+		lua_settop(L, top);
+		return found;
+	};
+
+	raw_filter.check_param2 = true;
+	raw_filter.param2_max = 3;
+	BENCHMARK("find_nodes_in_area_raw_param2", i) {
+		BenchEnvApi::findNodesInVManipRaw(L, &vm, area, raw_filter);
+		size_t found = lua_objlen(L, -1);
+		lua_settop(L, top);
+		return found;
+	};
+}
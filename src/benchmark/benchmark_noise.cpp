@@ -0,0 +1,35 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "noise.h"
+
+// Noise maps of a mapchunk, as mapgens calculate them
+TEST_CASE("benchmark_noise")
+{
+	for (u16 octaves : {1, 3, 5, 8}) {
+		const std::string suffix = "_" + std::to_string(octaves) + "oct";
+
+		NoiseParams np(0, 1, v3f(250, 250, 250), 5934, octaves, 0.6f, 2.0f);
+		Noise noise_2d(&np, 42, 80, 80);
+		float x = 0;
+		BENCHMARK("noiseMap2D_80x80" + suffix, i) {
+			x += 80;
+			return noise_2d.noiseMap2D(x, 0)[i % (80 * 80)];
+		};
+
+		Noise noise_3d(&np, 42, 80, 80, 80);
+		BENCHMARK("noiseMap3D_80x80x80" + suffix, i) {
+			x += 80;
+			return noise_3d.noiseMap3D(x, 0, 0)[i % (80 * 80 * 80)];
+		};
+
+		np.flags = NOISE_FLAG_EASED;
+		Noise noise_3d_eased(&np, 42, 80, 80, 80);
+		BENCHMARK("noiseMap3D_80x80x80_eased" + suffix, i) {
+			x += 80;
+			return noise_3d_eased.noiseMap3D(x, 0, 0)[i % (80 * 80 * 80)];
+		};
+	}
+}
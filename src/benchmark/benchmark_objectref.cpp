@@ -0,0 +1,102 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "filesys.h"
+#include "server.h"
+#include "script/cpp_api/s_base.h"
+#include "script/lua_api/l_object.h"
+#include "script/lua_api/l_settings.h"
+#include "script/lua_api/l_util.h"
+#include "server/serveractiveobject.h"
+
+namespace {
+	class BenchScriptApi : virtual public ScriptApiBase {
+	public:
+		BenchScriptApi() : ScriptApiBase(ScriptingType::Async) {}
+		using ScriptApiBase::getStack;
+
+		// Loads builtin, which is needed to push vectors
+		void init()
+		{
+			lua_State *L = getStack();
+			lua_getglobal(L, "core");
+			int top = lua_gettop(L);
+			lua_pushstring(L, "async");
+			lua_setglobal(L, "INIT");
+			LuaSettings::Register(L);
+			ModApiUtil::InitializeAsync(L, top);
+			lua_pop(L, 1);
+
+			loadMod(Server::getBuiltinLuaPath() + DIR_DELIM + "init.lua",
+					BUILTIN_MOD_NAME);
+			ObjectRef::Register(L);
+		}
+	};
+
+	class TestObject : public ServerActiveObject {
+	public:
+		TestObject(v3f pos) : ServerActiveObject(nullptr, pos) {}
+
+		ActiveObjectType getType() const { return ACTIVEOBJECT_TYPE_TEST; }
+		bool getCollisionBox(aabb3f *toset) const { return false; }
+		bool getSelectionBox(aabb3f *toset) const { return false; }
+		bool collideWithObjects() const { return false; }
+		std::string getGUID() const { return ""; }
+	};
+
+	// Sums up the positions, so that the calls can not be skipped
+	const char *loop_get_pos = R"(
+		local obj = ...
+		local sum = 0
+		for i = 1, 1000000 do
+			local pos = obj:get_pos()
+			sum = sum + pos.x + pos.y + pos.z
+		end
+		return sum
+	)";
+	const char *loop_get_pos_xyz = R"(
+		local obj = ...
+		local sum = 0
+		for i = 1, 1000000 do
+			local x, y, z = obj:get_pos_xyz()
+			sum = sum + x + y + z
+		end
+		return sum
+	)";
+}
+
+// 1M calls from Lua
+TEST_CASE("benchmark_objectref")
+{
+	BenchScriptApi script;
+	script.init();
+	lua_State *L = script.getStack();
+
+	TestObject obj(v3f(10, 20, 30) * BS);
+	ObjectRef::create(L, &obj);
+	const int objref = lua_gettop(L);
+
+	auto run = [&](const char *code) {
+		REQUIRE(luaL_loadstring(L, code) == 0);
+		lua_pushvalue(L, objref);
+		REQUIRE(lua_pcall(L, 1, 1, 0) == 0);
+		lua_Number sum = lua_tonumber(L, -1);
+		lua_pop(L, 1);
+		return sum;
+	};
+
+	REQUIRE(run(loop_get_pos) == run(loop_get_pos_xyz));
+
+	BENCHMARK("get_pos_1M", i) {
+		return run(loop_get_pos);
+	};
+
+	BENCHMARK("get_pos_xyz_1M", i) {
+		return run(loop_get_pos_xyz);
+	};
+
+	lua_pushvalue(L, objref);
+	ObjectRef::set_null(L, &obj);
+}
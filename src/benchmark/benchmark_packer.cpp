@@ -0,0 +1,74 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "script/common/c_packer.h"
+#include "script/cpp_api/s_base.h"
+#include "script/lua_api/l_vmanip.h"
+#include <memory>
+
+namespace {
+	class BenchScriptApi : virtual public ScriptApiBase {
+	public:
+		BenchScriptApi() : ScriptApiBase(ScriptingType::Async) {}
+		using ScriptApiBase::getStack;
+	};
+}
+
+// Packs the value on top of the stack and unpacks it again, as when passing
+// it to an async job
+static void roundtrip(lua_State *L)
+{
+	std::unique_ptr<PackedValue> packed(script_pack(L, -1));
+	script_unpack(L, packed.get());
+	lua_pop(L, 1);
+}
+
+#define BENCH_PACK(_label, _push) \
+	BENCHMARK_ADVANCED(_label)(Catch::Benchmark::Chronometer meter) { \
+		_push; \
+		meter.measure([&] { roundtrip(L); }); \
+		lua_pop(L, 1); \
+	};
+
+static void push_string(lua_State *L, size_t size)
+{
+	std::string s(size, 'x');
+	lua_pushlstring(L, s.data(), s.size());
+}
+
+static void push_buffer(lua_State *L, size_t size)
+{
+	lua_getglobal(L, "VoxelBuffer");
+	lua_pushstring(L, "u8");
+	lua_pushinteger(L, size);
+	lua_call(L, 2, 1);
+}
+
+// Array of numbers taking `size` bytes as doubles
+static void push_table(lua_State *L, size_t size)
+{
+	const int n = size / sizeof(lua_Number);
+	lua_createtable(L, n, 0);
+	for (int i = 1; i <= n; i++) {
+		lua_pushinteger(L, i);
+		lua_rawseti(L, -2, i);
+	}
+}
+
+TEST_CASE("benchmark_packer")
+{
+	BenchScriptApi script;
+	lua_State *L = script.getStack();
+	LuaVoxelBuffer::Register(L);
+
+	constexpr size_t MB = 1024 * 1024;
+
+	BENCH_PACK("string_1MB", push_string(L, MB))
+	BENCH_PACK("string_16MB", push_string(L, 16 * MB))
+	// (a 16MB table takes about a second per round trip)
+	BENCH_PACK("table_1MB", push_table(L, MB))
+	BENCH_PACK("voxelbuffer_1MB", push_buffer(L, MB))
+	BENCH_PACK("voxelbuffer_16MB", push_buffer(L, 16 * MB))
+}
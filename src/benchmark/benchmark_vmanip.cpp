@@ -0,0 +1,127 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "map.h"
+#include "script/cpp_api/s_base.h"
+#include "script/lua_api/l_vmanip.h"
+
+namespace {
+	class BenchScriptApi : virtual public ScriptApiBase {
+	public:
+		BenchScriptApi() : ScriptApiBase(ScriptingType::Async) {}
+		using ScriptApiBase::getStack;
+	};
+
+	// VoxelManip without a map
+	class BenchVManip : public MMVManip {
+	public:
+		BenchVManip(const VoxelArea &area)
+		{
+			addArea(area);
+			for (u32 i = 0; i < area.getVolume(); i++)
+				m_data[i] = MapNode(i % 7 ? CONTENT_AIR : 10 + i % 3, 0, i % 4);
+			clearFlags(area, VOXELFLAG_NO_DATA);
+		}
+	};
+}
+
+// Compiles `code` into a function, taking `vm` and returning nothing
+static int compile(lua_State *L, const char *code)
+{
+	if (luaL_loadstring(L, code) != 0)
+		throw LuaError(lua_tostring(L, -1));
+	return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+static void call(lua_State *L, int func_ref, int vm_ref)
+{
+	lua_rawgeti(L, LUA_REGISTRYINDEX, func_ref);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, vm_ref);
+	if (lua_pcall(L, 1, 0, 0) != 0)
+		throw LuaError(lua_tostring(L, -1));
+}
+
+#define BENCH_LUA(_label, _code) \
+	BENCHMARK_ADVANCED(_label)(Catch::Benchmark::Chronometer meter) { \
+		int func = compile(L, _code); \
+		call(L, func, vm_ref); /* warm up, e.g. to allocate the buffers */ \
+		meter.measure([&] { call(L, func, vm_ref); }); \
+		luaL_unref(L, LUA_REGISTRYINDEX, func); \
+	};
+
+// Data of a mapchunk including the shell (80³ nodes)
+TEST_CASE("benchmark_vmanip")
+{
+	BenchScriptApi script;
+	lua_State *L = script.getStack();
+	LuaVoxelManip::Register(L);
+	LuaVoxelBuffer::Register(L);
+
+	const VoxelArea area(v3s16(-32), v3s16(47));
+	LuaVoxelManip::create(L, new BenchVManip(area), false);
+	const int vm_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	// Copying in and out only
+
+	BENCH_LUA("get_set_data_table",
+		"local vm = ...\n"
+		"data = vm:get_data(data)\n"
+		"vm:set_data(data)\n")
+
+	BENCH_LUA("get_set_data_buffer",
+		"local vm = ...\n"
+		"data_buf = data_buf or VoxelBuffer('u16')\n"
+		"vm:get_data(data_buf)\n"
+		"vm:set_data(data_buf)\n")
+
+	BENCH_LUA("get_set_param2_data_table",
+		"local vm = ...\n"
+		"param2 = vm:get_param2_data(param2)\n"
+		"vm:set_param2_data(param2)\n")
+
+	BENCH_LUA("get_set_param2_data_buffer",
+		"local vm = ...\n"
+		"param2_buf = param2_buf or VoxelBuffer('u8')\n"
+		"vm:get_param2_data(param2_buf)\n"
+		"vm:set_param2_data(param2_buf)\n")
+
+	// Replacing one content by another, as a mapgen mod would
+
+	BENCH_LUA("replace_content_table",
+		"local vm = ...\n"
+		"data = vm:get_data(data)\n"
+		"for i = 1, #data do\n"
+		"	if data[i] == 10 then data[i] = 11 elseif data[i] == 11 then data[i] = 10 end\n"
+		"end\n"
+		"vm:set_data(data)\n")
+
+	BENCH_LUA("replace_content_buffer",
+		"local vm = ...\n"
+		"data_buf = data_buf or VoxelBuffer('u16')\n"
+		"local data = data_buf\n"
+		"vm:get_data(data)\n"
+		"for i = 1, #data do\n"
+		"	if data[i] == 10 then data[i] = 11 elseif data[i] == 11 then data[i] = 10 end\n"
+		"end\n"
+		"vm:set_data(data)\n")
+
+	lua_getglobal(L, "jit");
+	const bool have_jit = !lua_isnil(L, -1);
+	lua_pop(L, 1);
+	if (have_jit) {
+		BENCH_LUA("replace_content_buffer_ffi",
+			"local vm = ...\n"
+			"local ffi = require('ffi')\n"
+			"data_buf = data_buf or VoxelBuffer('u16')\n"
+			"vm:get_data(data_buf)\n"
+			"local data = ffi.cast('uint16_t*', data_buf:get_pointer())\n"
+			"for i = 0, #data_buf - 1 do\n"
+			"	if data[i] == 10 then data[i] = 11 elseif data[i] == 11 then data[i] = 10 end\n"
+			"end\n"
+			"vm:set_data(data_buf)\n")
+	}
+
+	luaL_unref(L, LUA_REGISTRYINDEX, vm_ref);
+}
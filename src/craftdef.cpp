@@ -16,6 +16,9 @@
 #include "util/string.h"
 #include "util/numeric.h"
 #include "util/strfnd.h"
+#include "threading/mutex_auto_lock.h"
+#include "threading/parallel.h"
+#include "util/container.h"
 
 inline bool isGroupRecipeStr(const std::string &rec_name)
 {
@@ -31,6 +34,22 @@ static bool hasGroupItem(const std::vector<std::string> &recipe)
 	return false;
 }
 
+// Returns the first item name of a recipe, or its first group if there is
+// no item name
+static std::string getRequiredRecipeName(const std::vector<std::string> &recipe_names)
+{
+	const std::string *group = nullptr;
+	for (const std::string &name : recipe_names) {
+		if (name.empty())
+			continue;
+		if (!isGroupRecipeStr(name))
+			return name;
+		if (!group)
+			group = &name;
+	}
+	return group ? *group : "";
+}
+
 inline u64 getHashForString(const std::string &recipe_str)
 {
 	/*errorstream << "Hashing craft string  \"" << recipe_str << '"';*/
@@ -454,6 +473,11 @@ void CraftDefinitionShaped::initHash(IGameDef *gamedef)
 		hash_type = CRAFT_HASH_TYPE_ITEM_NAMES;
 }
 
+std::string CraftDefinitionShaped::getRequiredName() const
+{
+	return getRequiredRecipeName(recipe_names);
+}
+
 std::string CraftDefinitionShaped::dump() const
 {
 	std::ostringstream os(std::ios::binary);
@@ -706,6 +730,11 @@ void CraftDefinitionShapeless::initHash(IGameDef *gamedef)
 		hash_type = CRAFT_HASH_TYPE_ITEM_NAMES;
 }
 
+std::string CraftDefinitionShapeless::getRequiredName() const
+{
+	return getRequiredRecipeName(recipe_names);
+}
+
 std::string CraftDefinitionShapeless::dump() const
 {
 	std::ostringstream os(std::ios::binary);
@@ -909,6 +938,11 @@ void CraftDefinitionCooking::initHash(IGameDef *gamedef)
 		hash_type = CRAFT_HASH_TYPE_ITEM_NAMES;
 }
 
+std::string CraftDefinitionCooking::getRequiredName() const
+{
+	return recipe_name;
+}
+
 std::string CraftDefinitionCooking::dump() const
 {
 	std::ostringstream os(std::ios::binary);
@@ -1012,6 +1046,11 @@ void CraftDefinitionFuel::initHash(IGameDef *gamedef)
 		hash_type = CRAFT_HASH_TYPE_ITEM_NAMES;
 }
 
+std::string CraftDefinitionFuel::getRequiredName() const
+{
+	return recipe_name;
+}
+
 std::string CraftDefinitionFuel::dump() const
 {
 	std::ostringstream os(std::ios::binary);
@@ -1025,12 +1064,81 @@ std::string CraftDefinitionFuel::dump() const
 	Craft definition manager
 */
 
+/*
+	Index of the recipes of one CRAFT_HASH_TYPE_COUNT bucket by a name that
+	every matching input contains (see CraftDefinition::getRequiredName),
+	so that only the recipes that can match need to be checked.
+	Recipes are referred to by their position in the bucket.
+*/
+struct CraftCountIndex
+{
+	std::unordered_map<std::string, std::vector<u32>> by_item;
+	// By the first group of the group string
+	std::unordered_map<std::string, std::vector<u32>> by_group;
+	// Recipes without a required name
+	std::vector<u32> unindexed;
+	// Recipes that don't only check the item names
+	std::vector<u32> names_not_only;
+
+	void add(u32 i, const CraftDefinition *def)
+	{
+		if (!def->checksNamesOnly()) {
+			names_not_only.push_back(i);
+			return;
+		}
+		std::string name = def->getRequiredName();
+		if (name.empty()) {
+			unindexed.push_back(i);
+		} else if (isGroupRecipeStr(name)) {
+			Strfnd f(name.substr(6));
+			by_group[f.next(",")].push_back(i);
+		} else {
+			by_item[name].push_back(i);
+		}
+	}
+
+	// Returns the positions of the recipes that can match, from back to
+	// front like the bucket is walked
+	std::vector<u32> getCandidates(const std::vector<std::string> &input_names,
+			bool names_only, IItemDefManager *idef) const
+	{
+		if (!names_only)
+			return std::vector<u32>(names_not_only.rbegin(), names_not_only.rend());
+
+		std::vector<u32> result(unindexed);
+		auto add_from = [&] (const std::unordered_map<std::string, std::vector<u32>> &map,
+				const std::string &key) {
+			auto it = map.find(key);
+			if (it != map.end())
+				result.insert(result.end(), it->second.begin(), it->second.end());
+		};
+		// The names are sorted, so duplicates are next to each other
+		for (size_t i = 0; i < input_names.size(); i++) {
+			const std::string &name = input_names[i];
+			if (name.empty() || (i > 0 && name == input_names[i - 1]))
+				continue;
+			add_from(by_item, name);
+			if (by_group.empty() || !idef->isKnown(name))
+				continue;
+			for (const auto &group : idef->get(name).groups) {
+				if (group.second != 0)
+					add_from(by_group, group.first);
+			}
+		}
+		std::sort(result.begin(), result.end(), std::greater<u32>());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	}
+};
+
 class CCraftDefManager: public IWritableCraftDefManager
 {
 public:
-	CCraftDefManager()
+	CCraftDefManager() :
+		m_result_cache(RESULT_CACHE_SIZE, resultCacheMiss, this)
 	{
 		m_craft_defs.resize(craft_hash_type_max + 1);
+		clearNamesNotOnly();
 	}
 
 	virtual ~CCraftDefManager()
@@ -1045,57 +1153,28 @@ class CCraftDefManager: public IWritableCraftDefManager
 		if (input.empty())
 			return false;
 
-		std::vector<std::string> input_names;
-		input_names = craftGetItemNames(input.items, gamedef);
-		std::sort(input_names.begin(), input_names.end());
-
-		// Try hash types with increasing collision rate
-		// while remembering the latest, highest priority recipe.
-		CraftDefinition::RecipePriority priority_best =
-			CraftDefinition::PRIORITY_NO_RECIPE;
-		CraftDefinition *def_best = nullptr;
-		for (int type = 0; type <= craft_hash_type_max; type++) {
-			u64 hash = getHashForGrid((CraftHashType) type, input_names);
-
-			/*errorstream << "Checking type " << type << " with hash " << hash << std::endl;*/
-
-			// We'd like to do "const [...] hash_collisions = m_craft_defs[type][hash];"
-			// but that doesn't compile for some reason. This does.
-			auto col_iter = (m_craft_defs[type]).find(hash);
-
-			if (col_iter == (m_craft_defs[type]).end())
-				continue;
-
-			const std::vector<CraftDefinition*> &hash_collisions = col_iter->second;
-			// Walk crafting definitions from back to front, so that later
-			// definitions can override earlier ones.
-			for (std::vector<CraftDefinition*>::size_type
-					i = hash_collisions.size(); i > 0; i--) {
-				CraftDefinition *def = hash_collisions[i - 1];
-
-				/*errorstream << "Checking " << input.dump() << std::endl
-					<< " against " << def->dump() << std::endl;*/
-
-				CraftDefinition::RecipePriority priority = def->getPriority();
-				if (priority > priority_best
-						&& def->check(input, gamedef)) {
-					// Check if the crafted node/item exists
-					CraftOutput out = def->getOutput(input, gamedef);
-					ItemStack is;
-					is.deSerialize(out.item, gamedef->idef());
-					if (!is.isKnown(gamedef->idef())) {
-						infostream << "trying to craft non-existent "
-							<< out.item << ", ignoring recipe" << std::endl;
-						continue;
-					}
-
-					output = out;
-					priority_best = priority;
-					def_best = def;
-				}
-			}
+		// The best of the recipes that only check the item names is cached
+		CraftDefinition *def_best;
+		{
+			MutexAutoLock lock(m_cache_mutex);
+			m_cache_miss_input = &input;
+			m_cache_miss_gamedef = gamedef;
+			def_best = *m_result_cache.lookupCache(getResultCacheKey(input));
+		}
+		if (def_best)
+			output = def_best->getOutput(input, gamedef);
+
+		// The others are checked every time. This is only tool repair, which
+		// has the lowest priority, so it can't tie with a cached recipe.
+		CraftOutput output_other;
+		CraftDefinition *def_other = findRecipe(input, false, output_other, gamedef);
+		if (def_other && (!def_best ||
+				def_other->getPriority() > def_best->getPriority())) {
+			output = output_other;
+			def_best = def_other;
 		}
-		if (priority_best == CraftDefinition::PRIORITY_NO_RECIPE)
+
+		if (!def_best)
 			return false;
 		if (decrementInput)
 			def_best->decrementInput(input, output_replacement, gamedef);
@@ -1141,6 +1220,7 @@ class CCraftDefManager: public IWritableCraftDefManager
 			delete def;
 		}
 		m_output_craft_definitions.erase(to_clear);
+		invalidateResultCache();
 		return true;
 	}
 
@@ -1173,6 +1253,7 @@ class CCraftDefManager: public IWritableCraftDefManager
 					return defs_to_remove.find(def) != defs_to_remove.end();
 				}), outdefs.end());
 			}
+			invalidateResultCache();
 		}
 
 		return !defs_to_remove.empty();
@@ -1201,6 +1282,9 @@ class CCraftDefManager: public IWritableCraftDefManager
 		TRACESTREAM(<< "registerCraft: registering craft definition: "
 				<< def->dump() << std::endl);
 		m_craft_defs[(int) CRAFT_HASH_TYPE_UNHASHED][0].push_back(def);
+		if (!def->checksNamesOnly())
+			m_has_names_not_only[(int) CRAFT_HASH_TYPE_UNHASHED] = true;
+		invalidateResultCache();
 
 		CraftInput input;
 		std::string output_name = craftGetItemName(
@@ -1219,28 +1303,170 @@ class CCraftDefManager: public IWritableCraftDefManager
 			m_craft_defs[type].clear();
 		}
 		m_output_craft_definitions.clear();
+		m_count_index.clear();
+		clearNamesNotOnly();
+		invalidateResultCache();
 	}
 	virtual void initHashes(IGameDef *gamedef)
 	{
 		// Move the CraftDefs from the unhashed layer into layers higher up.
 		std::vector<CraftDefinition *> &unhashed =
 			m_craft_defs[(int) CRAFT_HASH_TYPE_UNHASHED][0];
-		for (auto def : unhashed) {
-			// Initialize and get the definition's hash
-			def->initHash(gamedef);
-			CraftHashType type = def->getHashType();
-			u64 hash = def->getHash(type);
-
-			// Enter the definition
-			m_craft_defs[type][hash].push_back(def);
+
+		// Initialize and get the definitions' hashes. This only reads the
+		// item definitions, so it can be done in parallel.
+		std::vector<u64> hashes(unhashed.size());
+		parallel_for(unhashed.size(), 512, [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				CraftDefinition *def = unhashed[i];
+				def->initHash(gamedef);
+				hashes[i] = def->getHash(def->getHashType());
+			}
+		});
+
+		// Enter the definitions, in order as that decides their priority
+		for (size_t i = 0; i < unhashed.size(); i++) {
+			CraftDefinition *def = unhashed[i];
+			m_craft_defs[def->getHashType()][hashes[i]].push_back(def);
 		}
 		unhashed.clear();
+
+		// Index the group recipes
+		clearNamesNotOnly();
+		m_count_index.clear();
+		for (int type = 0; type <= craft_hash_type_max; type++) {
+			for (const auto &it : m_craft_defs[type]) {
+				for (size_t i = 0; i < it.second.size(); i++) {
+					if (!it.second[i]->checksNamesOnly())
+						m_has_names_not_only[type] = true;
+				}
+			}
+		}
+		for (const auto &it : m_craft_defs[(int) CRAFT_HASH_TYPE_COUNT]) {
+			CraftCountIndex &index = m_count_index[it.first];
+			for (size_t i = 0; i < it.second.size(); i++)
+				index.add(i, it.second[i]);
+		}
+		invalidateResultCache();
 	}
 private:
+	// Grids whose best recipe is cached
+	static constexpr size_t RESULT_CACHE_SIZE = 256;
+
+	// Finds the latest recipe of the highest priority that matches the input,
+	// out of the recipes that only check the item names (or the others)
+	CraftDefinition *findRecipe(const CraftInput &input, bool names_only,
+			CraftOutput &output, IGameDef *gamedef) const
+	{
+		std::vector<std::string> input_names;
+		input_names = craftGetItemNames(input.items, gamedef);
+		std::sort(input_names.begin(), input_names.end());
+
+		CraftDefinition::RecipePriority priority_best =
+			CraftDefinition::PRIORITY_NO_RECIPE;
+		CraftDefinition *def_best = nullptr;
+		auto check_recipe = [&] (CraftDefinition *def) {
+			if (def->checksNamesOnly() != names_only)
+				return;
+
+			CraftDefinition::RecipePriority priority = def->getPriority();
+			if (priority > priority_best
+					&& def->check(input, gamedef)) {
+				// Check if the crafted node/item exists
+				CraftOutput out = def->getOutput(input, gamedef);
+				ItemStack is;
+				is.deSerialize(out.item, gamedef->idef());
+				if (!is.isKnown(gamedef->idef())) {
+					infostream << "trying to craft non-existent "
+						<< out.item << ", ignoring recipe" << std::endl;
+					return;
+				}
+
+				output = out;
+				priority_best = priority;
+				def_best = def;
+			}
+		};
+
+		// Try hash types with increasing collision rate
+		// while remembering the latest, highest priority recipe.
+		for (int type = 0; type <= craft_hash_type_max; type++) {
+			if (!names_only && !m_has_names_not_only[type])
+				continue;
+
+			u64 hash = getHashForGrid((CraftHashType) type, input_names);
+			auto col_iter = m_craft_defs[type].find(hash);
+			if (col_iter == m_craft_defs[type].end())
+				continue;
+			const std::vector<CraftDefinition*> &hash_collisions = col_iter->second;
+
+			if (type == (int) CRAFT_HASH_TYPE_COUNT) {
+				auto index_iter = m_count_index.find(hash);
+				if (index_iter != m_count_index.end()) {
+					for (u32 i : index_iter->second.getCandidates(input_names,
+							names_only, gamedef->idef()))
+						check_recipe(hash_collisions[i]);
+					continue;
+				}
+			}
+
+			// Walk crafting definitions from back to front, so that later
+			// definitions can override earlier ones.
+			for (std::vector<CraftDefinition*>::size_type
+					i = hash_collisions.size(); i > 0; i--)
+				check_recipe(hash_collisions[i - 1]);
+		}
+		return def_best;
+	}
+
+	static std::string getResultCacheKey(const CraftInput &input)
+	{
+		std::string key;
+		key.push_back((char) input.method);
+		key.append(std::to_string(input.width));
+		for (const auto &item : input.items) {
+			key.push_back('\n');
+			key.append(item.name);
+		}
+		return key;
+	}
+
+	static void resultCacheMiss(void *data, const std::string &key,
+			CraftDefinition **dest)
+	{
+		auto *self = static_cast<CCraftDefManager *>(data);
+		CraftOutput output;
+		*dest = self->findRecipe(*self->m_cache_miss_input, true, output,
+				self->m_cache_miss_gamedef);
+	}
+
+	void invalidateResultCache()
+	{
+		MutexAutoLock lock(m_cache_mutex);
+		m_result_cache.invalidate();
+	}
+
+	void clearNamesNotOnly()
+	{
+		for (bool &b : m_has_names_not_only)
+			b = false;
+	}
+
 	std::vector<std::unordered_map<u64, std::vector<CraftDefinition*> > >
 		m_craft_defs;
 	std::unordered_map<std::string, std::vector<CraftDefinition*> >
 		m_output_craft_definitions;
+	// Index of the CRAFT_HASH_TYPE_COUNT buckets, by hash
+	std::unordered_map<u64, CraftCountIndex> m_count_index;
+	// Whether a hash type has recipes that don't only check the item names
+	bool m_has_names_not_only[craft_hash_type_max + 1];
+
+	mutable std::mutex m_cache_mutex;
+	// Best recipe that only checks the item names, by input grid
+	mutable LRUCache<std::string, CraftDefinition *> m_result_cache;
+	// Input of the lookup in progress, for resultCacheMiss
+	mutable const CraftInput *m_cache_miss_input = nullptr;
+	mutable IGameDef *m_cache_miss_gamedef = nullptr;
 };
 
 IWritableCraftDefManager* createCraftDefManager()
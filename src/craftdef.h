@@ -162,6 +162,15 @@ class CraftDefinition
 	// to be called after all mods are loaded, so that we catch all aliases
 	virtual void initHash(IGameDef *gamedef) = 0;
 
+	// Returns a name that every input matching this recipe contains, either
+	// an item name or a group string ("group:a,b"), or "" if there is none.
+	// Only valid after initHash.
+	virtual std::string getRequiredName() const { return ""; }
+
+	// Whether check() only depends on the method, width and item names of
+	// the input, so that its result can be cached
+	virtual bool checksNamesOnly() const { return true; }
+
 	virtual std::string dump() const=0;
 
 protected:
@@ -198,6 +207,8 @@ class CraftDefinitionShaped: public CraftDefinition
 
 	virtual void initHash(IGameDef *gamedef);
 
+	virtual std::string getRequiredName() const;
+
 	virtual std::string dump() const;
 
 private:
@@ -242,6 +253,8 @@ class CraftDefinitionShapeless: public CraftDefinition
 
 	virtual void initHash(IGameDef *gamedef);
 
+	virtual std::string getRequiredName() const;
+
 	virtual std::string dump() const;
 
 private:
@@ -285,6 +298,9 @@ class CraftDefinitionToolRepair: public CraftDefinition
 		hash_type = CRAFT_HASH_TYPE_COUNT;
 	}
 
+	// The result depends on the count and wear of the tools
+	virtual bool checksNamesOnly() const { return false; }
+
 	virtual std::string dump() const;
 
 private:
@@ -323,6 +339,8 @@ class CraftDefinitionCooking: public CraftDefinition
 
 	virtual void initHash(IGameDef *gamedef);
 
+	virtual std::string getRequiredName() const;
+
 	virtual std::string dump() const;
 
 private:
@@ -366,6 +384,8 @@ class CraftDefinitionFuel: public CraftDefinition
 
 	virtual void initHash(IGameDef *gamedef);
 
+	virtual std::string getRequiredName() const;
+
 	virtual std::string dump() const;
 
 private:
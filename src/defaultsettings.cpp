@@ -437,11 +437,13 @@ void set_default_settings()
 	settings->setDefault("enable_ipv6", "true");
 	settings->setDefault("ipv6_server", "true");
 	settings->setDefault("max_packets_per_iteration", "1024");
+	settings->setDefault("packet_capture_file", "");
 	settings->setDefault("port", "30000");
 	settings->setDefault("strict_protocol_version_checking", "false");
 	settings->setDefault("protocol_version_min", "1");
 	settings->setDefault("player_transfer_distance", "0");
 	settings->setDefault("max_simultaneous_block_sends_per_client", "40");
+	settings->setDefault("adaptive_block_send_window", "true");
 
 	settings->setDefault("motd", "");
 	settings->setDefault("max_users", "15");
@@ -466,6 +468,7 @@ void set_default_settings()
 	settings->setDefault("profiler_print_interval", "0");
 	settings->setDefault("active_object_send_range_blocks", "8");
 	settings->setDefault("active_block_range", "4");
+	settings->setDefault("async_map_access", "true");
 	//settings->setDefault("max_simultaneous_block_sends_per_client", "1");
 	// This causes frametime jitter on client side, or does it?
 	settings->setDefault("max_block_send_distance", "12");
@@ -501,9 +504,12 @@ void set_default_settings()
 	settings->setDefault("emergequeue_limit_diskonly", "128");
 	settings->setDefault("emergequeue_limit_generate", "128");
 	settings->setDefault("num_emerge_threads", "0");
+	settings->setDefault("mapgen_chunk_threads", "0");
+	settings->setDefault("mapgen_column_cache_size", "32");
 	settings->setDefault("secure.enable_security", "true");
 	settings->setDefault("secure.trusted_mods", "");
 	settings->setDefault("secure.http_mods", "");
+	settings->setDefault("lua_chunk_cache", "true");
 
 	// Physics
 	settings->setDefault("movement_acceleration_default", "3");
@@ -27,6 +27,7 @@
 #include "script/common/c_types.h" // LuaError
 #include "server.h"
 #include "settings.h"
+#include "threading/taskpool.h"
 #include "voxel.h"
 
 EmergeParams::~EmergeParams()
@@ -42,16 +43,19 @@ EmergeParams::~EmergeParams()
 EmergeParams::EmergeParams(EmergeManager *parent, const BiomeGen *biomegen,
 	const BiomeManager *biomemgr,
 	const OreManager *oremgr, const DecorationManager *decomgr,
-	const SchematicManager *schemmgr) :
+	const SchematicManager *schemmgr, TaskPool *taskpool) :
 	ndef(parent->ndef),
 	enable_mapgen_debug_info(parent->enable_mapgen_debug_info),
+	column_cache_size(parent->column_cache_size),
 	gen_notify_on(parent->gen_notify_on),
 	gen_notify_on_deco_ids(&parent->gen_notify_on_deco_ids),
 	gen_notify_on_custom(&parent->gen_notify_on_custom),
 	biomemgr(biomemgr->clone()), oremgr(oremgr->clone()),
-	decomgr(decomgr->clone()), schemmgr(schemmgr->clone())
+	decomgr(decomgr->clone()), schemmgr(schemmgr->clone()),
+	taskpool(taskpool)
 {
 	this->biomegen = biomegen->clone(this->biomemgr);
+	this->biomegen->enableColumnCache(column_cache_size);
 }
 
 ////
@@ -77,6 +81,7 @@ EmergeManager::EmergeManager(Server *server, MetricsBackend *mb)
 	// EmergeThreads should be the ServerThread.
 
 	enable_mapgen_debug_info = g_settings->getBool("enable_mapgen_debug_info");
+	column_cache_size = g_settings->getU16("mapgen_column_cache_size");
 
 	static_assert(ARRLEN(emergeActionStrs) == ARRLEN(m_completed_emerge_counter),
 		"enum size mismatches");
@@ -186,15 +191,22 @@ void EmergeManager::initMapgens(MapgenParams *params)
 	 */
 	bool multithread = params->mgtype == MAPGEN_SINGLENODE;
 	initThreads(multithread);
+	initTaskPool();
 
 	v3s16 csize = params->chunksize * MAP_BLOCKSIZE;
 	biomegen = biomemgr->createBiomeGen(BIOMEGEN_ORIGINAL, params->bparams, csize);
 
-	for (u32 i = 0; i != m_threads.size(); i++) {
-		EmergeParams *p = new EmergeParams(this, biomegen,
-			biomemgr, oremgr, decomgr, schemmgr);
-		m_mapgens.push_back(Mapgen::createMapgen(params->mgtype, params, p));
-	}
+	for (u32 i = 0; i != m_threads.size(); i++)
+		m_mapgens.push_back(createMapgen());
+}
+
+Mapgen *EmergeManager::createMapgen()
+{
+	FATAL_ERROR_IF(!mgparams || !biomegen, "Mapgen not initialized.");
+
+	EmergeParams *p = new EmergeParams(this, biomegen,
+		biomemgr, oremgr, decomgr, schemmgr, m_taskpool.get());
+	return Mapgen::createMapgen(mgparams->mgtype, mgparams, p);
 }
 
 void EmergeManager::initThreads(bool should_multithread)
@@ -226,6 +238,23 @@ void EmergeManager::initThreads(bool should_multithread)
 	infostream << "EmergeManager: using " << nthreads << " thread(s)" << std::endl;
 }
 
+void EmergeManager::initTaskPool()
+{
+	// Including the emerge thread that generates the chunk
+	s16 nthreads = g_settings->getS16("mapgen_chunk_threads");
+	if (nthreads <= 0) {
+		// Other cores are likely busy with the server and other emerge threads
+		nthreads = std::min<u32>(4, Thread::getNumberOfProcessors() / 2);
+	}
+
+	FATAL_ERROR_IF(m_taskpool, "Task pool already initialized.");
+	if (nthreads > 1)
+		m_taskpool = std::make_unique<TaskPool>(nthreads - 1, "MapgenTask");
+
+	infostream << "EmergeManager: using " << std::max<s16>(nthreads, 1)
+		<< " thread(s) per chunk" << std::endl;
+}
+
 Mapgen *EmergeManager::getCurrentMapgen()
 {
 	if (!m_threads_active)
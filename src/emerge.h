@@ -5,6 +5,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <mutex>
 #include "network/networkprotocol.h"
 #include "irr_v3d.h"
@@ -30,6 +31,7 @@ class DecorationManager;
 class SchematicManager;
 class Server;
 class ModApiMapgen;
+class TaskPool;
 struct MapDatabaseAccessor;
 
 // Structure containing inputs/outputs for chunk generation
@@ -90,6 +92,8 @@ class EmergeParams {
 
 	const NodeDefManager *ndef; // shared
 	bool enable_mapgen_debug_info;
+	// Number of chunk columns whose 2D noise is kept by each mapgen
+	u16 column_cache_size;
 
 	u32 gen_notify_on;
 	const std::set<u32> *gen_notify_on_deco_ids; // shared
@@ -101,6 +105,9 @@ class EmergeParams {
 	DecorationManager *decomgr;
 	SchematicManager *schemmgr;
 
+	// Threads for splitting up the generation of a chunk, may be null
+	TaskPool *taskpool; // shared
+
 	inline GenerateNotifier createNotifier() const {
 		return GenerateNotifier(gen_notify_on, gen_notify_on_deco_ids,
 			gen_notify_on_custom);
@@ -110,7 +117,7 @@ class EmergeParams {
 	EmergeParams(EmergeManager *parent, const BiomeGen *biomegen,
 		const BiomeManager *biomemgr,
 		const OreManager *oremgr, const DecorationManager *decomgr,
-		const SchematicManager *schemmgr);
+		const SchematicManager *schemmgr, TaskPool *taskpool);
 };
 
 class EmergeManager {
@@ -122,6 +129,7 @@ class EmergeManager {
 public:
 	const NodeDefManager *ndef;
 	bool enable_mapgen_debug_info;
+	u16 column_cache_size;
 
 	// Generation Notify
 	u32 gen_notify_on = 0;
@@ -158,6 +166,10 @@ class EmergeManager {
 	SchematicManager *getWritableSchematicManager();
 
 	void initMapgens(MapgenParams *mgparams);
+	/// Creates a mapgen that is not bound to an emerge thread,
+	/// e.g. for tests. Only valid after initMapgens.
+	/// @return new mapgen, owned by the caller
+	Mapgen *createMapgen();
 	/// @param holder non-owned reference that must stay alive
 	void initMap(MapDatabaseAccessor *holder);
 	/// resets the reference
@@ -193,9 +205,11 @@ class EmergeManager {
 
 private:
 	void initThreads(bool should_multithread);
+	void initTaskPool();
 
 	std::vector<Mapgen *> m_mapgens;
 	std::vector<EmergeThread *> m_threads;
+	std::unique_ptr<TaskPool> m_taskpool;
 	bool m_threads_active = false;
 
 	// Server reference
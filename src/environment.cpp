@@ -62,11 +62,21 @@ float Environment::getTimeOfDayF()
 }
 
 bool Environment::line_of_sight(v3f pos1, v3f pos2, v3s16 *p)
+{
+	Map &map = getMap();
+	auto get_node = [&map] (v3s16 np) {
+		return map.getNode(np);
+	};
+	return ::line_of_sight(pos1, pos2, get_node, p);
+}
+
+bool line_of_sight(v3f pos1, v3f pos2,
+	const std::function<MapNode(v3s16)> &get_node, v3s16 *p)
 {
 	// Iterate trough nodes on the line
 	voxalgo::VoxelLineIterator iterator(pos1 / BS, (pos2 - pos1) / BS);
 	do {
-		MapNode n = getMap().getNode(iterator.m_current_node_pos);
+		MapNode n = get_node(iterator.m_current_node_pos);
 
 		// Return non-air
 		if (n.param0 != CONTENT_AIR) {
@@ -101,15 +111,26 @@ inline static PointabilityType isPointableNode(const MapNode &n,
 
 void Environment::continueRaycast(RaycastState *state, PointedThing *result_p)
 {
-	const NodeDefManager *nodedef = getMap().getNodeDefManager();
+	// Add objects
+	if (state->m_initialization_needed && state->m_objects_pointable) {
+		std::vector<PointedThing> found;
+		getSelectedActiveObjects(state->m_shootline, found, state->m_pointabilities);
+		for (auto &pointed : found)
+			state->m_found.push(std::move(pointed));
+	}
+
+	Map &map = getMap();
+	auto get_node = [&map] (v3s16 p, bool *is_valid_position) {
+		return map.getNode(p, is_valid_position);
+	};
+	continue_raycast_nodes(state, result_p, map.getNodeDefManager(), get_node);
+}
+
+void continue_raycast_nodes(RaycastState *state, PointedThing *result_p,
+	const NodeDefManager *nodedef,
+	const std::function<MapNode(v3s16, bool *)> &get_node)
+{
 	if (state->m_initialization_needed) {
-		// Add objects
-		if (state->m_objects_pointable) {
-			std::vector<PointedThing> found;
-			getSelectedActiveObjects(state->m_shootline, found, state->m_pointabilities);
-			for (auto &pointed : found)
-				state->m_found.push(std::move(pointed));
-		}
 		// Set search range
 		core::aabbox3d<s16> maximal_exceed = nodedef->getSelectionBoxIntUnion();
 		state->m_search_range.MinEdge = -maximal_exceed.MaxEdge;
@@ -126,7 +147,9 @@ void Environment::continueRaycast(RaycastState *state, PointedThing *result_p)
 			floatToInt(state->m_found.top().intersection_point, BS));
 	}
 
-	Map &map = getMap();
+	auto get_neighbor = [&get_node] (v3s16 p) {
+		return get_node(p, nullptr);
+	};
 	std::vector<aabb3f> boxes;
 	while (state->m_iterator.m_current_index <= lastIndex) {
 		// Test the nodes around the current node in search_range.
@@ -165,7 +188,7 @@ void Environment::continueRaycast(RaycastState *state, PointedThing *result_p)
 			v3s16 np(x, y, z);
 			bool is_valid_position;
 
-			n = map.getNode(np, &is_valid_position);
+			n = get_node(np, &is_valid_position);
 			if (!is_valid_position)
 				continue;
 
@@ -180,7 +203,7 @@ void Environment::continueRaycast(RaycastState *state, PointedThing *result_p)
 
 			boxes.clear();
 			n.getSelectionBoxes(nodedef, &boxes,
-				n.getNeighbors(np, &map));
+				n.getNeighbors(np, nodedef, get_neighbor));
 
 			// Is there a collision with a selection box?
 			bool is_colliding = false;
@@ -15,6 +15,7 @@
 */
 
 #include <atomic>
+#include <functional>
 #include <mutex>
 #include <optional>
 #include "irr_v3d.h"
@@ -23,6 +24,8 @@
 
 class IGameDef;
 class Map;
+class NodeDefManager;
+struct MapNode;
 struct PointedThing;
 class RaycastState;
 struct Pointabilities;
@@ -124,3 +127,17 @@ class Environment
 private:
 	std::mutex m_time_lock;
 };
+
+/*
+	Map-independent parts of Environment::line_of_sight and
+	Environment::continueRaycast, for reading something other than the map
+	(the map snapshot of the async environment)
+*/
+
+bool line_of_sight(v3f pos1, v3f pos2,
+	const std::function<MapNode(v3s16)> &get_node, v3s16 *p = nullptr);
+
+// Does not search for objects, they must be added to the state beforehand
+void continue_raycast_nodes(RaycastState *state, PointedThing *result,
+	const NodeDefManager *nodedef,
+	const std::function<MapNode(v3s16, bool *)> &get_node);
@@ -16,7 +16,7 @@ class ModChannel;
 class ModStorageDatabase;
 struct SubgameSpec;
 struct ModSpec;
-struct ModIPCStore;
+class ModIPCStore;
 
 /*
 	An interface for fetching game-global definitions like tool and
@@ -8,6 +8,7 @@
 #include "debug.h"
 #include "unittest/test.h"
 #include "server.h"
+#include "server/packetreplay.h"
 #include "filesys.h"
 #include "version.h"
 #include "defaultsettings.h"
@@ -27,6 +28,7 @@
 #include "serverenvironment.h"
 #include "servermap.h"
 #include "settings.h"
+#include "network/botclient.h"
 #include "network/socket.h"
 #include "network/networkexceptions.h"
 #include "mapblock.h"
@@ -246,6 +248,12 @@ int main(int argc, char *argv[])
 #endif
 	}
 
+	// Run load testing bots
+	if (cmd_args.exists("run-bots")) {
+		porting::attachOrCreateConsole();
+		return run_bots(cmd_args) ? 0 : 1;
+	}
+
 	GameStartData game_params;
 #if !CHECK_CLIENT_BUILD()
 	porting::attachOrCreateConsole();
@@ -389,6 +397,22 @@ static void set_allowed_options(OptionList *allowed_options)
 			_("Enable ncurses interactive terminal" SERVER_ONLY))));
 	allowed_options->insert(std::make_pair("recompress", ValueSpec(VALUETYPE_FLAG,
 			_("Recompress the blocks of the given map database" SERVER_ONLY))));
+	allowed_options->insert(std::make_pair("replay-packets", ValueSpec(VALUETYPE_STRING,
+			_("Replay a packet capture against a copy of the world and print statistics" SERVER_ONLY))));
+	allowed_options->insert(std::make_pair("replay-realtime", ValueSpec(VALUETYPE_FLAG,
+			_("Replay packets with their original timing instead of as fast as possible" SERVER_ONLY))));
+	allowed_options->insert(std::make_pair("run-bots", ValueSpec(VALUETYPE_STRING,
+			_("Connect the given number of headless bots to a server, print latencies and exit"))));
+	allowed_options->insert(std::make_pair("bot-address", ValueSpec(VALUETYPE_STRING,
+			_("Server address for --run-bots, default: 127.0.0.1"))));
+	allowed_options->insert(std::make_pair("bot-name", ValueSpec(VALUETYPE_STRING,
+			_("Player name prefix for --run-bots, default: 'bot'"))));
+	allowed_options->insert(std::make_pair("bot-password", ValueSpec(VALUETYPE_STRING,
+			_("Password of the bots"))));
+	allowed_options->insert(std::make_pair("bot-pattern", ValueSpec(VALUETYPE_STRING,
+			_("Behaviour of the bots ('idle', 'walk' or 'dig'), default: 'walk'"))));
+	allowed_options->insert(std::make_pair("bot-duration", ValueSpec(VALUETYPE_STRING,
+			_("Time to run the bots for in seconds, default: 60"))));
 #if CHECK_CLIENT_BUILD()
 	allowed_options->insert(std::make_pair("address", ValueSpec(VALUETYPE_STRING,
 			_("Address to connect to ('' = local game)"))));
@@ -1136,6 +1160,9 @@ static bool run_dedicated_server(const GameParams &game_params, const Settings &
 	if (cmd_args.getFlag("recompress"))
 		return recompress_map_database(game_params, cmd_args);
 
+	if (cmd_args.exists("replay-packets"))
+		return replay_packet_capture(game_params, cmd_args);
+
 	// Bind address
 	std::string bind_str = g_settings->get("bind_address");
 	Address bind_addr(0, 0, 0, 0, game_params.socket_port);
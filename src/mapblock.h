@@ -284,6 +284,13 @@ class MapBlock
 	// Copies data to VoxelManipulator to getPosRelative()
 	void copyTo(VoxelManipulator &dst);
 
+	// Copies the nodes to `dst`: a single node if all nodes are identical,
+	// otherwise all of them in z, y, x order
+	void copyNodesTo(std::vector<MapNode> &dst) const
+	{
+		dst.assign(data, data + (m_is_mono_block ? 1 : nodecount));
+	}
+
 	// Copies data from VoxelManipulator to getPosRelative()
 	void copyFrom(const VoxelManipulator &src);
 
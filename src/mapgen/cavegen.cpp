@@ -10,6 +10,8 @@
 #include "mapgen.h"
 #include "mg_biome.h"
 #include "cavegen.h"
+#include "threading/taskpool.h"
+#include <atomic>
 
 // TODO Remove this. Cave liquids are now defined and located using biome definitions
 static NoiseParams nparams_caveliquids(0, 1, v3f(150.0, 150.0, 150.0), 776, 3, 0.6, 2.0);
@@ -21,7 +23,8 @@ static NoiseParams nparams_caveliquids(0, 1, v3f(150.0, 150.0, 150.0), 776, 3, 0
 
 CavesNoiseIntersection::CavesNoiseIntersection(
 	const NodeDefManager *nodedef, BiomeManager *biomemgr, BiomeGen *biomegen, v3s16 chunksize,
-	NoiseParams *np_cave1, NoiseParams *np_cave2, s32 seed, float cave_width)
+	NoiseParams *np_cave1, NoiseParams *np_cave2, s32 seed, float cave_width,
+	TaskPool *taskpool)
 {
 	assert(nodedef);
 	assert(biomemgr);
@@ -30,6 +33,7 @@ CavesNoiseIntersection::CavesNoiseIntersection(
 	m_ndef = nodedef;
 	m_bmgr = biomemgr;
 	m_bmgn = biomegen;
+	m_taskpool = taskpool;
 
 	m_csize = chunksize;
 	m_cave_width = cave_width;
@@ -58,13 +62,26 @@ void CavesNoiseIntersection::generateCaves(MMVManip *vm,
 	assert(vm);
 	assert(biomemap);
 
-	noise_cave1->noiseMap3D(nmin.X, nmin.Y - 1, nmin.Z);
-	noise_cave2->noiseMap3D(nmin.X, nmin.Y - 1, nmin.Z);
+	TaskGraph noises(m_taskpool);
+	noises.add([&] { noise_cave1->noiseMap3D(nmin.X, nmin.Y - 1, nmin.Z); });
+	noises.add([&] { noise_cave2->noiseMap3D(nmin.X, nmin.Y - 1, nmin.Z); });
+	noises.run();
 
+	// The columns are independent
+	parallel_for(m_taskpool, m_csize.Z, 4, [&] (size_t begin, size_t end) {
+		generateCaveRows(vm, nmin, nmax, biomemap,
+			nmin.Z + begin, nmin.Z + end - 1);
+	});
+}
+
+
+void CavesNoiseIntersection::generateCaveRows(MMVManip *vm,
+	v3s16 nmin, v3s16 nmax, biome_t *biomemap, s16 z_min, s16 z_max)
+{
 	const v3s32 &em = vm->m_area.getExtent();
-	u32 index2d = 0;  // Biomemap index
+	u32 index2d = (z_min - nmin.Z) * m_csize.X;  // Biomemap index
 
-	for (s16 z = nmin.Z; z <= nmax.Z; z++)
+	for (s16 z = z_min; z <= z_max; z++)
 	for (s16 x = nmin.X; x <= nmax.X; x++, index2d++) {
 		bool column_is_open = false;  // Is column open to overground
 		bool is_under_river = false;  // Is column under river water
@@ -175,11 +192,13 @@ void CavesNoiseIntersection::generateCaves(MMVManip *vm,
 
 CavernsNoise::CavernsNoise(
 	const NodeDefManager *nodedef, v3s16 chunksize, NoiseParams *np_cavern,
-	s32 seed, float cavern_limit, float cavern_taper, float cavern_threshold)
+	s32 seed, float cavern_limit, float cavern_taper, float cavern_threshold,
+	TaskPool *taskpool)
 {
 	assert(nodedef);
 
 	m_ndef  = nodedef;
+	m_taskpool = taskpool;
 
 	m_csize            = chunksize;
 	m_cavern_limit     = cavern_limit;
@@ -226,14 +245,30 @@ bool CavernsNoise::generateCaverns(MMVManip *vm, v3s16 nmin, v3s16 nmax)
 	}
 
 	//// Place nodes
+	// The columns are independent
+	std::atomic<bool> near_cavern(false);
+	parallel_for(m_taskpool, m_csize.Z, 4, [&] (size_t begin, size_t end) {
+		if (generateCavernRows(vm, nmin, nmax, cavern_amp,
+				nmin.Z + begin, nmin.Z + end - 1))
+			near_cavern = true;
+	});
+
+	delete[] cavern_amp;
+
+	return near_cavern;
+}
+
+
+bool CavernsNoise::generateCavernRows(MMVManip *vm, v3s16 nmin, v3s16 nmax,
+	const float *cavern_amp, s16 z_min, s16 z_max)
+{
 	bool near_cavern = false;
 	const v3s32 &em = vm->m_area.getExtent();
-	u32 index2d = 0;
 
-	for (s16 z = nmin.Z; z <= nmax.Z; z++)
-	for (s16 x = nmin.X; x <= nmax.X; x++, index2d++) {
+	for (s16 z = z_min; z <= z_max; z++)
+	for (s16 x = nmin.X; x <= nmax.X; x++) {
 		// Reset cave_amp index to column top
-		cavern_amp_index = 0;
+		u8 cavern_amp_index = 0;
 		// Initial voxelmanip index at column top
 		u32 vi = vm->m_area.index(x, nmax.Y, z);
 		// Initial 3D noise index at column top
@@ -261,8 +296,6 @@ bool CavernsNoise::generateCaverns(MMVManip *vm, v3s16 nmin, v3s16 nmax)
 		}
 	}
 
-	delete[] cavern_amp;
-
 	return near_cavern;
 }
 
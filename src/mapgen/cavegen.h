@@ -13,6 +13,8 @@ class GenerateNotifier;
 
 class BiomeGen;
 
+class TaskPool;
+
 /*
 	CavesNoiseIntersection is a cave digging algorithm that carves smooth,
 	web-like, continuous tunnels at points where the density of the intersection
@@ -30,13 +32,19 @@ class CavesNoiseIntersection
 public:
 	CavesNoiseIntersection(const NodeDefManager *nodedef,
 		BiomeManager *biomemgr, BiomeGen *biomegen, v3s16 chunksize, NoiseParams *np_cave1,
-		NoiseParams *np_cave2, s32 seed, float cave_width);
+		NoiseParams *np_cave2, s32 seed, float cave_width,
+		TaskPool *taskpool = nullptr);
 	~CavesNoiseIntersection();
 
 	void generateCaves(MMVManip *vm, v3s16 nmin, v3s16 nmax, biome_t *biomemap);
 
 private:
+	// Carves the columns with Z in [z_min, z_max]
+	void generateCaveRows(MMVManip *vm, v3s16 nmin, v3s16 nmax,
+		biome_t *biomemap, s16 z_min, s16 z_max);
+
 	const NodeDefManager *m_ndef;
+	TaskPool *m_taskpool;
 	BiomeManager *m_bmgr;
 
 	BiomeGen *m_bmgn;
@@ -61,13 +69,20 @@ class CavernsNoise
 public:
 	CavernsNoise(const NodeDefManager *nodedef, v3s16 chunksize,
 		NoiseParams *np_cavern, s32 seed, float cavern_limit,
-		float cavern_taper, float cavern_threshold);
+		float cavern_taper, float cavern_threshold,
+		TaskPool *taskpool = nullptr);
 	~CavernsNoise();
 
 	bool generateCaverns(MMVManip *vm, v3s16 nmin, v3s16 nmax);
 
 private:
+	// Returns whether any of the columns with Z in [z_min, z_max] is near
+	// a cavern
+	bool generateCavernRows(MMVManip *vm, v3s16 nmin, v3s16 nmax,
+		const float *cavern_amp, s16 z_min, s16 z_max);
+
 	const NodeDefManager *m_ndef;
+	TaskPool *m_taskpool;
 
 	// configurable parameters
 	v3s16 m_csize;
@@ -4,6 +4,7 @@
 // Copyright (C) 2013-2018 kwolekr, Ryan Kwolek <kwolekr@minetest.net>
 // Copyright (C) 2015-2018 paramat
 
+#include <algorithm>
 #include <cmath>
 #include "mapgen.h"
 #include "voxel.h"
@@ -31,6 +32,7 @@
 #include "mapgen_singlenode.h"
 #include "cavegen.h"
 #include "dungeongen.h"
+#include "threading/taskpool.h"
 
 const FlagDesc flagdesc_mapgen[] = {
 	{"caves",       MG_CAVES},
@@ -626,12 +628,21 @@ void MapgenBasic::generateBiomes()
 	assert(biomegen);
 	assert(biomemap);
 
-	const v3s32 &em = vm->m_area.getExtent();
-	u32 index = 0;
-
 	noise_filler_depth->noiseMap2D(node_min.X, node_min.Z);
 
-	for (s16 z = node_min.Z; z <= node_max.Z; z++)
+	// The columns are independent
+	parallel_for(m_emerge->taskpool, csize.Z, 4, [this] (size_t begin, size_t end) {
+		generateBiomeRows(node_min.Z + begin, node_min.Z + end - 1);
+	});
+}
+
+
+void MapgenBasic::generateBiomeRows(s16 z_min, s16 z_max)
+{
+	const v3s32 &em = vm->m_area.getExtent();
+	u32 index = (z_min - node_min.Z) * csize.X;
+
+	for (s16 z = z_min; z <= z_max; z++)
 	for (s16 x = node_min.X; x <= node_max.X; x++, index++) {
 		Biome *biome = NULL;
 		biome_t water_biome_index = 0;
@@ -838,7 +849,7 @@ void MapgenBasic::generateCavesNoiseIntersection(s16 max_stone_y)
 		return;
 
 	CavesNoiseIntersection caves_noise(ndef, m_bmgr, biomegen, csize,
-		&np_cave1, &np_cave2, seed, cave_width);
+		&np_cave1, &np_cave2, seed, cave_width, m_emerge->taskpool);
 
 	caves_noise.generateCaves(vm, node_min, node_max, biomemap);
 }
@@ -881,7 +892,7 @@ bool MapgenBasic::generateCavernsNoise(s16 max_stone_y)
 		return false;
 
 	CavernsNoise caverns_noise(ndef, csize, &np_cavern,
-		seed, cavern_limit, cavern_taper, cavern_threshold);
+		seed, cavern_limit, cavern_taper, cavern_threshold, m_emerge->taskpool);
 
 	return caverns_noise.generateCaverns(vm, node_min, node_max);
 }
@@ -1035,6 +1046,70 @@ void GenerateNotifier::clearEvents()
 }
 
 
+////
+//// ColumnNoiseCache
+////
+
+ColumnNoiseCache::ColumnNoiseCache(const std::string &name,
+	std::vector<Noise *> noises, size_t limit) :
+	m_profiler_name(name + ": column noise cache hits [%]"),
+	m_noises(std::move(noises)),
+	m_limit(limit)
+{
+	m_entries.reserve(m_limit);
+}
+
+
+bool ColumnNoiseCache::load(v2s16 pos)
+{
+	for (Entry &entry : m_entries) {
+		if (entry.pos != pos)
+			continue;
+
+		const float *src = entry.results.data();
+		for (Noise *noise : m_noises) {
+			const u32 size = noise->sx * noise->sy;
+			std::copy_n(src, size, noise->result);
+			src += size;
+		}
+		entry.last_use = ++m_use_counter;
+		m_hits++;
+		g_profiler->avg(m_profiler_name, 100);
+		return true;
+	}
+
+	m_misses++;
+	g_profiler->avg(m_profiler_name, 0);
+	return false;
+}
+
+
+void ColumnNoiseCache::store(v2s16 pos)
+{
+	if (m_limit == 0)
+		return;
+
+	// Replace the least recently used column
+	Entry *entry;
+	if (m_entries.size() < m_limit) {
+		entry = &m_entries.emplace_back();
+	} else {
+		entry = &*std::min_element(m_entries.begin(), m_entries.end(),
+			[] (const Entry &a, const Entry &b) {
+				return a.last_use < b.last_use;
+			});
+	}
+
+	entry->pos = pos;
+	entry->last_use = ++m_use_counter;
+	entry->results.clear();
+	for (Noise *noise : m_noises) {
+		entry->results.insert(entry->results.end(), noise->result,
+			noise->result + noise->sx * noise->sy);
+	}
+}
+
+
 ////
 //// MapgenParams
 ////
@@ -11,6 +11,7 @@
 #include "nodedef.h"
 #include "util/string.h"
 #include "util/container.h"
+#include <memory>
 #include <utility>
 
 #define MAPGEN_DEFAULT MAPGEN_V7
@@ -94,6 +95,43 @@ class GenerateNotifier {
 	}
 };
 
+/*
+	Keeps the 2D noise maps of the latest mapchunk columns. The chunks above
+	and below a chunk have the same 2D noise, so it only needs to be
+	calculated once per column.
+	Not thread-safe, every mapgen has its own.
+*/
+class ColumnNoiseCache {
+public:
+	// `noises` must be 2D noise maps of one chunk
+	ColumnNoiseCache(const std::string &name, std::vector<Noise *> noises,
+		size_t limit);
+
+	// Restores the results of the noises of the column at `pos`.
+	// Returns false if they are not cached.
+	bool load(v2s16 pos);
+	// Adds the current results of the noises as those of the column at `pos`
+	void store(v2s16 pos);
+
+	u32 getHits() const { return m_hits; }
+	u32 getMisses() const { return m_misses; }
+
+private:
+	struct Entry {
+		v2s16 pos;
+		u64 last_use;
+		std::vector<float> results;
+	};
+
+	std::string m_profiler_name;
+	std::vector<Noise *> m_noises;
+	size_t m_limit;
+	std::vector<Entry> m_entries;
+	u64 m_use_counter = 0;
+	u32 m_hits = 0;
+	u32 m_misses = 0;
+};
+
 // Order must match the order of 'static MapgenDesc g_reg_mapgens[]' in mapgen.cpp
 enum MapgenType {
 	MAPGEN_V7,
@@ -288,6 +326,8 @@ class MapgenBasic : public Mapgen {
 	BiomeManager *m_bmgr = nullptr;
 
 	Noise *noise_filler_depth = nullptr;
+	// 2D terrain noise of the latest columns, may be null
+	std::unique_ptr<ColumnNoiseCache> m_column_cache;
 
 	v3s16 node_min;
 	v3s16 node_max;
@@ -307,6 +347,9 @@ class MapgenBasic : public Mapgen {
 
 	u32 spflags;
 
+	// Biomes of the columns with Z in [z_min, z_max]
+	void generateBiomeRows(s16 z_min, s16 z_max);
+
 	NoiseParams np_cave1;
 	NoiseParams np_cave2;
 	NoiseParams np_cavern;
@@ -4,6 +4,7 @@
 // Copyright (C) 2017-2019 paramat
 
 
+#include <algorithm>
 #include <cmath>
 #include "mapgen.h"
 #include "voxel.h"
@@ -21,6 +22,7 @@
 #include "mg_ore.h"
 #include "mg_decoration.h"
 #include "mapgen_carpathian.h"
+#include "threading/taskpool.h"
 
 
 const FlagDesc flagdesc_mapgen_carpathian[] = {
@@ -76,6 +78,17 @@ MapgenCarpathian::MapgenCarpathian(MapgenCarpathianParams *params, EmergeParams
 	// 1 up 1 down overgeneration
 	noise_mnt_var = new Noise(&params->np_mnt_var, seed, csize.X, csize.Y + 2, csize.Z);
 
+	if (emerge->column_cache_size > 0) {
+		std::vector<Noise *> column_noises = {noise_height1, noise_height2,
+			noise_height3, noise_height4, noise_hills_terrain,
+			noise_ridge_terrain, noise_step_terrain, noise_hills,
+			noise_ridge_mnt, noise_step_mnt};
+		if (spflags & MGCARPATHIAN_RIVERS)
+			column_noises.push_back(noise_rivers);
+		m_column_cache = std::make_unique<ColumnNoiseCache>("MapgenCarpathian",
+			std::move(column_noises), emerge->column_cache_size);
+	}
+
 	//// Cave noise
 	MapgenBasic::np_cave1  = params->np_cave1;
 	MapgenBasic::np_cave2  = params->np_cave2;
@@ -225,6 +238,12 @@ inline float MapgenCarpathian::getLerp(float noise1, float noise2, float mod)
 	return noise1 + mod * (noise2 - noise1);
 }
 
+// Gradient & shallow seabed
+inline s32 MapgenCarpathian::getGradient(s16 y)
+{
+	return (y < water_level) ? grad_wl + (water_level - y) * 3 : 1 - y;
+}
+
 // Steps function
 float MapgenCarpathian::getSteps(float noise)
 {
@@ -421,77 +440,162 @@ int MapgenCarpathian::getSpawnLevelAtPoint(v2s16 p)
 ////////////////////////////////////////////////////////////////////////////////
 
 
-int MapgenCarpathian::generateTerrain()
+MapgenCarpathian::Column MapgenCarpathian::getColumn(u32 index2d)
 {
-	MapNode mn_air(CONTENT_AIR);
-	MapNode mn_stone(c_stone);
-	MapNode mn_water(c_water_source);
+	Column c;
+
+	// Hill/Mountain height (hilliness)
+	c.height1 = noise_height1->result[index2d];
+	c.height2 = noise_height2->result[index2d];
+	c.height3 = noise_height3->result[index2d];
+	c.height4 = noise_height4->result[index2d];
+
+	// Rolling hills
+	float hterabs = std::fabs(noise_hills_terrain->result[index2d]);
+	float n_hills = noise_hills->result[index2d];
+	c.hill_mnt = hterabs * hterabs * hterabs * n_hills * n_hills;
+
+	// Ridged mountains
+	float rterabs = std::fabs(noise_ridge_terrain->result[index2d]);
+	float n_ridge_mnt = noise_ridge_mnt->result[index2d];
+	c.ridge_mnt = rterabs * rterabs * rterabs *
+		(1.0f - std::fabs(n_ridge_mnt));
+
+	// Step (terraced) mountains
+	float sterabs = std::fabs(noise_step_terrain->result[index2d]);
+	float n_step_mnt = noise_step_mnt->result[index2d];
+	c.step_mnt = sterabs * sterabs * sterabs * getSteps(n_step_mnt);
+
+	// Rivers
+	c.valley = 1.0f;
+	c.in_valley = false;
+
+	if ((spflags & MGCARPATHIAN_RIVERS) && node_max.Y >= water_level - 16) {
+		float river = std::fabs(noise_rivers->result[index2d]) - river_width;
+		if (river <= valley_width) {
+			// Within river valley
+			c.in_valley = true;
+			if (river < 0.0f) {
+				// River channel
+				c.valley = river;
+			} else {
+				// Valley slopes.
+				// 0 at river edge, 1 at valley edge.
+				float riversc = river / valley_width;
+				// Smoothstep
+				c.valley = riversc * riversc * (3.0f - 2.0f * riversc);
+			}
+		}
+	}
+
+	return c;
+}
+
+
+bool MapgenCarpathian::mountainVariationDecided()
+{
+	float var_min, var_max;
+	NoiseFractalBounds(&noise_mnt_var->np, var_min, var_max);
+
+	const s16 y_bottom = node_min.Y - 1;
+	const s16 y_top = node_max.Y + 1;
+
+	for (u32 index2d = 0; index2d < (u32)csize.X * csize.Z; index2d++) {
+		Column c = getColumn(index2d);
+
+		// The interpolations are linear in the noise, so the hilliness is
+		// between the values at the noise bounds
+		const float hills[8] = {
+			getLerp(c.height1, c.height2, var_min), getLerp(c.height1, c.height2, var_max),
+			getLerp(c.height3, c.height4, var_min), getLerp(c.height3, c.height4, var_max),
+			getLerp(c.height3, c.height2, var_min), getLerp(c.height3, c.height2, var_max),
+			getLerp(c.height1, c.height4, var_min), getLerp(c.height1, c.height4, var_max),
+		};
+		float hilliness_min = *std::min_element(hills, hills + 8);
+		float hilliness_max = *std::max_element(hills, hills + 8);
+
+		float mountains_min = 0.0f, mountains_max = 0.0f;
+		for (float f : {c.hill_mnt, c.ridge_mnt, c.step_mnt}) {
+			mountains_min += std::fmin(f * hilliness_min, f * hilliness_max);
+			mountains_max += std::fmax(f * hilliness_min, f * hilliness_max);
+		}
+
+		// As y - gradient grows with y, checking the ends of the column
+		// suffices. Rivers only lower the surface.
+		float level_max = base_level + mountains_max + getGradient(y_bottom);
+		if (y_bottom >= level_max + 0.5f + 0.001f * std::fabs(level_max))
+			continue; // No stone
+		float level_min = base_level + mountains_min + getGradient(y_top);
+		if (!c.in_valley &&
+				y_top < level_min - 0.5f - 0.001f * std::fabs(level_min))
+			continue; // All stone
+		return false;
+	}
+	return true;
+}
 
+
+int MapgenCarpathian::generateTerrain()
+{
 	// Calculate noise for terrain generation
-	noise_height1->noiseMap2D(node_min.X, node_min.Z);
-	noise_height2->noiseMap2D(node_min.X, node_min.Z);
-	noise_height3->noiseMap2D(node_min.X, node_min.Z);
-	noise_height4->noiseMap2D(node_min.X, node_min.Z);
-	noise_hills_terrain->noiseMap2D(node_min.X, node_min.Z);
-	noise_ridge_terrain->noiseMap2D(node_min.X, node_min.Z);
-	noise_step_terrain->noiseMap2D(node_min.X, node_min.Z);
-	noise_hills->noiseMap2D(node_min.X, node_min.Z);
-	noise_ridge_mnt->noiseMap2D(node_min.X, node_min.Z);
-	noise_step_mnt->noiseMap2D(node_min.X, node_min.Z);
-	noise_mnt_var->noiseMap3D(node_min.X, node_min.Y - 1, node_min.Z);
+	const v2s16 column(node_min.X, node_min.Z);
+	if (!m_column_cache || !m_column_cache->load(column)) {
+		// The 2D noise maps are independent
+		TaskGraph noises(m_emerge->taskpool);
+		for (Noise *noise : {noise_height1, noise_height2, noise_height3,
+				noise_height4, noise_hills_terrain, noise_ridge_terrain,
+				noise_step_terrain, noise_hills, noise_ridge_mnt, noise_step_mnt}) {
+			noises.add([this, noise] {
+				noise->noiseMap2D(node_min.X, node_min.Z);
+			});
+		}
 
-	if (spflags & MGCARPATHIAN_RIVERS)
-		noise_rivers->noiseMap2D(node_min.X, node_min.Z);
+		if (spflags & MGCARPATHIAN_RIVERS) {
+			noises.add([this] {
+				noise_rivers->noiseMap2D(node_min.X, node_min.Z);
+			});
+		}
+		noises.run();
+
+		if (m_column_cache)
+			m_column_cache->store(column);
+	}
+
+	// Far above or below the surface, the 3D variation makes no difference
+	// and its offset is used instead
+	bool mnt_var_skipped = mountainVariationDecided();
+	if (!mnt_var_skipped)
+		noise_mnt_var->noiseMap3D(node_min.X, node_min.Y - 1, node_min.Z);
 
 	//// Place nodes
+	// The columns are independent
+	s16 stone_surface_max_y = -MAX_MAP_GENERATION_LIMIT;
+	std::mutex surface_mutex;
+	parallel_for(m_emerge->taskpool, csize.Z, 4, [&] (size_t begin, size_t end) {
+		s16 max_y = generateTerrainRows(node_min.Z + begin, node_min.Z + end - 1,
+			mnt_var_skipped);
+		std::lock_guard lock(surface_mutex);
+		stone_surface_max_y = std::max(stone_surface_max_y, max_y);
+	});
+
+	return stone_surface_max_y;
+}
+
+
+s16 MapgenCarpathian::generateTerrainRows(s16 z_min, s16 z_max,
+	bool mnt_var_skipped)
+{
+	MapNode mn_air(CONTENT_AIR);
+	MapNode mn_stone(c_stone);
+	MapNode mn_water(c_water_source);
+
 	const v3s32 &em = vm->m_area.getExtent();
 	s16 stone_surface_max_y = -MAX_MAP_GENERATION_LIMIT;
-	u32 index2d = 0;
+	u32 index2d = (z_min - node_min.Z) * csize.X;
 
-	for (s16 z = node_min.Z; z <= node_max.Z; z++)
+	for (s16 z = z_min; z <= z_max; z++)
 	for (s16 x = node_min.X; x <= node_max.X; x++, index2d++) {
-		// Hill/Mountain height (hilliness)
-		float height1 = noise_height1->result[index2d];
-		float height2 = noise_height2->result[index2d];
-		float height3 = noise_height3->result[index2d];
-		float height4 = noise_height4->result[index2d];
-
-		// Rolling hills
-		float hterabs = std::fabs(noise_hills_terrain->result[index2d]);
-		float n_hills = noise_hills->result[index2d];
-		float hill_mnt = hterabs * hterabs * hterabs * n_hills * n_hills;
-
-		// Ridged mountains
-		float rterabs = std::fabs(noise_ridge_terrain->result[index2d]);
-		float n_ridge_mnt = noise_ridge_mnt->result[index2d];
-		float ridge_mnt = rterabs * rterabs * rterabs *
-			(1.0f - std::fabs(n_ridge_mnt));
-
-		// Step (terraced) mountains
-		float sterabs = std::fabs(noise_step_terrain->result[index2d]);
-		float n_step_mnt = noise_step_mnt->result[index2d];
-		float step_mnt = sterabs * sterabs * sterabs * getSteps(n_step_mnt);
-
-		// Rivers
-		float valley = 1.0f;
-		float river = 0.0f;
-
-		if ((spflags & MGCARPATHIAN_RIVERS) && node_max.Y >= water_level - 16) {
-			river = std::fabs(noise_rivers->result[index2d]) - river_width;
-			if (river <= valley_width) {
-				// Within river valley
-				if (river < 0.0f) {
-					// River channel
-					valley = river;
-				} else {
-					// Valley slopes.
-					// 0 at river edge, 1 at valley edge.
-					float riversc = river / valley_width;
-					// Smoothstep
-					valley = riversc * riversc * (3.0f - 2.0f * riversc);
-				}
-			}
-		}
+		Column c = getColumn(index2d);
 
 		// Initialise 3D noise index and voxelmanip index to column base
 		u32 index3d = (z - node_min.Z) * zstride_1u1d + (x - node_min.X);
@@ -505,38 +609,37 @@ int MapgenCarpathian::generateTerrain()
 				continue;
 
 			// Combine height noises and apply 3D variation
-			float mnt_var = noise_mnt_var->result[index3d];
-			float hill1 = getLerp(height1, height2, mnt_var);
-			float hill2 = getLerp(height3, height4, mnt_var);
-			float hill3 = getLerp(height3, height2, mnt_var);
-			float hill4 = getLerp(height1, height4, mnt_var);
+			float mnt_var = mnt_var_skipped ? noise_mnt_var->np.offset :
+				noise_mnt_var->result[index3d];
+			float hill1 = getLerp(c.height1, c.height2, mnt_var);
+			float hill2 = getLerp(c.height3, c.height4, mnt_var);
+			float hill3 = getLerp(c.height3, c.height2, mnt_var);
+			float hill4 = getLerp(c.height1, c.height4, mnt_var);
 
 			// 'hilliness' determines whether hills/mountains are
 			// small or large
 			float hilliness =
 				std::fmax(std::fmin(hill1, hill2), std::fmin(hill3, hill4));
-			float hills = hill_mnt * hilliness;
-			float ridged_mountains = ridge_mnt * hilliness;
-			float step_mountains = step_mnt * hilliness;
+			float hills = c.hill_mnt * hilliness;
+			float ridged_mountains = c.ridge_mnt * hilliness;
+			float step_mountains = c.step_mnt * hilliness;
 
 			// Gradient & shallow seabed
-			s32 grad = (y < water_level) ? grad_wl + (water_level - y) * 3 :
-				1 - y;
+			s32 grad = getGradient(y);
 
 			// Final terrain level
 			float mountains = hills + ridged_mountains + step_mountains;
 			float surface_level = base_level + mountains + grad;
 
 			// Rivers
-			if ((spflags & MGCARPATHIAN_RIVERS) && node_max.Y >= water_level - 16 &&
-					river <= valley_width) {
-				if (valley < 0.0f) {
+			if (c.in_valley) {
+				if (c.valley < 0.0f) {
 					// River channel
 					surface_level = std::fmin(surface_level,
-						water_level - std::sqrt(-valley) * river_depth);
+						water_level - std::sqrt(-c.valley) * river_depth);
 				} else if (surface_level > water_level) {
 					// Valley slopes
-					surface_level = water_level + (surface_level - water_level) * valley;
+					surface_level = water_level + (surface_level - water_level) * c.valley;
 				}
 			}
 
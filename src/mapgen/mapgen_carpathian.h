@@ -92,7 +92,24 @@ class MapgenCarpathian : public MapgenBasic
 
 	s32 grad_wl;
 
+	// Terrain parameters of a column, from the 2D noises
+	struct Column {
+		float height1, height2, height3, height4;
+		float hill_mnt, ridge_mnt, step_mnt;
+		// Within a river valley, which lowers the surface
+		bool in_valley;
+		float valley;
+	};
+
 	float getSteps(float noise);
 	inline float getLerp(float noise1, float noise2, float mod);
+	inline s32 getGradient(s16 y);
+	Column getColumn(u32 index2d);
+	// Whether the 3D noise can't change the terrain of the chunk, so that it
+	// doesn't need to be calculated
+	bool mountainVariationDecided();
 	int generateTerrain();
+	// Terrain of the columns with Z in [z_min, z_max], returns their
+	// highest stone
+	s16 generateTerrainRows(s16 z_min, s16 z_max, bool mnt_var_skipped);
 };
@@ -21,6 +21,7 @@
 #include "mg_ore.h"
 #include "mg_decoration.h"
 #include "mapgen_v7.h"
+#include "threading/taskpool.h"
 
 
 const FlagDesc flagdesc_mapgen_v7[] = {
@@ -99,6 +100,15 @@ MapgenV7::MapgenV7(MapgenV7Params *params, EmergeParams *emerge)
 			new Noise(&params->np_floatland,    seed, csize.X, csize.Y + 2, csize.Z);
 	}
 
+	if (emerge->column_cache_size > 0) {
+		std::vector<Noise *> column_noises = {noise_terrain_persist,
+			noise_terrain_base, noise_terrain_alt, noise_height_select};
+		if (spflags & MGV7_MOUNTAINS)
+			column_noises.push_back(noise_mount_height);
+		m_column_cache = std::make_unique<ColumnNoiseCache>("MapgenV7",
+			std::move(column_noises), emerge->column_cache_size);
+	}
+
 	// 3D noise, 1 down overgeneration
 	MapgenBasic::np_cave1    = params->np_cave1;
 	MapgenBasic::np_cave2    = params->np_cave2;
@@ -435,7 +445,8 @@ bool MapgenV7::getMountainTerrainFromMap(int idx_xyz, int idx_xz, s16 y)
 {
 	float mounthn = std::fmax(noise_mount_height->result[idx_xz], 1.0f);
 	float density_gradient = -((float)(y - mount_zero_level) / mounthn);
-	float mountn = noise_mountain->result[idx_xyz];
+	float mountn = mountain_noise_skipped ? noise_mountain->np.offset :
+		noise_mountain->result[idx_xyz];
 
 	return mountn + density_gradient >= 0.0f;
 }
@@ -460,45 +471,114 @@ bool MapgenV7::getRiverChannelFromMap(int idx_xyz, int idx_xz, s16 y)
 
 bool MapgenV7::getFloatlandTerrainFromMap(int idx_xyz, float float_offset)
 {
-	return noise_floatland->result[idx_xyz] + floatland_density - float_offset >= 0.0f;
+	float floatn = floatland_noise_skipped ? noise_floatland->np.offset :
+		noise_floatland->result[idx_xyz];
+	return floatn + floatland_density - float_offset >= 0.0f;
 }
 
 
-int MapgenV7::generateTerrain()
+bool MapgenV7::mountainsDecidedByHeight(bool &all_air)
 {
-	MapNode n_air(CONTENT_AIR);
-	MapNode n_stone(c_stone);
-	MapNode n_water(c_water_source);
+	// In each column, the density gradient must keep the mountains either
+	// absent or solid over the whole height of the chunk, for any value of
+	// the noise
+	float mountn_min, mountn_max;
+	NoiseFractalBounds(&noise_mountain->np, mountn_min, mountn_max);
+
+	all_air = true;
+	for (u32 i = 0; i < (u32)csize.X * csize.Z; i++) {
+		float mounthn = std::fmax(noise_mount_height->result[i], 1.0f);
+		float gradient_bottom = -((float)(node_min.Y - 1 - mount_zero_level) / mounthn);
+		float gradient_top = -((float)(node_max.Y + 1 - mount_zero_level) / mounthn);
+		// Leave room for rounding
+		if (mountn_max + gradient_bottom < -0.001f * (1.0f + std::fabs(gradient_bottom)))
+			continue;
+		all_air = false;
+		if (mountn_min + gradient_top >= 0.001f * (1.0f + std::fabs(gradient_top)))
+			continue;
+		return false;
+	}
+	return true;
+}
 
-	//// Calculate noise for terrain generation
-	noise_terrain_persist->noiseMap2D(node_min.X, node_min.Z);
-	float *persistmap = noise_terrain_persist->result;
 
-	noise_terrain_base->noiseMap2D(node_min.X, node_min.Z, persistmap);
-	noise_terrain_alt->noiseMap2D(node_min.X, node_min.Z, persistmap);
-	noise_height_select->noiseMap2D(node_min.X, node_min.Z);
+bool MapgenV7::floatlandsDecidedByTaper(u8 num_y)
+{
+	// The taper must keep each layer either empty or solid
+	float floatn_min, floatn_max;
+	NoiseFractalBounds(&noise_floatland->np, floatn_min, floatn_max);
+
+	for (u8 i = 0; i < num_y; i++) {
+		float density = floatland_density - float_offset_cache[i];
+		float margin = 0.001f * (1.0f + std::fabs(density));
+		if (floatn_max + density >= -margin && floatn_min + density < margin)
+			return false;
+	}
+	return true;
+}
+
 
-	if (spflags & MGV7_MOUNTAINS) {
-		noise_mount_height->noiseMap2D(node_min.X, node_min.Z);
-		noise_mountain->noiseMap3D(node_min.X, node_min.Y - 1, node_min.Z);
+int MapgenV7::generateTerrain()
+{
+	//// Calculate noise for terrain generation
+	const v2s16 column(node_min.X, node_min.Z);
+	if (!m_column_cache || !m_column_cache->load(column)) {
+		// The noise maps are independent, apart from the persistence map
+		TaskGraph column_noises(m_emerge->taskpool);
+		TaskGraph::TaskId t_persist = column_noises.add([&] {
+			noise_terrain_persist->noiseMap2D(node_min.X, node_min.Z);
+		});
+		float *persistmap = noise_terrain_persist->result;
+		column_noises.add([&] {
+			noise_terrain_base->noiseMap2D(node_min.X, node_min.Z, persistmap);
+		}, {t_persist});
+		column_noises.add([&] {
+			noise_terrain_alt->noiseMap2D(node_min.X, node_min.Z, persistmap);
+		}, {t_persist});
+		column_noises.add([&] {
+			noise_height_select->noiseMap2D(node_min.X, node_min.Z);
+		});
+		if (spflags & MGV7_MOUNTAINS) {
+			column_noises.add([&] {
+				noise_mount_height->noiseMap2D(node_min.X, node_min.Z);
+			});
+		}
+		column_noises.run();
+
+		if (m_column_cache)
+			m_column_cache->store(column);
 	}
 
+	// The noise maps that depend on the height of the chunk are independent,
+	// apart from the ones listed as dependencies
+	TaskGraph noises(m_emerge->taskpool);
+
+	mountain_noise_skipped = false;
+	bool mountains_all_air = true;
+	TaskGraph::TaskId t_mountains = noises.add([&] {
+		if (!(spflags & MGV7_MOUNTAINS))
+			return;
+		mountain_noise_skipped = mountainsDecidedByHeight(mountains_all_air);
+		if (!mountain_noise_skipped)
+			noise_mountain->noiseMap3D(node_min.X, node_min.Y - 1, node_min.Z);
+	});
+
 	//// Floatlands
 	// 'Generate floatlands in this mapchunk' bool for
 	// simplification of condition checks in y-loop.
-	bool gen_floatlands = false;
-	u8 cache_index = 0;
+	bool gen_floatlands = (spflags & MGV7_FLOATLANDS) &&
+		node_max.Y >= floatland_ymin && node_min.Y <= floatland_ymax;
 	// Y values where floatland tapering starts
 	s16 float_taper_ymax = floatland_ymax - floatland_taper;
 	s16 float_taper_ymin = floatland_ymin + floatland_taper;
 
-	if ((spflags & MGV7_FLOATLANDS) &&
-			node_max.Y >= floatland_ymin && node_min.Y <= floatland_ymax) {
-		gen_floatlands = true;
-		// Calculate noise for floatland generation
-		noise_floatland->noiseMap3D(node_min.X, node_min.Y - 1, node_min.Z);
+	floatland_noise_skipped = false;
+	noises.add([&] {
+		if (!gen_floatlands)
+			return;
 
 		// Cache floatland noise offset values, for floatland tapering
+		u8 cache_index = 0;
 		for (s16 y = node_min.Y - 1; y <= node_max.Y + 1; y++, cache_index++) {
 			float float_offset = 0.0f;
 			if (y > float_taper_ymax) {
@@ -510,29 +590,74 @@ int MapgenV7::generateTerrain()
 			}
 			float_offset_cache[cache_index] = float_offset;
 		}
-	}
+
+		// Calculate noise for floatland generation
+		floatland_noise_skipped = floatlandsDecidedByTaper(cache_index);
+		if (!floatland_noise_skipped)
+			noise_floatland->noiseMap3D(node_min.X, node_min.Y - 1, node_min.Z);
+	});
 
 	// 'Generate rivers in this mapchunk' bool for
 	// simplification of condition checks in y-loop.
 	bool gen_rivers = (spflags & MGV7_RIDGES) && node_max.Y >= water_level - 16 &&
 		!gen_floatlands;
-	if (gen_rivers) {
-		noise_ridge->noiseMap3D(node_min.X, node_min.Y - 1, node_min.Z);
-		noise_ridge_uwater->noiseMap2D(node_min.X, node_min.Z);
-	}
+	TaskGraph::TaskId t_uwater = noises.add([&] {
+		if (gen_rivers)
+			noise_ridge_uwater->noiseMap2D(node_min.X, node_min.Z);
+	});
+	noises.add([&] {
+		if (!gen_rivers)
+			return;
+		// River channels only cut into terrain, and the ridge noise is only
+		// used within them
+		gen_rivers = false;
+		for (u32 i = 0; i < (u32)csize.X * csize.Z && !gen_rivers; i++) {
+			gen_rivers = std::fabs(noise_ridge_uwater->result[i]) * 2.0f <= 0.2f &&
+				(!mountains_all_air ||
+				(s16)baseTerrainLevelFromMap(i) >= node_min.Y - 1);
+		}
+		if (gen_rivers)
+			noise_ridge->noiseMap3D(node_min.X, node_min.Y - 1, node_min.Z);
+	}, {t_mountains, t_uwater});
+
+	noises.run();
 
 	//// Place nodes
+	// The columns are independent
+	s16 stone_surface_max_y = -MAX_MAP_GENERATION_LIMIT;
+	std::mutex surface_mutex;
+	parallel_for(m_emerge->taskpool, csize.Z, 4, [&] (size_t begin, size_t end) {
+		s16 max_y = generateTerrainRows(node_min.Z + begin, node_min.Z + end - 1,
+			gen_floatlands, gen_rivers);
+		std::lock_guard lock(surface_mutex);
+		stone_surface_max_y = std::max(stone_surface_max_y, max_y);
+	});
+
+	return stone_surface_max_y;
+}
+
+
+s16 MapgenV7::generateTerrainRows(s16 z_min, s16 z_max, bool gen_floatlands,
+	bool gen_rivers)
+{
+	MapNode n_air(CONTENT_AIR);
+	MapNode n_stone(c_stone);
+	MapNode n_water(c_water_source);
+
+	// Y values where floatland tapering starts
+	s16 float_taper_ymax = floatland_ymax - floatland_taper;
+
 	const v3s32 &em = vm->m_area.getExtent();
 	s16 stone_surface_max_y = -MAX_MAP_GENERATION_LIMIT;
-	u32 index2d = 0;
+	u32 index2d = (z_min - node_min.Z) * csize.X;
 
-	for (s16 z = node_min.Z; z <= node_max.Z; z++)
+	for (s16 z = z_min; z <= z_max; z++)
 	for (s16 x = node_min.X; x <= node_max.X; x++, index2d++) {
 		s16 surface_y = baseTerrainLevelFromMap(index2d);
 		if (surface_y > stone_surface_max_y)
 			stone_surface_max_y = surface_y;
 
-		cache_index = 0;
+		u8 cache_index = 0;
 		u32 vi = vm->m_area.index(x, node_min.Y - 1, z);
 		u32 index3d = (z - node_min.Z) * zstride_1u1d + (x - node_min.X);
 
@@ -81,7 +81,16 @@ class MapgenV7 : public MapgenBasic {
 	bool getRiverChannelFromMap(int idx_xyz, int idx_xz, s16 y);
 	bool getFloatlandTerrainFromMap(int idx_xyz, float float_offset);
 
+	// Whether the 3D noise can't change the terrain of the chunk, so that it
+	// doesn't need to be calculated
+	bool mountainsDecidedByHeight(bool &all_air);
+	bool floatlandsDecidedByTaper(u8 num_y);
+
 	int generateTerrain();
+	// Terrain of the columns with Z in [z_min, z_max], returns their
+	// highest stone
+	s16 generateTerrainRows(s16 z_min, s16 z_max, bool gen_floatlands,
+		bool gen_rivers);
 
 private:
 	s16 mount_zero_level;
@@ -94,6 +103,10 @@ class MapgenV7 : public MapgenBasic {
 
 	float *float_offset_cache = nullptr;
 
+	// The noise was skipped, its offset is used instead
+	bool mountain_noise_skipped = false;
+	bool floatland_noise_skipped = false;
+
 	Noise *noise_terrain_base = nullptr;
 	Noise *noise_terrain_alt = nullptr;
 	Noise *noise_terrain_persist = nullptr;
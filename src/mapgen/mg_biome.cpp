@@ -4,6 +4,7 @@
 // Copyright (C) 2014-2018 paramat
 
 #include "mg_biome.h"
+#include "mapgen.h"
 #include "mg_decoration.h"
 #include "emerge.h"
 #include "server.h"
@@ -11,6 +12,8 @@
 #include "settings.h"
 
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -136,6 +139,46 @@ BiomeGenOriginal::BiomeGenOriginal(BiomeManager *biomemgr,
 	values.erase(std::unique(values.begin(), values.end()), values.end());
 
 	m_transitions_y = std::move(values);
+
+	initBiomeBands();
+}
+
+void BiomeGenOriginal::initBiomeBands()
+{
+	// The set of biomes to check only changes at these Y values
+	std::vector<Biome *> biomes;
+	std::vector<s32> band_start;
+	for (size_t i = 1; i < m_bmgr->getNumObjects(); i++) {
+		Biome *b = (Biome *)m_bmgr->getRaw(i);
+		if (!b)
+			continue;
+		biomes.push_back(b);
+		band_start.push_back(b->min_pos.Y);
+		band_start.push_back(b->max_pos.Y + 1);
+		band_start.push_back(b->max_pos.Y + b->vertical_blend + 1);
+	}
+	std::sort(band_start.begin(), band_start.end());
+	band_start.erase(std::unique(band_start.begin(), band_start.end()),
+		band_start.end());
+
+	m_bands.clear();
+	for (size_t i = 0; i <= band_start.size(); i++) {
+		// Any Y value of the band
+		s32 y = i > 0 ? band_start[i - 1] :
+			band_start.empty() ? 0 : band_start[0] - 1;
+
+		std::vector<Biome *> within, blend;
+		for (Biome *b : biomes) {
+			if (y < b->min_pos.Y || y > b->max_pos.Y + b->vertical_blend)
+				continue;
+			if (y <= b->max_pos.Y)
+				within.push_back(b);
+			else
+				blend.push_back(b);
+		}
+		m_bands.push_back({BiomeLookup(within), BiomeLookup(blend)});
+	}
+	m_band_start = std::move(band_start);
 }
 
 BiomeGenOriginal::~BiomeGenOriginal()
@@ -178,10 +221,23 @@ Biome *BiomeGenOriginal::calcBiomeAtPoint(v3s16 pos) const
 }
 
 
+void BiomeGenOriginal::enableColumnCache(u16 size)
+{
+	m_column_cache.reset();
+	if (size > 0) {
+		m_column_cache = std::make_unique<ColumnNoiseCache>("BiomeGen",
+			std::vector<Noise *>{noise_heat, noise_humidity}, size);
+	}
+}
+
+
 void BiomeGenOriginal::calcBiomeNoise(v3s16 pmin)
 {
 	m_pmin = pmin;
 
+	if (m_column_cache && m_column_cache->load(v2s16(pmin.X, pmin.Z)))
+		return;
+
 	noise_heat->noiseMap2D(pmin.X, pmin.Z);
 	noise_humidity->noiseMap2D(pmin.X, pmin.Z);
 	noise_heat_blend->noiseMap2D(pmin.X, pmin.Z);
@@ -191,6 +247,9 @@ void BiomeGenOriginal::calcBiomeNoise(v3s16 pmin)
 		noise_heat->result[i]     += noise_heat_blend->result[i];
 		noise_humidity->result[i] += noise_humidity_blend->result[i];
 	}
+
+	if (m_column_cache)
+		m_column_cache->store(v2s16(pmin.X, pmin.Z));
 }
 
 
@@ -229,6 +288,23 @@ Biome *BiomeGenOriginal::getBiomeAtIndex(size_t index, v3s16 pos) const
 
 
 Biome *BiomeGenOriginal::calcBiomeFromNoise(float heat, float humidity, v3s16 pos) const
+{
+	const size_t band = std::upper_bound(m_band_start.begin(), m_band_start.end(),
+		(s32)pos.Y) - m_band_start.begin();
+
+	float dist_min = FLT_MAX;
+	float dist_min_blend = FLT_MAX;
+	Biome *biome_closest = m_bands[band].within.find(heat, humidity, pos, dist_min);
+	Biome *biome_closest_blend = m_bands[band].blend.find(heat, humidity, pos,
+		dist_min_blend);
+
+	return selectBiome(biome_closest, dist_min, biome_closest_blend,
+		dist_min_blend, heat, humidity, pos);
+}
+
+
+Biome *BiomeGenOriginal::calcBiomeFromNoiseLinear(float heat, float humidity,
+	v3s16 pos) const
 {
 	Biome *biome_closest = nullptr;
 	Biome *biome_closest_blend = nullptr;
@@ -260,6 +336,15 @@ Biome *BiomeGenOriginal::calcBiomeFromNoise(float heat, float humidity, v3s16 po
 		}
 	}
 
+	return selectBiome(biome_closest, dist_min, biome_closest_blend,
+		dist_min_blend, heat, humidity, pos);
+}
+
+
+Biome *BiomeGenOriginal::selectBiome(Biome *biome_closest, float dist_min,
+	Biome *biome_closest_blend, float dist_min_blend,
+	float heat, float humidity, v3s16 pos) const
+{
 	// Carefully tune pseudorandom seed variation to avoid single node dither
 	// and create larger scale blending patterns similar to horizontal biome
 	// blend.
@@ -267,18 +352,143 @@ Biome *BiomeGenOriginal::calcBiomeFromNoise(float heat, float humidity, v3s16 po
 	// undefined behavior if assigned to unsigned integer. Cast the result
 	// into signed integer before it is casted into unsigned integer to
 	// eliminate the undefined behavior.
-	const u64 seed = static_cast<s64>(pos.Y + (heat + humidity) * 0.9f);
-	PcgRandom rng(seed);
-
-	if (biome_closest_blend && dist_min_blend <= dist_min &&
-			rng.range(0, biome_closest_blend->vertical_blend) >=
-			pos.Y - biome_closest_blend->max_pos.Y)
-		return biome_closest_blend;
+	if (biome_closest_blend && dist_min_blend <= dist_min) {
+		const u64 seed = static_cast<s64>(pos.Y + (heat + humidity) * 0.9f);
+		PcgRandom rng(seed);
+		if (rng.range(0, biome_closest_blend->vertical_blend) >=
+				pos.Y - biome_closest_blend->max_pos.Y)
+			return biome_closest_blend;
+	}
 
 	return (biome_closest) ? biome_closest : (Biome *)m_bmgr->getRaw(BIOME_NONE);
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+
+BiomeLookup::BiomeLookup(const std::vector<Biome *> &biomes)
+{
+	auto add = [this] (Biome *b) {
+		m_heat_point.push_back(b->heat_point);
+		m_humidity_point.push_back(b->humidity_point);
+		m_weight.push_back(b->weight);
+		m_biomes.push_back(b);
+	};
+
+	if (biomes.size() >= MIN_GRID_BIOMES) {
+		float heat_min = FLT_MAX, heat_max = -FLT_MAX;
+		float humidity_min = FLT_MAX, humidity_max = -FLT_MAX;
+		for (Biome *b : biomes) {
+			heat_min = std::fmin(heat_min, b->heat_point);
+			heat_max = std::fmax(heat_max, b->heat_point);
+			humidity_min = std::fmin(humidity_min, b->humidity_point);
+			humidity_max = std::fmax(humidity_max, b->humidity_point);
+		}
+		// Leave room around the points, all biomes are checked outside the grid
+		float margin_heat = std::fmax((heat_max - heat_min) * 0.25f, 10.0f);
+		float margin_humidity = std::fmax((humidity_max - humidity_min) * 0.25f, 10.0f);
+		m_grid_size = GRID_SIZE;
+		m_heat_min = heat_min - margin_heat;
+		m_humidity_min = humidity_min - margin_humidity;
+		m_cell_heat = (heat_max - heat_min + 2 * margin_heat) / GRID_SIZE;
+		m_cell_humidity = (humidity_max - humidity_min + 2 * margin_humidity) / GRID_SIZE;
+	}
+
+	// Squared distances to the nearest and farthest point of a cell
+	auto get_dists = [] (const Biome *b, double heat0, double heat1,
+			double humidity0, double humidity1, double &dist_near, double &dist_far) {
+		double weight = b->weight > 0.f ? b->weight : 1.0;
+		double d_heat = std::fmax(0.0, std::fmax(heat0 - b->heat_point,
+			b->heat_point - heat1));
+		double d_humidity = std::fmax(0.0, std::fmax(humidity0 - b->humidity_point,
+			b->humidity_point - humidity1));
+		dist_near = (d_heat * d_heat + d_humidity * d_humidity) / weight;
+		d_heat = std::fmax(std::fabs(heat0 - b->heat_point),
+			std::fabs(heat1 - b->heat_point));
+		d_humidity = std::fmax(std::fabs(humidity0 - b->humidity_point),
+			std::fabs(humidity1 - b->humidity_point));
+		dist_far = (d_heat * d_heat + d_humidity * d_humidity) / weight;
+	};
+	// Whether the biome is in every column of the map
+	auto everywhere = [] (const Biome *b) {
+		return b->min_pos.X <= -MAX_MAP_GENERATION_LIMIT &&
+			b->max_pos.X >= MAX_MAP_GENERATION_LIMIT &&
+			b->min_pos.Z <= -MAX_MAP_GENERATION_LIMIT &&
+			b->max_pos.Z >= MAX_MAP_GENERATION_LIMIT;
+	};
+
+	std::vector<double> dists_near(biomes.size());
+	for (u32 cell = 0; cell < m_grid_size * m_grid_size; cell++) {
+		m_cell_start.push_back(m_biomes.size());
+
+		// With room for the rounding of the cell index
+		double heat0 = m_heat_min + (double)m_cell_heat * (cell % m_grid_size);
+		double humidity0 = m_humidity_min + (double)m_cell_humidity * (cell / m_grid_size);
+		double heat1 = heat0 + m_cell_heat * 1.001;
+		double humidity1 = humidity0 + m_cell_humidity * 1.001;
+		heat0 -= m_cell_heat * 0.001;
+		humidity0 -= m_cell_humidity * 0.001;
+
+		// A biome that is farther than another one from every point of the
+		// cell can't be the closest
+		double bound = HUGE_VAL;
+		for (size_t i = 0; i < biomes.size(); i++) {
+			double dist_far;
+			get_dists(biomes[i], heat0, heat1, humidity0, humidity1,
+				dists_near[i], dist_far);
+			if (everywhere(biomes[i]))
+				bound = std::fmin(bound, dist_far);
+		}
+		// Generous room for the rounding of the float distances
+		bound = bound * 1.0001 + 1e-6;
+		for (size_t i = 0; i < biomes.size(); i++) {
+			if (dists_near[i] <= bound)
+				add(biomes[i]);
+		}
+	}
+
+	m_cell_start.push_back(m_biomes.size());
+	for (Biome *b : biomes)
+		add(b);
+	m_cell_start.push_back(m_biomes.size());
+}
+
+
+Biome *BiomeLookup::find(float heat, float humidity, v3s16 pos,
+	float &dist_min) const
+{
+	// The cells only hold for columns that all biomes without X/Z limits are in
+	u32 cell = m_grid_size * m_grid_size;
+	if (m_grid_size > 0 &&
+			std::abs(pos.X) <= MAX_MAP_GENERATION_LIMIT &&
+			std::abs(pos.Z) <= MAX_MAP_GENERATION_LIMIT) {
+		float x = (heat - m_heat_min) / m_cell_heat;
+		float y = (humidity - m_humidity_min) / m_cell_humidity;
+		if (x >= 0.0f && x < m_grid_size && y >= 0.0f && y < m_grid_size)
+			cell = (u32)y * m_grid_size + (u32)x;
+	}
+
+	// Same distance and order as a linear search
+	Biome *biome_closest = nullptr;
+	for (u32 i = m_cell_start[cell]; i < m_cell_start[cell + 1]; i++) {
+		float d_heat = heat - m_heat_point[i];
+		float d_humidity = humidity - m_humidity_point[i];
+		float dist = ((d_heat * d_heat) + (d_humidity * d_humidity));
+		if (m_weight[i] > 0.f)
+			dist /= m_weight[i];
+		if (dist < dist_min) {
+			const Biome *b = m_biomes[i];
+			if (pos.X < b->min_pos.X || pos.X > b->max_pos.X ||
+					pos.Z < b->min_pos.Z || pos.Z > b->max_pos.Z)
+				continue;
+			dist_min = dist;
+			biome_closest = m_biomes[i];
+		}
+	}
+	return biome_closest;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 
 ObjDef *Biome::clone() const
@@ -10,10 +10,12 @@
 #include "nodedef.h"
 #include "noise.h"
 #include "debug.h" // FATAL_ERROR_IF
+#include <memory>
 
 class Server;
 class Settings;
 class BiomeManager;
+class ColumnNoiseCache;
 
 ////
 //// Biome
@@ -128,6 +130,9 @@ class BiomeGen {
 		return y == S16_MIN ? y : (y - 1);
 	};
 
+	// Keeps the noise of the latest `size` chunk columns for calcBiomeNoise.
+	virtual void enableColumnCache(u16 size) {}
+
 	// Result of calcBiomes bulk computation.
 	biome_t *biomemap = nullptr;
 
@@ -164,6 +169,43 @@ struct BiomeParamsOriginal : public BiomeParams {
 	NoiseParams np_humidity_blend;
 };
 
+/*
+	Finds the biome closest to a heat and humidity among a fixed list of
+	biomes, with the same result as checking them one after another.
+	The heat/humidity plane is split into a grid, and each cell only keeps
+	the biomes that can be the closest for a point in it.
+*/
+class BiomeLookup {
+public:
+	BiomeLookup() = default;
+	// `biomes` in the order they are checked in
+	BiomeLookup(const std::vector<Biome *> &biomes);
+
+	// Returns the closest biome that contains `pos` in X and Z, if it is
+	// closer than `dist_min`, and updates `dist_min`. Otherwise null.
+	Biome *find(float heat, float humidity, v3s16 pos, float &dist_min) const;
+
+private:
+	// Only worth it above this number of biomes
+	static constexpr size_t MIN_GRID_BIOMES = 8;
+	static constexpr u32 GRID_SIZE = 16;
+
+	// Candidates of each cell, followed by all biomes for points outside the
+	// grid. Structure of arrays for the distance loop.
+	std::vector<float> m_heat_point;
+	std::vector<float> m_humidity_point;
+	std::vector<float> m_weight;
+	std::vector<Biome *> m_biomes;
+	// The candidates of cell i are [m_cell_start[i], m_cell_start[i + 1])
+	std::vector<u32> m_cell_start;
+
+	u32 m_grid_size = 0;
+	float m_heat_min = 0.0f;
+	float m_humidity_min = 0.0f;
+	float m_cell_heat = 1.0f;
+	float m_cell_humidity = 1.0f;
+};
+
 class BiomeGenOriginal final : public BiomeGen {
 public:
 	BiomeGenOriginal(BiomeManager *biomemgr,
@@ -186,12 +228,22 @@ class BiomeGenOriginal final : public BiomeGen {
 	Biome *getBiomeAtIndex(size_t index, v3s16 pos) const;
 
 	Biome *calcBiomeFromNoise(float heat, float humidity, v3s16 pos) const;
+	// Same, but checks every biome instead of using the lookup tables
+	Biome *calcBiomeFromNoiseLinear(float heat, float humidity, v3s16 pos) const;
 	s16 getNextTransitionY(s16 y) const;
 
+	void enableColumnCache(u16 size);
+
 	float *heatmap;
 	float *humidmap;
 
 private:
+	void initBiomeBands();
+	// Picks the closest biome or the one whose blend area `pos` is in
+	Biome *selectBiome(Biome *biome_closest, float dist_min,
+		Biome *biome_closest_blend, float dist_min_blend,
+		float heat, float humidity, v3s16 pos) const;
+
 	const BiomeParamsOriginal *m_params;
 
 	Noise *noise_heat;
@@ -199,9 +251,21 @@ class BiomeGenOriginal final : public BiomeGen {
 	Noise *noise_heat_blend;
 	Noise *noise_humidity_blend;
 
+	std::unique_ptr<ColumnNoiseCache> m_column_cache;
+
 	/// Y values at which biomes may transition.
 	/// This array may only be used for downwards scanning!
 	std::vector<s16> m_transitions_y;
+
+	// Biomes that can be found in a band of Y values, within their Y limits
+	// or in the blend area above them
+	struct BiomeBand {
+		BiomeLookup within;
+		BiomeLookup blend;
+	};
+	// Band i covers the Y values in [m_band_start[i - 1], m_band_start[i])
+	std::vector<s32> m_band_start;
+	std::vector<BiomeBand> m_bands;
 };
 
 
@@ -37,12 +37,14 @@ DecorationManager::DecorationManager(IGameDef *gamedef) :
 void DecorationManager::placeAllDecos(Mapgen *mg, u32 blockseed,
 	v3s16 nmin, v3s16 nmax)
 {
+	DecoSurfaces surfaces(mg, nmin, nmax);
+
 	for (size_t i = 0; i != m_objects.size(); i++) {
 		Decoration *deco = (Decoration *)m_objects[i];
 		if (!deco)
 			continue;
 
-		deco->placeDeco(mg, blockseed, nmin, nmax);
+		deco->placeDeco(mg, blockseed, nmin, nmax, surfaces);
 		blockseed++;
 	}
 }
@@ -58,6 +60,105 @@ DecorationManager *DecorationManager::clone() const
 ///////////////////////////////////////////////////////////////////////////////
 
 
+DecoSurfaces::DecoSurfaces(Mapgen *mg, v3s16 nmin, v3s16 nmax) :
+	m_mg(mg),
+	m_nmin(nmin),
+	m_nmax(nmax),
+	m_size_x(nmax.X - nmin.X + 1)
+{
+	const size_t num_columns = m_size_x * (nmax.Z - nmin.Z + 1);
+	m_columns.resize(num_columns);
+	m_capacity.resize(num_columns, 0);
+	m_generation.resize(num_columns, 0);
+}
+
+
+DecoSurfaces::Column DecoSurfaces::get(v2s16 p2d)
+{
+	const u32 i = (p2d.Y - m_nmin.Z) * m_size_x + (p2d.X - m_nmin.X);
+	if (m_generation[i] != m_current_generation) {
+		scan(p2d, m_columns[i], m_capacity[i]);
+		m_generation[i] = m_current_generation;
+	}
+	return m_columns[i];
+}
+
+
+void DecoSurfaces::invalidate(v2s16 p2d, s16 reach)
+{
+	if (reach < 0) {
+		m_current_generation++;
+		return;
+	}
+
+	const int x_min = std::max<int>(p2d.X - reach, m_nmin.X);
+	const int x_max = std::min<int>(p2d.X + reach, m_nmax.X);
+	const int z_min = std::max<int>(p2d.Y - reach, m_nmin.Z);
+	const int z_max = std::min<int>(p2d.Y + reach, m_nmax.Z);
+	for (int z = z_min; z <= z_max; z++)
+	for (int x = x_min; x <= x_max; x++)
+		m_generation[(z - m_nmin.Z) * m_size_x + (x - m_nmin.X)] = 0;
+}
+
+
+void DecoSurfaces::scan(v2s16 p2d, Column &column, u16 &capacity)
+{
+	const NodeDefManager *ndef = m_mg->ndef;
+	MMVManip *vm = m_mg->vm;
+	const v3s32 &em = vm->m_area.getExtent();
+	u32 vi = vm->m_area.index(p2d.X, m_nmax.Y, p2d.Y);
+
+	// Floors go to the list right away, ceilings after them
+	const size_t end = m_surfaces.size();
+	m_ceilings.clear();
+	column.ground = -MAX_MAP_GENERATION_LIMIT;
+	column.liquid = -MAX_MAP_GENERATION_LIMIT;
+	bool liquid_done = false;
+	bool walkable_above = false;
+
+	for (s16 y = m_nmax.Y; y >= m_nmin.Y; y--) {
+		const ContentFeatures &f = ndef->get(vm->m_data[vi]);
+		if (f.walkable) {
+			if (column.ground == -MAX_MAP_GENERATION_LIMIT)
+				column.ground = y;
+			// Ground above liquids
+			liquid_done = true;
+		} else if (!liquid_done && f.isLiquid()) {
+			column.liquid = y;
+			liquid_done = true;
+		}
+
+		if (y != m_nmax.Y) {
+			if (f.walkable && !walkable_above)
+				m_surfaces.push_back(y);
+			else if (!f.walkable && walkable_above)
+				m_ceilings.push_back(y + 1);
+		}
+
+		walkable_above = f.walkable;
+		VoxelArea::add_y(em, vi, -1);
+	}
+
+	const size_t num_floors = m_surfaces.size() - end;
+	const size_t num = num_floors + m_ceilings.size();
+	m_surfaces.insert(m_surfaces.end(), m_ceilings.begin(), m_ceilings.end());
+	if (num <= capacity) {
+		// Replace the last surfaces of the column
+		std::copy(m_surfaces.begin() + end, m_surfaces.end(),
+			m_surfaces.begin() + column.begin);
+		m_surfaces.resize(end);
+	} else {
+		column.begin = end;
+		capacity = num;
+	}
+	column.num_floors = num_floors;
+	column.num_ceilings = m_ceilings.size();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+
 void Decoration::resolveNodeNames()
 {
 	getIdsFromNrBacklog(&c_place_on);
@@ -122,7 +223,8 @@ bool Decoration::canPlaceDecoration(MMVManip *vm, v3s16 p)
 }
 
 
-void Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax)
+void Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax,
+	DecoSurfaces &surfaces)
 {
 	// Skip if y ranges do not overlap
 	if (nmax.Y < y_min || y_max < nmin.Y)
@@ -141,17 +243,35 @@ void Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax)
 		sidelen = carea_size;
 
 	int area = sidelen * sidelen;
+	int num_parts = carea_size / sidelen;
+
+	// Noise at the centers of all parts
+	std::vector<float> nvals;
+	if (flags & DECO_USE_NOISE) {
+		nvals.resize(num_parts * num_parts);
+		NoiseFractal2DGrid(&np, nmin.X + sidelen / 2, nmin.Z + sidelen / 2,
+			sidelen, num_parts, num_parts, mapseed, nvals.data());
+	}
+
+	const s16 reach = getReach();
+	auto place = [&] (v3s16 pos, bool ceiling) {
+		size_t placed = generate(mg->vm, &ps, pos, ceiling);
+		if (placed)
+			mg->gennotify.addDecorationEvent(pos, index);
+		// L-system trees return 0 when they were placed
+		if (placed || reach < 0)
+			surfaces.invalidate(v2s16(pos.X, pos.Z), reach);
+	};
 
+	size_t part = 0;
 	for (s16 z0 = 0; z0 < carea_size; z0 += sidelen)
-	for (s16 x0 = 0; x0 < carea_size; x0 += sidelen) {
+	for (s16 x0 = 0; x0 < carea_size; x0 += sidelen, part++) {
 		v2s16 p2d_min(nmin.X + x0, nmin.Z + z0);
 		v2s16 p2d_max(nmin.X + x0 + sidelen - 1, nmin.Z + z0 + sidelen - 1);
 
 		bool cover = false;
 		// Amount of decorations
-		float nval = (flags & DECO_USE_NOISE) ?
-			NoiseFractal2D(&np, p2d_min.X + sidelen / 2, p2d_min.Y + sidelen / 2, mapseed) :
-			fill_ratio;
+		float nval = (flags & DECO_USE_NOISE) ? nvals[part] : fill_ratio;
 		u32 deco_count = 0;
 
 		if (nval >= 10.0f) {
@@ -196,46 +316,41 @@ void Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax)
 						continue;
 				}
 
-				// Get all floors and ceilings in node column
-				u16 size = (nmax.Y - nmin.Y + 1) / 2;
-				std::vector<s16> floors;
-				std::vector<s16> ceilings;
-				floors.reserve(size);
-				ceilings.reserve(size);
-
-				mg->getSurfaces(v2s16(x, z), nmin.Y, nmax.Y, floors, ceilings);
+				// Get all floors and ceilings in node column, from before
+				// placing any of the decorations
+				const DecoSurfaces::Column column = surfaces.get(v2s16(x, z));
+				const u32 floors_end = column.begin + column.num_floors;
+				const u32 ceilings_end = floors_end + column.num_ceilings;
 
 				if (flags & DECO_ALL_FLOORS) {
 					// Floor decorations
-					for (const s16 y : floors) {
+					for (u32 si = column.begin; si != floors_end; si++) {
+						s16 y = surfaces.getSurface(si);
 						if (y < y_min || y > y_max)
 							continue;
 
-						v3s16 pos(x, y, z);
-						if (generate(mg->vm, &ps, pos, false))
-							mg->gennotify.addDecorationEvent(pos, index);
+						place(v3s16(x, y, z), false);
 					}
 				}
 
 				if (flags & DECO_ALL_CEILINGS) {
 					// Ceiling decorations
-					for (const s16 y : ceilings) {
+					for (u32 si = floors_end; si != ceilings_end; si++) {
+						s16 y = surfaces.getSurface(si);
 						if (y < y_min || y > y_max)
 							continue;
 
-						v3s16 pos(x, y, z);
-						if (generate(mg->vm, &ps, pos, true))
-							mg->gennotify.addDecorationEvent(pos, index);
+						place(v3s16(x, y, z), true);
 					}
 				}
 			} else { // Heightmap decorations
 				s16 y = -MAX_MAP_GENERATION_LIMIT;
 				if (flags & DECO_LIQUID_SURFACE)
-					y = mg->findLiquidSurface(v2s16(x, z), nmin.Y, nmax.Y);
+					y = surfaces.get(v2s16(x, z)).liquid;
 				else if (mg->heightmap)
 					y = mg->heightmap[mapindex];
 				else
-					y = mg->findGroundLevel(v2s16(x, z), nmin.Y, nmax.Y);
+					y = surfaces.get(v2s16(x, z)).ground;
 
 				if (y < y_min || y > y_max || y < nmin.Y || y > nmax.Y)
 					continue;
@@ -246,9 +361,7 @@ void Decoration::placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax)
 						continue;
 				}
 
-				v3s16 pos(x, y, z);
-				if (generate(mg->vm, &ps, pos, false))
-					mg->gennotify.addDecorationEvent(pos, index);
+				place(v3s16(x, y, z), false);
 			}
 		}
 	}
@@ -450,6 +563,13 @@ size_t DecoSchematic::generate(MMVManip *vm, PcgRandom *pr, v3s16 p, bool ceilin
 	return 1;
 }
 
+
+s16 DecoSchematic::getReach() const
+{
+	// Placed at or centered around the position, in any rotation
+	return schematic ? std::max(schematic->size.X, schematic->size.Z) - 1 : 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ObjDef *DecoLSystem::clone() const
 {
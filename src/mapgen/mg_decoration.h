@@ -36,6 +36,55 @@ enum DecorationType {
 extern const FlagDesc flagdesc_deco[];
 
 
+/*
+	Surfaces of the node columns of a chunk, shared by all decorations placed
+	into it. A column is scanned when a decoration first looks at it, and again
+	after a decoration was placed into it, so that the surfaces are the same as
+	those of Mapgen::getSurfaces, findGroundLevel and findLiquidSurface.
+*/
+class DecoSurfaces {
+public:
+	struct Column {
+		// Floors, then ceilings in the list of surfaces, from top to bottom
+		u32 begin;
+		u16 num_floors;
+		u16 num_ceilings;
+		// -MAX_MAP_GENERATION_LIMIT if there is none
+		s16 ground;
+		s16 liquid;
+	};
+
+	DecoSurfaces(Mapgen *mg, v3s16 nmin, v3s16 nmax);
+
+	// `p2d` must be inside of the chunk. The surfaces of the returned column
+	// stay in the list until the next call.
+	Column get(v2s16 p2d);
+	s16 getSurface(u32 i) const { return m_surfaces[i]; }
+
+	// Columns that a decoration placed at `p2d` can have changed, all of
+	// them if `reach` is negative
+	void invalidate(v2s16 p2d, s16 reach);
+
+private:
+	void scan(v2s16 p2d, Column &column, u16 &capacity);
+
+	Mapgen *m_mg;
+	v3s16 m_nmin;
+	v3s16 m_nmax;
+	s16 m_size_x;
+
+	std::vector<Column> m_columns;
+	std::vector<u16> m_capacity;
+	// Columns are valid if their generation is the current one
+	std::vector<u32> m_generation;
+	u32 m_current_generation = 1;
+
+	std::vector<s16> m_surfaces;
+	std::vector<s16> m_ceilings;
+};
+
+
+
 class Decoration : public ObjDef, public NodeResolver {
 public:
 	Decoration() = default;
@@ -44,9 +93,13 @@ class Decoration : public ObjDef, public NodeResolver {
 	virtual void resolveNodeNames();
 
 	bool canPlaceDecoration(MMVManip *vm, v3s16 p);
-	void placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax);
+	void placeDeco(Mapgen *mg, u32 blockseed, v3s16 nmin, v3s16 nmax,
+		DecoSurfaces &surfaces);
 
 	virtual size_t generate(MMVManip *vm, PcgRandom *pr, v3s16 p, bool ceiling) = 0;
+	// Horizontal distance from `p` up to which generate() can change nodes,
+	// negative if unknown
+	virtual s16 getReach() const { return -1; }
 
 	u32 flags = 0;
 	int mapseed = 0;
@@ -74,6 +127,7 @@ class DecoSimple : public Decoration {
 
 	virtual void resolveNodeNames();
 	virtual size_t generate(MMVManip *vm, PcgRandom *pr, v3s16 p, bool ceiling);
+	virtual s16 getReach() const { return 0; }
 
 	std::vector<content_t> c_decos;
 	s16 deco_height;
@@ -91,6 +145,7 @@ class DecoSchematic : public Decoration {
 	virtual ~DecoSchematic();
 
 	virtual size_t generate(MMVManip *vm, PcgRandom *pr, v3s16 p, bool ceiling);
+	virtual s16 getReach() const;
 
 	Rotation rotation;
 	Schematic *schematic = nullptr;
@@ -377,51 +377,67 @@ void transformNodeBox(const MapNode &n, const NodeBox &nodebox,
 	}
 }
 
+template <typename F>
 static inline void getNeighborConnectingFace(
 	const v3s16 &p, const NodeDefManager *nodedef,
-	Map *map, MapNode n, u8 bitmask, u8 *neighbors)
+	F &&get_node, MapNode n, u8 bitmask, u8 *neighbors)
 {
-	MapNode n2 = map->getNode(p);
+	MapNode n2 = get_node(p);
 	if (nodedef->nodeboxConnects(n, n2, bitmask))
 		*neighbors |= bitmask;
 }
 
-u8 MapNode::getNeighbors(v3s16 p, Map *map) const
+template <typename F>
+static u8 getNeighborsImpl(MapNode n, v3s16 p, const NodeDefManager *nodedef,
+	F &&get_node)
 {
-	const NodeDefManager *nodedef = map->getNodeDefManager();
 	u8 neighbors = 0;
-	const ContentFeatures &f = nodedef->get(*this);
+	const ContentFeatures &f = nodedef->get(n);
 	// locate possible neighboring nodes to connect to
 	if (f.drawtype == NDT_NODEBOX && f.node_box.type == NODEBOX_CONNECTED) {
 		v3s16 p2 = p;
 
 		p2.Y++;
-		getNeighborConnectingFace(p2, nodedef, map, *this, 1, &neighbors);
+		getNeighborConnectingFace(p2, nodedef, get_node, n, 1, &neighbors);
 
 		p2 = p;
 		p2.Y--;
-		getNeighborConnectingFace(p2, nodedef, map, *this, 2, &neighbors);
+		getNeighborConnectingFace(p2, nodedef, get_node, n, 2, &neighbors);
 
 		p2 = p;
 		p2.Z--;
-		getNeighborConnectingFace(p2, nodedef, map, *this, 4, &neighbors);
+		getNeighborConnectingFace(p2, nodedef, get_node, n, 4, &neighbors);
 
 		p2 = p;
 		p2.X--;
-		getNeighborConnectingFace(p2, nodedef, map, *this, 8, &neighbors);
+		getNeighborConnectingFace(p2, nodedef, get_node, n, 8, &neighbors);
 
 		p2 = p;
 		p2.Z++;
-		getNeighborConnectingFace(p2, nodedef, map, *this, 16, &neighbors);
+		getNeighborConnectingFace(p2, nodedef, get_node, n, 16, &neighbors);
 
 		p2 = p;
 		p2.X++;
-		getNeighborConnectingFace(p2, nodedef, map, *this, 32, &neighbors);
+		getNeighborConnectingFace(p2, nodedef, get_node, n, 32, &neighbors);
 	}
 
 	return neighbors;
 }
 
+u8 MapNode::getNeighbors(v3s16 p, Map *map) const
+{
+	auto get_node = [map] (v3s16 p) {
+		return map->getNode(p);
+	};
+	return getNeighborsImpl(*this, p, map->getNodeDefManager(), get_node);
+}
+
+u8 MapNode::getNeighbors(v3s16 p, const NodeDefManager *nodedef,
+	const std::function<MapNode(v3s16)> &get_node) const
+{
+	return getNeighborsImpl(*this, p, nodedef, get_node);
+}
+
 void MapNode::getNodeBoxes(const NodeDefManager *nodemgr,
 	std::vector<aabb3f> *boxes, u8 neighbors) const
 {
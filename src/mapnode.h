@@ -7,6 +7,7 @@
 #include "irrlichttypes_bloated.h"
 #include "light.h"
 #include "util/pointer.h"
+#include <functional>
 #include <vector>
 
 class NodeDefManager;
@@ -255,6 +256,10 @@ struct alignas(u32) MapNode
 	 */
 	u8 getNeighbors(v3s16 p, Map *map) const;
 
+	//! Like above, but reading the neighbors with `get_node`
+	u8 getNeighbors(v3s16 p, const NodeDefManager *nodedef,
+		const std::function<MapNode(v3s16)> &get_node) const;
+
 	/*
 		Gets list of node boxes (used for rendering (NDT_NODEBOX))
 	*/
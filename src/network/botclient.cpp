@@ -0,0 +1,756 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "botclient.h"
+#include "activeobject.h"
+#include "constants.h"
+#include "exceptions.h"
+#include "log.h"
+#include "porting.h"
+#include "serialization.h"
+#include "settings.h"
+#include "version.h"
+#include "network/networkexceptions.h"
+#include "network/networkpacket.h"
+#include "network/networkprotocol.h"
+#include "util/auth.h"
+#include "util/numeric.h"
+#include "util/pointedthing.h"
+#include "util/serialize.h"
+#include "util/srp.h"
+#include "util/string.h"
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+// Walking speed of the bots [BS/s], slightly below the default player speed
+static constexpr float BOT_WALK_SPEED = 3.5f * BS;
+// Bots turn back when they get this far from where they joined [BS]
+static constexpr float BOT_WALK_RADIUS = 160.0f * BS;
+// Time between digs, and time taken for one [us]
+static constexpr u64 BOT_DIG_INTERVAL_US = 2000000;
+static constexpr u64 BOT_DIG_TIME_US = 1000000;
+// Block waits are given up on after this [us]
+static constexpr u64 BOT_BLOCK_WAIT_MAX_US = 60000000;
+// Number of sent positions remembered for object latency
+static constexpr size_t BOT_POSITION_HISTORY = 64;
+// Requested view range, in mapblocks
+static constexpr u8 BOT_WANTED_RANGE = 12;
+
+BotClient::BotClient(BotSwarm *swarm, const std::string &name,
+		const std::string &password, BotPattern pattern, u32 seed) :
+	m_swarm(swarm),
+	m_name(name),
+	m_password(password),
+	m_pattern(pattern),
+	m_rand(seed)
+{
+	m_yaw = m_rand.range(0, 359);
+}
+
+BotClient::~BotClient()
+{
+	if (m_auth_data)
+		srp_user_delete((SRPUser *) m_auth_data);
+	if (m_con)
+		m_con->Disconnect();
+}
+
+void BotClient::connect(const Address &address)
+{
+	m_con.reset(con::createMTP(CONNECTION_TIMEOUT, address.isIPv6(), this));
+	m_con->Connect(address);
+	m_connect_time_us = porting::getTimeUs();
+	sendInit();
+}
+
+void BotClient::deletingPeer(con::IPeer *peer, bool timeout)
+{
+	fail(timeout ? "Connection timed out" : "Connection closed");
+}
+
+void BotClient::fail(const std::string &error)
+{
+	if (m_state == State::Failed)
+		return;
+	m_state = State::Failed;
+	m_error = error;
+	infostream << "Bot " << m_name << ": " << error << std::endl;
+}
+
+void BotClient::send(NetworkPacket *pkt)
+{
+	// Same channels as serverCommandFactoryTable, which is part of the client
+	u8 channel = 0;
+	bool reliable = true;
+	switch (pkt->getCommand()) {
+	case TOSERVER_INIT:
+		channel = 1;
+		reliable = false;
+		break;
+	case TOSERVER_PLAYERPOS:
+		reliable = false;
+		break;
+	case TOSERVER_GOTBLOCKS:
+		channel = 2;
+		break;
+	case TOSERVER_INTERACT:
+		break;
+	default:
+		channel = 1;
+		break;
+	}
+	m_con->Send(PEER_ID_SERVER, channel, pkt, reliable);
+}
+
+void BotClient::sendInit()
+{
+	NetworkPacket pkt(TOSERVER_INIT, 1 + 2 + 2 + 2 + (2 + m_name.size()));
+	pkt << SER_FMT_VER_HIGHEST_READ << (u16) 0 /* unused */;
+	pkt << CLIENT_PROTOCOL_VERSION_MIN << LATEST_PROTOCOL_VERSION;
+	pkt << m_name;
+	send(&pkt);
+	m_last_init_us = porting::getTimeUs();
+}
+
+// Writes the player position fields of TOSERVER_PLAYERPOS and TOSERVER_INTERACT
+static v3f write_player_pos(NetworkPacket &pkt, v3f pos, v3f speed, float yaw)
+{
+	v3s32 position = v3s32::from(pos * 100);
+	pkt << position << v3s32::from(speed * 100) << (s32) 0 << (s32) (yaw * 100);
+	pkt << (u32) 0 << (u8) (1.3f * 80) << BOT_WANTED_RANGE << (u8) 0;
+	pkt << (f32) (speed == v3f() ? 0.0f : 1.0f) << (f32) 0.0f;
+
+	// What the server makes of it
+	return v3f((f32)position.X / 100.0f, (f32)position.Y / 100.0f,
+			(f32)position.Z / 100.0f);
+}
+
+void BotClient::sendPlayerPos(u64 now_us)
+{
+	NetworkPacket pkt(TOSERVER_PLAYERPOS, 12 + 12 + 4 + 4 + 4 + 1 + 1 + 1 + 4 + 4);
+	v3f sent = write_player_pos(pkt, m_pos, m_speed, m_yaw);
+	send(&pkt);
+
+	m_last_pos_send_us = now_us;
+	m_sent_positions.emplace_back(sent, now_us);
+	if (m_sent_positions.size() > BOT_POSITION_HISTORY)
+		m_sent_positions.pop_front();
+}
+
+void BotClient::sendInteract(u8 action, v3s16 node)
+{
+	v3s16 above = node + v3s16(0, 1, 0);
+	PointedThing pointed(node, above, node, intToFloat(node, BS),
+			v3f(0, 1, 0), 0, 0.0f, PointabilityType::POINTABLE);
+	std::ostringstream os(std::ios::binary);
+	pointed.serialize(os);
+
+	NetworkPacket pkt(TOSERVER_INTERACT, 1 + 2 + 0);
+	pkt << action << (u16) 0;
+	pkt.putLongString(os.str());
+	write_player_pos(pkt, m_pos, m_speed, m_yaw);
+	send(&pkt);
+}
+
+u64 BotClient::getPositionSendTime(v3f pos) const
+{
+	for (auto it = m_sent_positions.rbegin(); it != m_sent_positions.rend(); ++it) {
+		if (it->first == pos)
+			return it->second;
+	}
+	return 0;
+}
+
+void BotClient::step(u64 now_us)
+{
+	if (m_state == State::Failed || !m_con)
+		return;
+
+	NetworkPacket pkt;
+	for (;;) {
+		pkt.clear();
+		try {
+			if (!m_con->TryReceive(&pkt))
+				break;
+			if (pkt.getCommand() < TOCLIENT_NUM_MSG_TYPES)
+				handlePacket(&pkt, now_us);
+		} catch (const con::InvalidIncomingDataException &e) {
+			infostream << "Bot " << m_name << ": " << e.what() << std::endl;
+		} catch (const PacketError &e) {
+			infostream << "Bot " << m_name << ": " << e.what() << std::endl;
+		} catch (const SerializationError &e) {
+			infostream << "Bot " << m_name << ": " << e.what() << std::endl;
+		}
+		if (m_state == State::Failed)
+			return;
+	}
+
+	const float dtime = m_last_step_us ? (now_us - m_last_step_us) / 1e6f : 0.0f;
+	m_last_step_us = now_us;
+
+	if (m_state == State::Connecting) {
+		// TOSERVER_INIT is unreliable, repeat it until the server answers
+		if (now_us > m_connect_time_us + CONNECTION_TIMEOUT * 1000000ULL)
+			fail("No answer from server");
+		else if (now_us > m_last_init_us + 1000000)
+			sendInit();
+		return;
+	}
+
+	if (m_state != State::Joined || !m_pos_known)
+		return;
+
+	updateMovement(dtime, now_us);
+	updateDigging(now_us);
+
+	if (now_us - m_last_pos_send_us >= m_send_interval * 1e6f)
+		sendPlayerPos(now_us);
+
+	m_stats.rtt = m_con->getPeerStat(PEER_ID_SERVER, con::AVG_RTT);
+}
+
+void BotClient::handlePacket(NetworkPacket *pkt, u64 now_us)
+{
+	switch (pkt->getCommand()) {
+	case TOCLIENT_HELLO:
+		handleHello(pkt);
+		break;
+	case TOCLIENT_SRP_BYTES_S_B:
+		handleSrpBytesSandB(pkt);
+		break;
+	case TOCLIENT_AUTH_ACCEPT:
+		handleAuthAccept(pkt);
+		break;
+	case TOCLIENT_ACCESS_DENIED: {
+		u8 code = 0;
+		std::string reason;
+		if (pkt->getSize() >= 1)
+			*pkt >> code;
+		if (pkt->getRemainingBytes() > 0)
+			*pkt >> reason;
+		if (reason.empty())
+			reason = "code " + itos(code);
+		fail("Access denied: " + reason);
+		break;
+	}
+	case TOCLIENT_ANNOUNCE_MEDIA: {
+		// Definitions were received, skip the media and join right away
+		if (m_state != State::Loading)
+			break;
+		NetworkPacket resp_pkt(TOSERVER_CLIENT_READY, 1 + 1 + 1 + 1 + 2 + 2 + 2);
+		resp_pkt << (u8) VERSION_MAJOR << (u8) VERSION_MINOR << (u8) VERSION_PATCH
+			<< (u8) 0 << std::string("luanti-bot") << (u16) FORMSPEC_API_VERSION;
+		send(&resp_pkt);
+		m_state = State::Joined;
+		m_stats.join_time_us = now_us - m_connect_time_us;
+		break;
+	}
+	case TOCLIENT_MOVE_PLAYER: {
+		f32 pitch, yaw;
+		*pkt >> m_pos >> pitch >> yaw;
+		if (!m_pos_known) {
+			m_origin = m_pos;
+			m_pos_known = true;
+			m_last_blockpos = getContainerPos(floatToInt(m_pos, BS), MAP_BLOCKSIZE);
+			waitForBlocks(now_us);
+		}
+		break;
+	}
+	case TOCLIENT_BLOCKDATA:
+		handleBlockData(pkt, now_us);
+		break;
+	case TOCLIENT_ADDNODE:
+	case TOCLIENT_REMOVENODE: {
+		v3s16 p;
+		*pkt >> p;
+		handleBlockChange(getContainerPos(p, MAP_BLOCKSIZE), now_us);
+		break;
+	}
+	case TOCLIENT_NODE_CHANGES: {
+		v3s16 blockpos;
+		*pkt >> blockpos;
+		handleBlockChange(blockpos, now_us);
+		break;
+	}
+	case TOCLIENT_ACTIVE_OBJECT_REMOVE_ADD:
+		handleActiveObjectRemoveAdd(pkt);
+		break;
+	case TOCLIENT_ACTIVE_OBJECT_MESSAGES:
+		handleActiveObjectMessages(pkt, now_us);
+		break;
+	default:
+		break;
+	}
+}
+
+void BotClient::handleHello(NetworkPacket *pkt)
+{
+	if (m_state != State::Connecting)
+		return;
+
+	u16 unused_compression_mode;
+	u32 auth_mechs;
+	std::string unused;
+	*pkt >> m_ser_ver >> unused_compression_mode >> m_proto_ver
+		>> auth_mechs >> unused;
+
+	if (!ser_ver_supported_read(m_ser_ver)) {
+		fail("Unsupported serialization version");
+		return;
+	}
+
+	m_state = State::Authenticating;
+
+	// Same choice as the client
+	if (auth_mechs & AUTH_MECHANISM_SRP) {
+		// continued below
+	} else if (auth_mechs & AUTH_MECHANISM_FIRST_SRP) {
+		std::string verifier, salt;
+		generate_srp_verifier_and_salt(m_name, m_password, &verifier, &salt);
+
+		NetworkPacket resp_pkt(TOSERVER_FIRST_SRP, 0);
+		resp_pkt << salt << verifier << (u8)(m_password.empty() ? 1 : 0);
+		send(&resp_pkt);
+		return;
+	} else if (!(auth_mechs & AUTH_MECHANISM_LEGACY_PASSWORD)) {
+		fail("No supported authentication mechanism");
+		return;
+	}
+
+	u8 based_on = 1;
+	if (!(auth_mechs & AUTH_MECHANISM_SRP)) {
+		m_password = translate_password(m_name, m_password);
+		based_on = 0;
+	}
+
+	std::string name_lower = lowercase(m_name);
+	m_auth_data = srp_user_new(SRP_SHA256, SRP_NG_2048,
+		m_name.c_str(), name_lower.c_str(),
+		(const unsigned char *) m_password.c_str(),
+		m_password.length(), NULL, NULL);
+	char *bytes_A = 0;
+	size_t len_A = 0;
+	SRP_Result res = srp_user_start_authentication(
+		(struct SRPUser *) m_auth_data, NULL, NULL, 0,
+		(unsigned char **) &bytes_A, &len_A);
+	if (res != SRP_OK) {
+		fail("Creating local SRP user failed");
+		return;
+	}
+
+	NetworkPacket resp_pkt(TOSERVER_SRP_BYTES_A, 0);
+	resp_pkt << std::string(bytes_A, len_A) << based_on;
+	send(&resp_pkt);
+}
+
+void BotClient::handleSrpBytesSandB(NetworkPacket *pkt)
+{
+	if (!m_auth_data)
+		return;
+
+	std::string s, B;
+	*pkt >> s >> B;
+
+	char *bytes_M = 0;
+	size_t len_M = 0;
+	srp_user_process_challenge((SRPUser *) m_auth_data,
+		(const unsigned char *) s.c_str(), s.size(),
+		(const unsigned char *) B.c_str(), B.size(),
+		(unsigned char **) &bytes_M, &len_M);
+	if (!bytes_M) {
+		fail("SRP-6a S_B safety check violation");
+		return;
+	}
+
+	NetworkPacket resp_pkt(TOSERVER_SRP_BYTES_M, 0);
+	resp_pkt << std::string(bytes_M, len_M);
+	send(&resp_pkt);
+}
+
+void BotClient::handleAuthAccept(NetworkPacket *pkt)
+{
+	if (m_auth_data) {
+		srp_user_delete((SRPUser *) m_auth_data);
+		m_auth_data = nullptr;
+	}
+
+	v3f unused;
+	u64 unused_seed;
+	u32 unused_sudo_mechs;
+	*pkt >> unused >> unused_seed >> m_send_interval >> unused_sudo_mechs;
+	m_send_interval = std::max(m_send_interval, 0.01f);
+
+	NetworkPacket resp_pkt(TOSERVER_INIT2, sizeof(u16));
+	resp_pkt << std::string();
+	send(&resp_pkt);
+
+	m_state = State::Loading;
+}
+
+void BotClient::handleBlockData(NetworkPacket *pkt, u64 now_us)
+{
+	v3s16 p;
+	*pkt >> p;
+
+	// The contents are of no interest, only confirm that it arrived
+	NetworkPacket resp_pkt(TOSERVER_GOTBLOCKS, 1 + 6);
+	resp_pkt << (u8) 1 << p;
+	send(&resp_pkt);
+
+	m_stats.blocks++;
+	m_received_blocks.insert(p);
+
+	auto it = m_waiting_blocks.find(p);
+	if (it != m_waiting_blocks.end()) {
+		const u64 latency = now_us - it->second;
+		m_stats.block_samples++;
+		m_stats.block_latency_us += latency;
+		m_stats.block_latency_max_us = std::max(m_stats.block_latency_max_us, latency);
+		m_waiting_blocks.erase(it);
+	}
+
+	// Failed digs are answered with the whole block
+	handleBlockChange(p, now_us);
+}
+
+void BotClient::handleBlockChange(v3s16 blockpos, u64 now_us)
+{
+	if (!m_dig_pending || getContainerPos(m_dig_pos, MAP_BLOCKSIZE) != blockpos)
+		return;
+
+	m_dig_pending = false;
+	m_stats.dig_samples++;
+	m_stats.dig_latency_us += now_us - m_dig_completed_us;
+}
+
+void BotClient::handleActiveObjectRemoveAdd(NetworkPacket *pkt)
+{
+	u16 removed_count, added_count, id;
+	u8 type;
+
+	*pkt >> removed_count;
+	for (u16 i = 0; i < removed_count; i++) {
+		*pkt >> id;
+		m_players.erase(id);
+	}
+
+	*pkt >> added_count;
+	for (u16 i = 0; i < added_count; i++) {
+		*pkt >> id >> type;
+		std::istringstream is(pkt->readLongString(), std::ios::binary);
+		if (type != ACTIVEOBJECT_TYPE_GENERIC)
+			continue;
+
+		// See GenericCAO::initialize()
+		readU8(is); // version
+		std::string name = deSerializeString16(is);
+		if (readU8(is) != 0) // is_player
+			m_players[id] = std::move(name);
+	}
+}
+
+void BotClient::handleActiveObjectMessages(NetworkPacket *pkt, u64 now_us)
+{
+	std::string datastring(pkt->getString(0), pkt->getSize());
+	std::istringstream is(datastring, std::ios_base::binary);
+
+	while (is.good()) {
+		u16 id = readU16(is);
+		if (!is.good())
+			break;
+		std::string message = deSerializeString16(is);
+		m_stats.object_messages++;
+
+		if (message.size() < 1 + 12 || message[0] != AO_CMD_UPDATE_POSITION)
+			continue;
+		auto it = m_players.find(id);
+		if (it == m_players.end())
+			continue;
+		BotClient *other = m_swarm->getBot(it->second);
+		if (!other || other == this)
+			continue;
+
+		v3f pos = readV3F32(reinterpret_cast<const u8 *>(&message[1]));
+		u64 sent_us = other->getPositionSendTime(pos);
+		if (sent_us == 0 || sent_us > now_us)
+			continue;
+		const u64 latency = now_us - sent_us;
+		m_stats.object_samples++;
+		m_stats.object_latency_us += latency;
+		m_stats.object_latency_max_us = std::max(m_stats.object_latency_max_us, latency);
+	}
+}
+
+void BotClient::updateMovement(float dtime, u64 now_us)
+{
+	if (m_pattern != BotPattern::WALK) {
+		m_speed = v3f();
+		return;
+	}
+
+	m_turn_timer -= dtime;
+	if (m_turn_timer <= 0.0f) {
+		m_turn_timer = m_rand.range(5, 15);
+		if ((m_pos - m_origin).getLengthSQ() > BOT_WALK_RADIUS * BOT_WALK_RADIUS) {
+			// Head back
+			v3f dir = m_origin - m_pos;
+			m_yaw = std::atan2(-dir.X, dir.Z) * core::RADTODEG;
+		} else {
+			m_yaw = m_rand.range(0, 359);
+		}
+	}
+
+	// Players look along +Z at yaw 0, turning counterclockwise
+	const float yaw_rad = m_yaw * core::DEGTORAD;
+	m_speed = v3f(-std::sin(yaw_rad), 0, std::cos(yaw_rad)) * BOT_WALK_SPEED;
+	m_pos += m_speed * dtime;
+
+	v3s16 blockpos = getContainerPos(floatToInt(m_pos, BS), MAP_BLOCKSIZE);
+	if (blockpos != m_last_blockpos) {
+		m_last_blockpos = blockpos;
+		waitForBlocks(now_us);
+	}
+}
+
+void BotClient::updateDigging(u64 now_us)
+{
+	if (m_pattern != BotPattern::DIG)
+		return;
+
+	if (m_digging) {
+		if (now_us - m_dig_start_us < BOT_DIG_TIME_US)
+			return;
+		sendInteract(INTERACT_DIGGING_COMPLETED, m_dig_pos);
+		m_digging = false;
+		m_dig_pending = true;
+		m_dig_completed_us = now_us;
+		m_stats.digs++;
+		return;
+	}
+
+	if (now_us - m_dig_completed_us < BOT_DIG_INTERVAL_US)
+		return;
+
+	// Dig a few nodes deep next to the bot, then turn to the next side
+	const s16 depth = 1 + m_stats.digs % 4;
+	if (depth == 1)
+		m_yaw = std::fmod(m_yaw + 90.0f, 360.0f);
+	const float yaw_rad = m_yaw * core::DEGTORAD;
+	v3s16 dir(std::round(-std::sin(yaw_rad)), -depth, std::round(std::cos(yaw_rad)));
+	m_dig_pos = floatToInt(m_pos + v3f(0, 0.5f * BS, 0), BS) + dir;
+	m_dig_pending = false;
+
+	sendInteract(INTERACT_START_DIGGING, m_dig_pos);
+	m_digging = true;
+	m_dig_start_us = now_us;
+}
+
+void BotClient::waitForBlocks(u64 now_us)
+{
+	for (auto it = m_waiting_blocks.begin(); it != m_waiting_blocks.end();) {
+		if (now_us - it->second > BOT_BLOCK_WAIT_MAX_US)
+			it = m_waiting_blocks.erase(it);
+		else
+			++it;
+	}
+
+	v3s16 p;
+	for (p.Z = m_last_blockpos.Z - 1; p.Z <= m_last_blockpos.Z + 1; p.Z++)
+	for (p.Y = m_last_blockpos.Y - 1; p.Y <= m_last_blockpos.Y + 1; p.Y++)
+	for (p.X = m_last_blockpos.X - 1; p.X <= m_last_blockpos.X + 1; p.X++) {
+		if (m_received_blocks.count(p) == 0)
+			m_waiting_blocks.emplace(p, now_us);
+	}
+}
+
+/*
+	BotSwarm
+*/
+
+void BotSwarm::addBot(std::unique_ptr<BotClient> bot)
+{
+	m_by_name[bot->getName()] = bot.get();
+	m_bots.push_back(std::move(bot));
+}
+
+BotClient *BotSwarm::getBot(const std::string &name) const
+{
+	auto it = m_by_name.find(name);
+	return it == m_by_name.end() ? nullptr : it->second;
+}
+
+void BotSwarm::step(u64 now_us)
+{
+	for (auto &bot : m_bots)
+		bot->step(now_us);
+}
+
+u32 BotSwarm::getJoinedCount() const
+{
+	u32 count = 0;
+	for (auto &bot : m_bots)
+		count += bot->isJoined();
+	return count;
+}
+
+u32 BotSwarm::getFailedCount() const
+{
+	u32 count = 0;
+	for (auto &bot : m_bots)
+		count += bot->isFailed();
+	return count;
+}
+
+static float avg_ms(u64 total_us, u32 samples)
+{
+	return samples ? total_us / 1e3f / samples : 0.0f;
+}
+
+void BotSwarm::printStats(std::ostream &os) const
+{
+	BotClient::Stats total;
+	u32 joined = 0;
+
+	os << std::left << std::setw(20) << "bot" << std::right
+		<< std::setw(10) << "join ms" << std::setw(9) << "blocks"
+		<< std::setw(12) << "block avg" << std::setw(12) << "block max"
+		<< std::setw(9) << "ao msgs" << std::setw(10) << "ao avg"
+		<< std::setw(10) << "ao max" << std::setw(7) << "digs"
+		<< std::setw(10) << "dig avg" << std::setw(9) << "rtt ms" << std::endl;
+	os << std::fixed << std::setprecision(1);
+	for (auto &bot : m_bots) {
+		const BotClient::Stats &s = bot->getStats();
+		os << std::left << std::setw(20) << bot->getName() << std::right;
+		if (bot->isFailed() && s.join_time_us == 0) {
+			os << "  " << bot->getError() << std::endl;
+			continue;
+		}
+		os << std::setw(10) << s.join_time_us / 1e3f << std::setw(9) << s.blocks
+			<< std::setw(12) << avg_ms(s.block_latency_us, s.block_samples)
+			<< std::setw(12) << s.block_latency_max_us / 1e3f
+			<< std::setw(9) << s.object_messages
+			<< std::setw(10) << avg_ms(s.object_latency_us, s.object_samples)
+			<< std::setw(10) << s.object_latency_max_us / 1e3f
+			<< std::setw(7) << s.digs
+			<< std::setw(10) << avg_ms(s.dig_latency_us, s.dig_samples)
+			<< std::setw(9) << s.rtt * 1e3f;
+		if (bot->isFailed())
+			os << "  " << bot->getError();
+		os << std::endl;
+
+		joined++;
+		total.join_time_us += s.join_time_us;
+		total.blocks += s.blocks;
+		total.block_samples += s.block_samples;
+		total.block_latency_us += s.block_latency_us;
+		total.block_latency_max_us = std::max(total.block_latency_max_us, s.block_latency_max_us);
+		total.object_messages += s.object_messages;
+		total.object_samples += s.object_samples;
+		total.object_latency_us += s.object_latency_us;
+		total.object_latency_max_us = std::max(total.object_latency_max_us, s.object_latency_max_us);
+		total.digs += s.digs;
+		total.dig_samples += s.dig_samples;
+		total.dig_latency_us += s.dig_latency_us;
+	}
+
+	os << std::endl << joined << " of " << m_bots.size() << " bots joined"
+		<< ", average join " << avg_ms(total.join_time_us, joined) << "ms" << std::endl;
+	os << "Blocks: " << total.blocks << " received, latency average "
+		<< avg_ms(total.block_latency_us, total.block_samples) << "ms, max "
+		<< total.block_latency_max_us / 1e3f << "ms" << std::endl;
+	os << "Object messages: " << total.object_messages << " received, "
+		<< "position latency average "
+		<< avg_ms(total.object_latency_us, total.object_samples) << "ms, max "
+		<< total.object_latency_max_us / 1e3f << "ms" << std::endl;
+	if (total.digs > 0) {
+		os << "Digs: " << total.digs << ", answered " << total.dig_samples
+			<< ", latency average " << avg_ms(total.dig_latency_us, total.dig_samples)
+			<< "ms" << std::endl;
+	}
+}
+
+bool run_bots(const Settings &cmd_args)
+{
+	const u16 count = cmd_args.getU16("run-bots");
+
+	const std::string pattern_s = cmd_args.exists("bot-pattern") ?
+		cmd_args.get("bot-pattern") : "walk";
+	BotPattern pattern;
+	if (pattern_s == "idle") {
+		pattern = BotPattern::IDLE;
+	} else if (pattern_s == "walk") {
+		pattern = BotPattern::WALK;
+	} else if (pattern_s == "dig") {
+		pattern = BotPattern::DIG;
+	} else {
+		errorstream << "Invalid --bot-pattern value: " << pattern_s << std::endl;
+		return false;
+	}
+
+	const std::string address_s = cmd_args.exists("bot-address") ?
+		cmd_args.get("bot-address") : "127.0.0.1";
+	u16 port = 30000;
+	if (cmd_args.exists("port"))
+		port = cmd_args.getU16("port");
+	else
+		g_settings->getU16NoEx("port", port);
+
+	Address address;
+	try {
+		address.Resolve(address_s.c_str());
+	} catch (const ResolveError &e) {
+		errorstream << "Couldn't resolve " << address_s << ": " << e.what() << std::endl;
+		return false;
+	}
+	address.setPort(port);
+
+	const std::string name_prefix = cmd_args.exists("bot-name") ?
+		cmd_args.get("bot-name") : "bot";
+	const std::string password = cmd_args.exists("bot-password") ?
+		cmd_args.get("bot-password") : "";
+	const float duration = cmd_args.exists("bot-duration") ?
+		cmd_args.getFloat("bot-duration") : 60.0f;
+
+	actionstream << "Running " << count << " bots against ";
+	address.print(actionstream);
+	actionstream << " for " << duration << "s" << std::endl;
+
+	// Connect gradually, so that the server is not flooded with logins
+	constexpr u64 connect_interval_us = 50000;
+
+	BotSwarm swarm;
+	const u64 start_us = porting::getTimeUs();
+	const u64 end_us = start_us + duration * 1e6f;
+	u16 connected = 0;
+	u64 last_report_us = start_us;
+
+	volatile auto &kill = *porting::signal_handler_killstatus();
+	while (!kill) {
+		const u64 now_us = porting::getTimeUs();
+		if (now_us >= end_us)
+			break;
+
+		while (connected < count && now_us - start_us >= connected * connect_interval_us) {
+			auto bot = std::make_unique<BotClient>(&swarm,
+					name_prefix + itos(connected + 1), password, pattern, connected);
+			bot->connect(address);
+			swarm.addBot(std::move(bot));
+			connected++;
+		}
+
+		swarm.step(now_us);
+
+		if (now_us - last_report_us >= 10000000) {
+			last_report_us = now_us;
+			actionstream << swarm.getJoinedCount() << " of " << count << " bots joined, "
+				<< swarm.getFailedCount() << " failed" << std::endl;
+		}
+
+		sleep_ms(10);
+	}
+
+	swarm.printStats(rawstream);
+	return true;
+}
@@ -0,0 +1,186 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include "irr_v3d.h"
+#include "noise.h" // PcgRandom
+#include "network/address.h"
+#include "network/connection.h"
+#include "network/peerhandler.h"
+#include <deque>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class NetworkPacket;
+class Settings;
+class BotSwarm;
+
+enum class BotPattern : u8 {
+	// Only join and receive
+	IDLE,
+	// Walk around at walking speed, turning now and then
+	WALK,
+	// Stand still and dig the ground around
+	DIG,
+};
+
+/*
+	Minimal headless client for load testing a server.
+
+	Implements the handshake, SRP authentication and enough of the protocol
+	to keep the server sending blocks and objects, but does not decode any
+	map or object data. Latencies are measured on the client side:
+	- blocks: from entering a mapblock until it and its neighbors arrived
+	- objects: from another bot sending its position until the update arrives
+	- digs: from completing a dig until the node change arrives
+*/
+class BotClient final : public con::PeerHandler
+{
+public:
+	struct Stats {
+		u64 join_time_us = 0;
+
+		u32 blocks = 0;
+		u32 block_samples = 0;
+		u64 block_latency_us = 0;
+		u64 block_latency_max_us = 0;
+
+		u32 object_messages = 0;
+		u32 object_samples = 0;
+		u64 object_latency_us = 0;
+		u64 object_latency_max_us = 0;
+
+		u32 digs = 0;
+		u32 dig_samples = 0;
+		u64 dig_latency_us = 0;
+
+		float rtt = 0.0f;
+	};
+
+	BotClient(BotSwarm *swarm, const std::string &name, const std::string &password,
+			BotPattern pattern, u32 seed);
+	~BotClient();
+
+	void connect(const Address &address);
+	// Processes received packets and advances the scripted behaviour
+	void step(u64 now_us);
+
+	const std::string &getName() const { return m_name; }
+	bool isJoined() const { return m_state == State::Joined; }
+	bool isFailed() const { return m_state == State::Failed; }
+	const std::string &getError() const { return m_error; }
+	const Stats &getStats() const { return m_stats; }
+
+	// Returns the time this bot sent the given position, or 0 if unknown
+	u64 getPositionSendTime(v3f pos) const;
+
+	void peerAdded(con::IPeer *peer) override {}
+	void deletingPeer(con::IPeer *peer, bool timeout) override;
+
+private:
+	enum class State : u8 {
+		Connecting,
+		Authenticating,
+		Loading,
+		Joined,
+		Failed,
+	};
+
+	void send(NetworkPacket *pkt);
+	void sendInit();
+	void sendPlayerPos(u64 now_us);
+	void sendInteract(u8 action, v3s16 node);
+	void fail(const std::string &error);
+
+	void handlePacket(NetworkPacket *pkt, u64 now_us);
+	void handleHello(NetworkPacket *pkt);
+	void handleSrpBytesSandB(NetworkPacket *pkt);
+	void handleAuthAccept(NetworkPacket *pkt);
+	void handleBlockData(NetworkPacket *pkt, u64 now_us);
+	// Something in the given block changed, e.g. because of a dig
+	void handleBlockChange(v3s16 blockpos, u64 now_us);
+	void handleActiveObjectRemoveAdd(NetworkPacket *pkt);
+	void handleActiveObjectMessages(NetworkPacket *pkt, u64 now_us);
+
+	void updateMovement(float dtime, u64 now_us);
+	void updateDigging(u64 now_us);
+	// Starts waiting for the blocks around the current position
+	void waitForBlocks(u64 now_us);
+
+	BotSwarm *m_swarm;
+	const std::string m_name;
+	std::string m_password;
+	const BotPattern m_pattern;
+	PcgRandom m_rand;
+
+	std::unique_ptr<con::IConnection> m_con;
+	State m_state = State::Connecting;
+	std::string m_error;
+	u64 m_connect_time_us = 0;
+	u64 m_last_init_us = 0;
+	u64 m_last_step_us = 0;
+
+	u8 m_ser_ver = 0;
+	u16 m_proto_ver = 0;
+	void *m_auth_data = nullptr; // SRPUser
+	float m_send_interval = 0.1f;
+	u64 m_last_pos_send_us = 0;
+
+	// Position in BS units as the server last knows it
+	v3f m_pos;
+	bool m_pos_known = false;
+	float m_yaw = 0.0f;
+	float m_turn_timer = 0.0f;
+	v3s16 m_last_blockpos;
+
+	// Recently sent positions for object latency
+	std::deque<std::pair<v3f, u64>> m_sent_positions;
+
+	std::unordered_set<v3s16> m_received_blocks;
+	// Blocks that are waited for, with the time waiting started
+	std::unordered_map<v3s16, u64> m_waiting_blocks;
+	// Active object id -> name of the player it belongs to
+	std::unordered_map<u16, std::string> m_players;
+
+	v3f m_origin;
+	v3f m_speed;
+
+	u64 m_dig_start_us = 0;
+	u64 m_dig_completed_us = 0;
+	v3s16 m_dig_pos;
+	bool m_digging = false;
+	// Dig was completed, but no change arrived yet
+	bool m_dig_pending = false;
+
+	Stats m_stats;
+};
+
+/*
+	Set of bots run by a single thread
+*/
+class BotSwarm
+{
+public:
+	void addBot(std::unique_ptr<BotClient> bot);
+	BotClient *getBot(const std::string &name) const;
+
+	void step(u64 now_us);
+	u32 getJoinedCount() const;
+	u32 getFailedCount() const;
+
+	void printStats(std::ostream &os) const;
+
+private:
+	std::vector<std::unique_ptr<BotClient>> m_bots;
+	std::unordered_map<std::string, BotClient *> m_by_name;
+};
+
+// Runs the bots configured in `cmd_args` against a server
+bool run_bots(const Settings &cmd_args);
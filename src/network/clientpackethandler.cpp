@@ -257,6 +257,46 @@ void Client::handleCommand_AddNode(NetworkPacket* pkt)
 	addNode(p, n, !keep_metadata);
 }
 
+void Client::handleCommand_NodeChanges(NetworkPacket *pkt)
+{
+	v3s16 blockpos;
+	u16 count;
+	*pkt >> blockpos >> count;
+
+	const v3s16 p_base = blockpos * MAP_BLOCKSIZE;
+	const u32 node_len = MapNode::serializedLength(m_server_ser_ver);
+
+	// Apply all changes first so that each affected mesh is updated once
+	std::map<v3s16, MapBlock*> modified_blocks;
+	for (u16 i = 0; i < count; i++) {
+		u16 index;
+		*pkt >> index;
+
+		auto *ptr = reinterpret_cast<const u8*>(pkt->getRemainingString());
+		pkt->skip(node_len); // performs length check
+
+		MapNode n;
+		n.deSerialize(ptr, m_server_ser_ver);
+
+		bool keep_metadata;
+		*pkt >> keep_metadata;
+
+		if (index >= MAP_BLOCKSIZE * MAP_BLOCKSIZE * MAP_BLOCKSIZE)
+			continue;
+		v3s16 p = p_base + v3s16(index % MAP_BLOCKSIZE,
+				(index / MAP_BLOCKSIZE) % MAP_BLOCKSIZE,
+				index / (MAP_BLOCKSIZE * MAP_BLOCKSIZE));
+
+		try {
+			m_env.getMap().addNodeAndUpdate(p, n, modified_blocks, !keep_metadata);
+		} catch (InvalidPositionException &e) {
+		}
+	}
+
+	for (const auto &modified_block : modified_blocks)
+		addUpdateMeshTaskWithEdge(modified_block.first, false, true);
+}
+
 void Client::handleCommand_NodemetaChanged(NetworkPacket *pkt)
 {
 	if (pkt->getSize() < 1)
@@ -6,13 +6,15 @@
 #include "irrlichttypes.h"
 #include "networkprotocol.h" // session_t
 #include "socket.h" // Address
+#include <string>
 
 class NetworkPacket;
-class PeerHandler;
 
 namespace con
 {
 
+class PeerHandler;
+
 enum rtt_stat_type : int {
 	MIN_RTT,
 	MAX_RTT,
@@ -65,6 +67,9 @@ class IConnection
 	virtual Address GetPeerAddress(session_t peer_id) = 0;
 	virtual float getPeerStat(session_t peer_id, rtt_stat_type type) = 0;
 	virtual float getLocalStat(rate_stat_type type) = 0;
+
+	// Writes all received packets and peer changes to a file (see packetcapture.h)
+	virtual bool startPacketCapture(const std::string &path) = 0;
 };
 
 // MTP = Minetest Protocol
@@ -1479,14 +1479,30 @@ bool Connection::ReceiveTimeoutMs(NetworkPacket *pkt, u32 timeout_ms)
 			}
 
 			pkt->putRawPacket(*e.data, e.data.getSize(), e.peer_id);
+			if (m_capture) {
+				m_capture->write(PacketCaptureEvent::DATA, e.peer_id,
+					std::string_view(reinterpret_cast<char *>(*e.data), e.data.getSize()));
+			}
 			return true;
 		case CONNEVENT_PEER_ADDED: {
+			if (m_capture) {
+				std::string data = e.address.serializeString();
+				data.push_back(0);
+				char port[2];
+				writeU16(reinterpret_cast<u8 *>(port), e.address.getPort());
+				data.append(port, sizeof(port));
+				m_capture->write(PacketCaptureEvent::PEER_ADDED, e.peer_id, data);
+			}
 			UDPPeer tmp(e.peer_id, e.address, this);
 			if (m_bc_peerhandler)
 				m_bc_peerhandler->peerAdded(&tmp);
 			continue;
 		}
 		case CONNEVENT_PEER_REMOVED: {
+			if (m_capture) {
+				m_capture->write(PacketCaptureEvent::PEER_REMOVED, e.peer_id,
+					std::string(1, e.timeout ? 1 : 0));
+			}
 			UDPPeer tmp(e.peer_id, e.address, this);
 			if (m_bc_peerhandler)
 				m_bc_peerhandler->deletingPeer(&tmp, e.timeout);
@@ -1630,6 +1646,15 @@ void Connection::DisconnectPeer(session_t peer_id)
 	putCommand(ConnectionCommand::disconnect_peer(peer_id));
 }
 
+bool Connection::startPacketCapture(const std::string &path)
+{
+	auto capture = std::make_unique<PacketCaptureWriter>(path);
+	if (!capture->isOpen())
+		return false;
+	m_capture = std::move(capture);
+	return true;
+}
+
 void Connection::SetPeerID(session_t id)
 {
 	m_peer_id = id;
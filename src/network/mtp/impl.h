@@ -12,6 +12,7 @@
 #include "porting.h"
 #include "network/address.h"
 #include "network/networkprotocol.h"
+#include "network/packetcapture.h"
 #include <atomic>
 #include <cfloat>
 #include <vector>
@@ -248,6 +249,7 @@ class Connection final : public IConnection
 	u32 GetProtocolID() const { return m_protocol_id; };
 	const std::string getDesc();
 	void DisconnectPeer(session_t peer_id);
+	bool startPacketCapture(const std::string &path);
 
 protected:
 	PeerHelper getPeerNoEx(session_t peer_id);
@@ -302,6 +304,10 @@ class Connection final : public IConnection
 	// Backwards compatibility
 	PeerHandler *m_bc_peerhandler;
 
+	// Set up before the connection is used, afterwards only accessed by
+	// the thread calling ReceiveTimeoutMs()
+	std::unique_ptr<PacketCaptureWriter> m_capture;
+
 	std::atomic<bool> m_shutting_down = false;
 };
 
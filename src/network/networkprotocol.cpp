@@ -73,6 +73,7 @@
 		[scheduled bump for 5.14.0]
 	PROTOCOL VERSION 51
 		Only send first frame of animated item/wield images to older client
+		Add TOCLIENT_NODE_CHANGES
 		[scheduled bump for 5.15.0]
 */
 
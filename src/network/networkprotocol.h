@@ -701,7 +701,18 @@ enum ToClientCommand : u16
 			u8[len] serialized ParticleParameters
 	*/
 
-	TOCLIENT_NUM_MSG_TYPES = 0x65,
+	TOCLIENT_NODE_CHANGES = 0x65,
+	/*
+		Replaces TOCLIENT_ADDNODE/TOCLIENT_REMOVENODE for bulk edits
+		v3s16 block position
+		u16 count
+		for each change:
+			u16 node index inside the block (z * 256 + y * 16 + x)
+			serialized mapnode
+			u8 keep_metadata
+	*/
+
+	TOCLIENT_NUM_MSG_TYPES = 0x66,
 };
 
 enum ToServerCommand : u16
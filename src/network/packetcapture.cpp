@@ -0,0 +1,73 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "packetcapture.h"
+#include "exceptions.h"
+#include "log.h"
+#include "porting.h"
+#include "util/serialize.h"
+
+namespace con
+{
+
+static constexpr u32 CAPTURE_MAGIC = 0x4C504341; // "LPCA"
+static constexpr u16 CAPTURE_VERSION = 1;
+
+PacketCaptureWriter::PacketCaptureWriter(const std::string &path) :
+	m_os(path, std::ios::binary | std::ios::trunc),
+	m_start_us(porting::getTimeUs())
+{
+	if (!m_os.good()) {
+		errorstream << "PacketCaptureWriter: failed to open " << path << std::endl;
+		return;
+	}
+
+	writeU32(m_os, CAPTURE_MAGIC);
+	writeU16(m_os, CAPTURE_VERSION);
+	writeU16(m_os, LATEST_PROTOCOL_VERSION);
+}
+
+void PacketCaptureWriter::write(PacketCaptureEvent::Type type, session_t peer_id,
+		std::string_view data)
+{
+	if (!m_os.good())
+		return;
+
+	writeU64(m_os, porting::getTimeUs() - m_start_us);
+	writeU8(m_os, type);
+	writeU16(m_os, peer_id);
+	m_os << serializeString32(data);
+}
+
+PacketCaptureReader::PacketCaptureReader(const std::string &path) :
+	m_is(path, std::ios::binary)
+{
+	if (!m_is.good())
+		return;
+
+	if (readU32(m_is) != CAPTURE_MAGIC || readU16(m_is) != CAPTURE_VERSION) {
+		errorstream << "PacketCaptureReader: " << path
+			<< " is not a supported packet capture" << std::endl;
+		m_is.setstate(std::ios::failbit);
+		return;
+	}
+	m_protocol_version = readU16(m_is);
+}
+
+bool PacketCaptureReader::read(PacketCaptureEvent &event)
+{
+	if (!m_is.good() || m_is.peek() == EOF)
+		return false;
+
+	event.time_us = readU64(m_is);
+	u8 type = readU8(m_is);
+	event.peer_id = readU16(m_is);
+	if (!m_is.good() || type > PacketCaptureEvent::PEER_REMOVED)
+		throw SerializationError("PacketCaptureReader: corrupt event header");
+	event.type = static_cast<PacketCaptureEvent::Type>(type);
+	event.data = deSerializeString32(m_is);
+	return true;
+}
+
+} // namespace
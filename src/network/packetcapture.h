@@ -0,0 +1,81 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include "networkprotocol.h" // session_t
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace con
+{
+
+/*
+	Packet capture files contain everything a connection handed to its user
+	(incoming packets and peer changes), so that it can be replayed later.
+
+	u32 magic "LPCA"
+	u16 format version
+	u16 protocol version of the recording server
+	for each event:
+		u64 time since start of recording [us]
+		u8 type (PacketCaptureEvent::Type)
+		u16 peer id
+		u32 len
+		u8[len] data:
+			DATA: raw packet including command
+			PEER_ADDED: address string, \0, u16 port
+			PEER_REMOVED: u8 timeout
+*/
+
+struct PacketCaptureEvent
+{
+	enum Type : u8 {
+		DATA = 0,
+		PEER_ADDED = 1,
+		PEER_REMOVED = 2,
+	};
+
+	u64 time_us = 0;
+	Type type = DATA;
+	session_t peer_id = 0;
+	std::string data;
+};
+
+class PacketCaptureWriter
+{
+public:
+	PacketCaptureWriter(const std::string &path);
+
+	bool isOpen() const { return m_os.good(); }
+
+	// Not thread-safe, only to be called from the thread receiving packets
+	void write(PacketCaptureEvent::Type type, session_t peer_id,
+			std::string_view data);
+
+private:
+	std::ofstream m_os;
+	u64 m_start_us;
+};
+
+class PacketCaptureReader
+{
+public:
+	PacketCaptureReader(const std::string &path);
+
+	bool isOpen() const { return m_is.good(); }
+	u16 getProtocolVersion() const { return m_protocol_version; }
+
+	// Returns false at the end of the file
+	// throws SerializationError on truncated/corrupt files
+	bool read(PacketCaptureEvent &event);
+
+private:
+	std::ifstream m_is;
+	u16 m_protocol_version = 0;
+};
+
+} // namespace
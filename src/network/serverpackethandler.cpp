@@ -286,10 +286,10 @@ void Server::handleCommand_Init2(NetworkPacket* pkt)
 		std::endl;
 
 	// Send item definitions
-	SendItemDef(peer_id, m_itemdef, protocol_version);
+	SendItemDef(peer_id, protocol_version);
 
 	// Send node definitions
-	SendNodeDef(peer_id, m_nodedef, protocol_version);
+	SendNodeDef(peer_id, protocol_version);
 
 	m_clients.event(peer_id, CSE_SetDefinitionsSent);
 
@@ -1660,7 +1660,9 @@ void Server::handleCommand_SrpBytesM(NetworkPacket* pkt)
 	srp_verifier_verify_session((SRPVerifier *) client->auth_data,
 		(unsigned char *)bytes_M.c_str(), &bytes_HAMK);
 
-	if (!bytes_HAMK) {
+	// A replayed proof can never match the new session, but the client
+	// successfully authenticated when the packets were captured.
+	if (!bytes_HAMK && !m_packet_replay) {
 		if (wantSudo) {
 			actionstream << "Server: User " << playername << " at " << addr_s
 				<< " tried to change their password, but supplied wrong"
@@ -15,6 +15,7 @@
 #include "debug.h"
 #include "gamedef.h"
 #include "mapnode.h"
+#include "threading/parallel.h"
 #include <algorithm>
 #include <cmath>
 #if CHECK_CLIENT_BUILD()
@@ -1249,20 +1250,24 @@ void NodeDefManager::resetNodeResolveState()
 
 void NodeDefManager::resolveCrossrefs()
 {
-	for (ContentFeatures &f : m_content_features) {
-		if (f.isLiquid() || f.isLiquidRender()) {
-			f.liquid_alternative_flowing_id = getId(f.liquid_alternative_flowing);
-			f.liquid_alternative_source_id = getId(f.liquid_alternative_source);
-			continue;
-		}
-		if (f.drawtype != NDT_NODEBOX || f.node_box.type != NODEBOX_CONNECTED)
-			continue;
+	// Every node only writes to itself and reads the name mappings
+	parallel_for(m_content_features.size(), 1024, [this] (size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			ContentFeatures &f = m_content_features[i];
+			if (f.isLiquid() || f.isLiquidRender()) {
+				f.liquid_alternative_flowing_id = getId(f.liquid_alternative_flowing);
+				f.liquid_alternative_source_id = getId(f.liquid_alternative_source);
+				continue;
+			}
+			if (f.drawtype != NDT_NODEBOX || f.node_box.type != NODEBOX_CONNECTED)
+				continue;
 
-		for (const std::string &name : f.connects_to) {
-			getIds(name, f.connects_to_ids);
+			for (const std::string &name : f.connects_to) {
+				getIds(name, f.connects_to_ids);
+			}
+			SORT_AND_UNIQUE(f.connects_to_ids);
 		}
-		SORT_AND_UNIQUE(f.connects_to_ids);
-	}
+	});
 }
 
 bool NodeDefManager::nodeboxConnects(MapNode from, MapNode to,
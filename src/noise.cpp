@@ -27,6 +27,8 @@
 #include "noise.h"
 #include <iostream>
 #include <cstring> // memset
+#include <algorithm>
+#include <atomic>
 #include "debug.h"
 #include "util/numeric.h"
 #include "util/string.h"
@@ -171,23 +173,36 @@ void PcgRandom::setState(const u64 state[2])
 
 ///////////////////////////////////////////////////////////////////////////////
 
-float noise2d(int x, int y, s32 seed)
+static inline float noiseFromHash(unsigned int n)
 {
-	unsigned int n = (NOISE_MAGIC_X * x + NOISE_MAGIC_Y * y
-			+ NOISE_MAGIC_SEED * seed) & 0x7fffffff;
+	n &= 0x7fffffff;
 	n = (n >> 13) ^ n;
 	n = (n * (n * n * 60493 + 19990303) + 1376312589) & 0x7fffffff;
 	return 1.f - (float)(int)n / 0x40000000;
 }
 
+static inline float noise2dInline(int x, int y, s32 seed)
+{
+	return noiseFromHash(NOISE_MAGIC_X * x + NOISE_MAGIC_Y * y
+			+ NOISE_MAGIC_SEED * seed);
+}
+
+static inline float noise3dInline(int x, int y, int z, s32 seed)
+{
+	return noiseFromHash(NOISE_MAGIC_X * x + NOISE_MAGIC_Y * y + NOISE_MAGIC_Z * z
+			+ NOISE_MAGIC_SEED * seed);
+}
+
+
+float noise2d(int x, int y, s32 seed)
+{
+	return noise2dInline(x, y, seed);
+}
+
 
 float noise3d(int x, int y, int z, s32 seed)
 {
-	unsigned int n = (NOISE_MAGIC_X * x + NOISE_MAGIC_Y * y + NOISE_MAGIC_Z * z
-			+ NOISE_MAGIC_SEED * seed) & 0x7fffffff;
-	n = (n >> 13) ^ n;
-	n = (n * (n * n * 60493 + 19990303) + 1376312589) & 0x7fffffff;
-	return 1.f - (float)(int)n / 0x40000000;
+	return noise3dInline(x, y, z, seed);
 }
 
 
@@ -364,6 +379,29 @@ float NoiseFractal3D(const NoiseParams *np, float x, float y, float z, s32 seed)
 }
 
 
+void NoiseFractalBounds(const NoiseParams *np, float &min, float &max)
+{
+	// Each octave is within [-1, 1], or [0, 1] for absvalue, times its
+	// amplitude, which can be negative
+	const bool absvalue = np->flags & NOISE_FLAG_ABSVALUE;
+	float low = 0.0f, high = 0.0f;
+	float g = 1.0f;
+	for (size_t i = 0; i < np->octaves; i++) {
+		low += absvalue ? std::fmin(g, 0.0f) : -std::fabs(g);
+		high += absvalue ? std::fmax(g, 0.0f) : std::fabs(g);
+		g *= np->persist;
+	}
+	// Leave room for rounding
+	low = low * 1.001f - 0.001f;
+	high = high * 1.001f + 0.001f;
+
+	float a = np->offset + low * np->scale;
+	float b = np->offset + high * np->scale;
+	min = std::fmin(a, b);
+	max = std::fmax(a, b);
+}
+
+
 Noise::Noise(const NoiseParams *np_, s32 seed, u32 sx, u32 sy, u32 sz)
 {
 	np = *np_;
@@ -481,6 +519,257 @@ void Noise::resizeNoiseBuf(bool is3d)
 }
 
 
+///////////////////////// [ Noise map kernels ] //////////////////////////////
+
+/*
+ * The inner loops of the noise maps. On x86 they are compiled twice, for the
+ * baseline instruction set and for AVX2, and the AVX2 version is used if the
+ * CPU has it. Other platforms (e.g. NEON on ARM) only get the baseline
+ * version, which the compiler vectorizes.
+ * The loops only use plain float arithmetic, which gives the same results
+ * with either instruction set, so the terrain does not depend on the CPU.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define NOISE_DISPATCH_AVX2 1
+	#define NOISE_KERNEL_INLINE inline __attribute__((always_inline))
+#else
+	#define NOISE_DISPATCH_AVX2 0
+	#define NOISE_KERNEL_INLINE inline
+#endif
+
+static std::atomic<bool> g_noise_simd(true);
+
+bool noise_simd_available()
+{
+#if NOISE_DISPATCH_AVX2
+	static const bool has_avx2 = [] {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+	}();
+	return has_avx2;
+#else
+	return false;
+#endif
+}
+
+void noise_simd_enable(bool enable)
+{
+	g_noise_simd = enable;
+}
+
+#if NOISE_DISPATCH_AVX2
+	// Defines the kernel `name`, which calls the AVX2 or baseline version of
+	// nameImpl
+	#define NOISE_KERNEL(name, params, args) \
+		__attribute__((target("avx2"))) static void name##AVX2 params \
+		{ \
+			name##Impl args; \
+		} \
+		static void name params \
+		{ \
+			if (g_noise_simd.load(std::memory_order_relaxed) && noise_simd_available()) \
+				name##AVX2 args; \
+			else \
+				name##Impl args; \
+		}
+#else
+	#define NOISE_KERNEL(name, params, args) \
+		static void name params \
+		{ \
+			name##Impl args; \
+		}
+#endif
+
+static NOISE_KERNEL_INLINE void fillLattice2DImpl(float *buf,
+		u32 nlx, u32 nly, s32 x0, s32 y0, s32 seed)
+{
+	for (u32 j = 0; j != nly; j++)
+		for (u32 i = 0; i != nlx; i++)
+			*buf++ = noise2dInline(x0 + i, y0 + j, seed);
+}
+NOISE_KERNEL(fillLattice2D,
+	(float *buf, u32 nlx, u32 nly, s32 x0, s32 y0, s32 seed),
+	(buf, nlx, nly, x0, y0, seed))
+
+static NOISE_KERNEL_INLINE void fillLattice3DImpl(float *buf,
+		u32 nlx, u32 nly, u32 nlz, s32 x0, s32 y0, s32 z0, s32 seed)
+{
+	for (u32 k = 0; k != nlz; k++)
+		for (u32 j = 0; j != nly; j++)
+			for (u32 i = 0; i != nlx; i++)
+				*buf++ = noise3dInline(x0 + i, y0 + j, z0 + k, seed);
+}
+NOISE_KERNEL(fillLattice3D,
+	(float *buf, u32 nlx, u32 nly, u32 nlz, s32 x0, s32 y0, s32 z0, s32 seed),
+	(buf, nlx, nly, nlz, x0, y0, z0, seed))
+
+// Values along a lattice line, at the positions given by cell and frac
+static NOISE_KERNEL_INLINE void interpolateLineImpl(float *out, const float *line,
+		const u32 *cell, const float *frac, u32 n)
+{
+	for (u32 i = 0; i != n; i++)
+		out[i] = linearInterpolation(line[cell[i]], line[cell[i] + 1], frac[i]);
+}
+NOISE_KERNEL(interpolateLine,
+	(float *out, const float *line, const u32 *cell, const float *frac, u32 n),
+	(out, line, cell, frac, n))
+
+// Rows of a 2D map from the lines before and after them
+static NOISE_KERNEL_INLINE void interpolateRow2DImpl(float *out,
+		const float *l0, const float *l1, u32 n, float y)
+{
+	for (u32 i = 0; i != n; i++)
+		out[i] = linearInterpolation(l0[i], l1[i], y);
+}
+NOISE_KERNEL(interpolateRow2D,
+	(float *out, const float *l0, const float *l1, u32 n, float y),
+	(out, l0, l1, n, y))
+
+// Rows of a 3D map from the four lines around them, in the same order of
+// operations as triLinearInterpolation
+static NOISE_KERNEL_INLINE void interpolateRow3DImpl(float *out,
+		const float *l00, const float *l10, const float *l01, const float *l11,
+		u32 n, float y, float z)
+{
+	for (u32 i = 0; i != n; i++) {
+		float u = linearInterpolation(l00[i], l10[i], y);
+		float v = linearInterpolation(l01[i], l11[i], y);
+		out[i] = linearInterpolation(u, v, z);
+	}
+}
+NOISE_KERNEL(interpolateRow3D,
+	(float *out, const float *l00, const float *l10, const float *l01,
+		const float *l11, u32 n, float y, float z),
+	(out, l00, l10, l01, l11, n, y, z))
+
+// Adds the values of an octave to the result
+template <bool absvalue>
+static NOISE_KERNEL_INLINE void addOctaveT(float *result, const float *values,
+		float g, size_t n)
+{
+	for (size_t i = 0; i != n; i++)
+		result[i] += g * (absvalue ? std::fabs(values[i]) : values[i]);
+}
+static NOISE_KERNEL_INLINE void addOctaveImpl(float *result, const float *values,
+		float g, size_t n)
+{
+	addOctaveT<false>(result, values, g, n);
+}
+static NOISE_KERNEL_INLINE void addOctaveAbsImpl(float *result, const float *values,
+		float g, size_t n)
+{
+	addOctaveT<true>(result, values, g, n);
+}
+NOISE_KERNEL(addOctave,
+	(float *result, const float *values, float g, size_t n),
+	(result, values, g, n))
+NOISE_KERNEL(addOctaveAbs,
+	(float *result, const float *values, float g, size_t n),
+	(result, values, g, n))
+
+// Same with a persistence map
+template <bool absvalue>
+static NOISE_KERNEL_INLINE void addOctaveMapT(float *result, const float *values,
+		float *gmap, const float *persistence_map, size_t n)
+{
+	for (size_t i = 0; i != n; i++) {
+		result[i] += gmap[i] * (absvalue ? std::fabs(values[i]) : values[i]);
+		gmap[i] *= persistence_map[i];
+	}
+}
+static NOISE_KERNEL_INLINE void addOctaveMapImpl(float *result, const float *values,
+		float *gmap, const float *persistence_map, size_t n)
+{
+	addOctaveMapT<false>(result, values, gmap, persistence_map, n);
+}
+static NOISE_KERNEL_INLINE void addOctaveMapAbsImpl(float *result, const float *values,
+		float *gmap, const float *persistence_map, size_t n)
+{
+	addOctaveMapT<true>(result, values, gmap, persistence_map, n);
+}
+NOISE_KERNEL(addOctaveMap,
+	(float *result, const float *values, float *gmap, const float *persistence_map, size_t n),
+	(result, values, gmap, persistence_map, n))
+NOISE_KERNEL(addOctaveMapAbs,
+	(float *result, const float *values, float *gmap, const float *persistence_map, size_t n),
+	(result, values, gmap, persistence_map, n))
+
+// Value noise at the points (x * f, y * f), like noise2d_value
+template <bool eased>
+static NOISE_KERNEL_INLINE void valueNoise2DT(float *out, const float *x,
+		const float *y, float f, u32 n, s32 seed)
+{
+	for (u32 i = 0; i != n; i++) {
+		float px = x[i] * f;
+		float py = y[i] * f;
+		int x0 = myfloor(px);
+		int y0 = myfloor(py);
+		float xl = px - (float)x0;
+		float yl = py - (float)y0;
+		float v00 = noise2dInline(x0, y0, seed);
+		float v10 = noise2dInline(x0 + 1, y0, seed);
+		float v01 = noise2dInline(x0, y0 + 1, seed);
+		float v11 = noise2dInline(x0 + 1, y0 + 1, seed);
+		out[i] = biLinearInterpolation(v00, v10, v01, v11, xl, yl, eased);
+	}
+}
+static NOISE_KERNEL_INLINE void valueNoise2DImpl(float *out, const float *x,
+		const float *y, float f, u32 n, s32 seed)
+{
+	valueNoise2DT<false>(out, x, y, f, n, seed);
+}
+static NOISE_KERNEL_INLINE void valueNoise2DEasedImpl(float *out, const float *x,
+		const float *y, float f, u32 n, s32 seed)
+{
+	valueNoise2DT<true>(out, x, y, f, n, seed);
+}
+NOISE_KERNEL(valueNoise2D,
+	(float *out, const float *x, const float *y, float f, u32 n, s32 seed),
+	(out, x, y, f, n, seed))
+NOISE_KERNEL(valueNoise2DEased,
+	(float *out, const float *x, const float *y, float f, u32 n, s32 seed),
+	(out, x, y, f, n, seed))
+
+#undef NOISE_KERNEL
+
+
+void NoiseFractal2DGrid(const NoiseParams *np, s32 x0, s32 y0, s32 step,
+	u32 sx, u32 sy, s32 seed, float *result)
+{
+	const u32 n = sx * sy;
+	std::vector<float> x(n), y(n), values(n);
+	for (u32 j = 0, i = 0; j != sy; j++) {
+		for (u32 k = 0; k != sx; k++, i++) {
+			x[i] = (float)(x0 + (s32)k * step) / np->spread.X;
+			y[i] = (float)(y0 + (s32)j * step) / np->spread.Y;
+		}
+	}
+	seed += np->seed;
+
+	// Same order of operations as NoiseFractal2D
+	const bool eased = np->flags & (NOISE_FLAG_DEFAULTS | NOISE_FLAG_EASED);
+	std::fill_n(result, n, 0.0f);
+	float f = 1.0;
+	float g = 1.0;
+	for (size_t oct = 0; oct < np->octaves; oct++) {
+		if (eased)
+			valueNoise2DEased(values.data(), x.data(), y.data(), f, n, seed + oct);
+		else
+			valueNoise2D(values.data(), x.data(), y.data(), f, n, seed + oct);
+
+		if (np->flags & NOISE_FLAG_ABSVALUE)
+			addOctaveAbs(result, values.data(), g, n);
+		else
+			addOctave(result, values.data(), g, n);
+		f *= np->lacunarity;
+		g *= np->persist;
+	}
+
+	for (u32 i = 0; i != n; i++)
+		result[i] = np->offset + result[i] * np->scale;
+}
+
+
 /*
  * NB:  This algorithm is not optimal in terms of space complexity.  The entire
  * integer lattice of noise points could be done as 2 lines instead, and for 3D,
@@ -491,15 +780,70 @@ void Noise::resizeNoiseBuf(bool is3d)
  * Another optimization that could save half as many noise calls is to carry over
  * values from the previous noise lattice as midpoints in the new lattice for the
  * next octave.
+ *
+ * The interpolation along X is the same for every row that lies between the
+ * same lattice lines, so it is done once per lattice line (see getLines).
+ * The rows are then interpolated between these lines.
  */
-#define idx(x, y) ((y) * nlx + (x))
+void Noise::prepareLines(float u, float step_x, bool eased)
+{
+	cell_x.resize(sx);
+	frac_x.resize(sx);
+	line_buf.resize(4 * sx);
+	for (u32 &start : line_starts)
+		start = U32_MAX;
+
+	u32 noisex = 0;
+	for (u32 i = 0; i != sx; i++) {
+		cell_x[i] = noisex;
+		frac_x[i] = eased ? easeCurve(u) : u;
+
+		u += step_x;
+		if (u >= 1.0) {
+			u -= 1.0;
+			noisex++;
+		}
+	}
+}
+
+
+void Noise::getLines(const u32 *starts, u32 count, const float **lines)
+{
+	// Keep the lines that are still needed
+	bool used[4] = {};
+	for (u32 n = 0; n != count; n++) {
+		lines[n] = nullptr;
+		for (u32 slot = 0; slot != 4; slot++) {
+			if (!used[slot] && line_starts[slot] == starts[n]) {
+				used[slot] = true;
+				lines[n] = &line_buf[slot * sx];
+				break;
+			}
+		}
+	}
+
+	for (u32 n = 0; n != count; n++) {
+		if (lines[n])
+			continue;
+		u32 slot = 0;
+		while (used[slot])
+			slot++;
+		used[slot] = true;
+		line_starts[slot] = starts[n];
+		interpolateLine(&line_buf[slot * sx], &noise_buf[starts[n]],
+			cell_x.data(), frac_x.data(), sx);
+		lines[n] = &line_buf[slot * sx];
+	}
+}
+
+
 void Noise::valueMap2D(
 		float x, float y,
 		float step_x, float step_y,
 		s32 seed)
 {
-	float v00, v01, v10, v11, u, v, orig_u;
-	u32 index, i, j, noisex, noisey;
+	float u, v;
+	u32 index, j, noisey;
 	u32 nlx, nly;
 	s32 x0, y0;
 
@@ -508,41 +852,27 @@ void Noise::valueMap2D(
 	y0 = std::floor(y);
 	u = x - (float)x0;
 	v = y - (float)y0;
-	orig_u = u;
 
 	//calculate noise point lattice
 	nlx = (u32)(u + sx * step_x) + 2;
 	nly = (u32)(v + sy * step_y) + 2;
-	index = 0;
-	for (j = 0; j != nly; j++)
-		for (i = 0; i != nlx; i++)
-			noise_buf[index++] = noise2d(x0 + i, y0 + j, seed);
+	fillLattice2D(noise_buf, nlx, nly, x0, y0, seed);
 
 	//calculate interpolations
+	prepareLines(u, step_x, eased);
 	index  = 0;
 	noisey = 0;
 	for (j = 0; j != sy; j++) {
-		v00 = noise_buf[idx(0, noisey)];
-		v10 = noise_buf[idx(1, noisey)];
-		v01 = noise_buf[idx(0, noisey + 1)];
-		v11 = noise_buf[idx(1, noisey + 1)];
-
-		u = orig_u;
-		noisex = 0;
-		for (i = 0; i != sx; i++) {
-			value_buf[index++] =
-				biLinearInterpolation(v00, v10, v01, v11, u, v, eased);
-
-			u += step_x;
-			if (u >= 1.0) {
-				u -= 1.0;
-				noisex++;
-				v00 = v10;
-				v01 = v11;
-				v10 = noise_buf[idx(noisex + 1, noisey)];
-				v11 = noise_buf[idx(noisex + 1, noisey + 1)];
-			}
-		}
+		const u32 starts[2] = {
+			noisey * nlx,
+			(noisey + 1) * nlx,
+		};
+		const float *lines[2];
+		getLines(starts, 2, lines);
+
+		interpolateRow2D(&value_buf[index], lines[0], lines[1], sx,
+			eased ? easeCurve(v) : v);
+		index += sx;
 
 		v += step_y;
 		if (v >= 1.0) {
@@ -551,19 +881,15 @@ void Noise::valueMap2D(
 		}
 	}
 }
-#undef idx
 
 
-#define idx(x, y, z) ((z) * nly * nlx + (y) * nlx + (x))
 void Noise::valueMap3D(
 		float x, float y, float z,
 		float step_x, float step_y, float step_z,
 		s32 seed)
 {
-	float v000, v010, v100, v110;
-	float v001, v011, v101, v111;
-	float u, v, w, orig_u, orig_v;
-	u32 index, i, j, k, noisex, noisey, noisez;
+	float u, v, w, orig_v;
+	u32 index, j, k, noisey, noisez;
 	u32 nlx, nly, nlz;
 	s32 x0, y0, z0;
 
@@ -575,59 +901,36 @@ void Noise::valueMap3D(
 	u = x - (float)x0;
 	v = y - (float)y0;
 	w = z - (float)z0;
-	orig_u = u;
 	orig_v = v;
 
 	//calculate noise point lattice
 	nlx = (u32)(u + sx * step_x) + 2;
 	nly = (u32)(v + sy * step_y) + 2;
 	nlz = (u32)(w + sz * step_z) + 2;
-	index = 0;
-	for (k = 0; k != nlz; k++)
-		for (j = 0; j != nly; j++)
-			for (i = 0; i != nlx; i++)
-				noise_buf[index++] = noise3d(x0 + i, y0 + j, z0 + k, seed);
+	fillLattice3D(noise_buf, nlx, nly, nlz, x0, y0, z0, seed);
 
 	//calculate interpolations
+	prepareLines(u, step_x, eased);
 	index  = 0;
-	noisey = 0;
 	noisez = 0;
 	for (k = 0; k != sz; k++) {
+		float ew = eased ? easeCurve(w) : w;
 		v = orig_v;
 		noisey = 0;
 		for (j = 0; j != sy; j++) {
-			v000 = noise_buf[idx(0, noisey,     noisez)];
-			v100 = noise_buf[idx(1, noisey,     noisez)];
-			v010 = noise_buf[idx(0, noisey + 1, noisez)];
-			v110 = noise_buf[idx(1, noisey + 1, noisez)];
-			v001 = noise_buf[idx(0, noisey,     noisez + 1)];
-			v101 = noise_buf[idx(1, noisey,     noisez + 1)];
-			v011 = noise_buf[idx(0, noisey + 1, noisez + 1)];
-			v111 = noise_buf[idx(1, noisey + 1, noisez + 1)];
-
-			u = orig_u;
-			noisex = 0;
-			for (i = 0; i != sx; i++) {
-				value_buf[index++] = triLinearInterpolation(
-					v000, v100, v010, v110,
-					v001, v101, v011, v111,
-					u, v, w,
-					eased);
-
-				u += step_x;
-				if (u >= 1.0) {
-					u -= 1.0;
-					noisex++;
-					v000 = v100;
-					v010 = v110;
-					v100 = noise_buf[idx(noisex + 1, noisey,     noisez)];
-					v110 = noise_buf[idx(noisex + 1, noisey + 1, noisez)];
-					v001 = v101;
-					v011 = v111;
-					v101 = noise_buf[idx(noisex + 1, noisey,     noisez + 1)];
-					v111 = noise_buf[idx(noisex + 1, noisey + 1, noisez + 1)];
-				}
-			}
+			const u32 starts[4] = {
+				(noisez * nly + noisey) * nlx,
+				(noisez * nly + noisey + 1) * nlx,
+				((noisez + 1) * nly + noisey) * nlx,
+				((noisez + 1) * nly + noisey + 1) * nlx,
+			};
+			const float *lines[4];
+			getLines(starts, 4, lines);
+
+			interpolateRow3D(&value_buf[index],
+				lines[0], lines[1], lines[2], lines[3], sx,
+				eased ? easeCurve(v) : v, ew);
+			index += sx;
 
 			v += step_y;
 			if (v >= 1.0) {
@@ -643,7 +946,6 @@ void Noise::valueMap3D(
 		}
 	}
 }
-#undef idx
 
 
 float *Noise::noiseMap2D(float x, float y, float *persistence_map)
@@ -724,27 +1026,15 @@ float *Noise::noiseMap3D(float x, float y, float z, float *persistence_map)
 void Noise::updateResults(float g, float *gmap,
 	const float *persistence_map, size_t bufsize)
 {
-	// This looks very ugly, but it is 50-70% faster than having
-	// conditional statements inside the loop
 	if (np.flags & NOISE_FLAG_ABSVALUE) {
-		if (persistence_map) {
-			for (size_t i = 0; i != bufsize; i++) {
-				result[i] += gmap[i] * std::fabs(value_buf[i]);
-				gmap[i] *= persistence_map[i];
-			}
-		} else {
-			for (size_t i = 0; i != bufsize; i++)
-				result[i] += g * std::fabs(value_buf[i]);
-		}
+		if (persistence_map)
+			addOctaveMapAbs(result, value_buf, gmap, persistence_map, bufsize);
+		else
+			addOctaveAbs(result, value_buf, g, bufsize);
 	} else {
-		if (persistence_map) {
-			for (size_t i = 0; i != bufsize; i++) {
-				result[i] += gmap[i] * value_buf[i];
-				gmap[i] *= persistence_map[i];
-			}
-		} else {
-			for (size_t i = 0; i != bufsize; i++)
-				result[i] += g * value_buf[i];
-		}
+		if (persistence_map)
+			addOctaveMap(result, value_buf, gmap, persistence_map, bufsize);
+		else
+			addOctave(result, value_buf, g, bufsize);
 	}
 }
@@ -28,6 +28,7 @@
 #include "irr_v3d.h"
 #include "exceptions.h"
 #include "util/string.h"
+#include <vector>
 
 #if defined(RANDOM_MIN)
 #undef RANDOM_MIN
@@ -199,11 +200,36 @@ class Noise {
 	void updateResults(float g, float *gmap, const float *persistence_map,
 			size_t bufsize);
 
+	// Finds the lattice cell and position in it for each X of the map
+	void prepareLines(float u, float step_x, bool eased);
+	// Interpolates lattice lines of noise_buf (given by the index of their
+	// start) at each X of the map. Keeps the last 4 lines.
+	void getLines(const u32 *starts, u32 count, const float **lines);
+
+	std::vector<u32> cell_x;
+	std::vector<float> frac_x;
+	std::vector<float> line_buf;
+	u32 line_starts[4];
 };
 
+// Whether the noise maps may use instruction sets beyond the baseline, if
+// the CPU has them. The results are identical either way.
+void noise_simd_enable(bool enable);
+bool noise_simd_available();
+
 float NoiseFractal2D(const NoiseParams *np, float x, float y, s32 seed);
 float NoiseFractal3D(const NoiseParams *np, float x, float y, float z, s32 seed);
 
+// NoiseFractal2D at the points (x0 + i * step, y0 + j * step) for i < sx and
+// j < sy, into result[j * sx + i]. The values are identical, but the points
+// are calculated together.
+void NoiseFractal2DGrid(const NoiseParams *np, s32 x0, s32 y0, s32 step,
+	u32 sx, u32 sy, s32 seed, float *result);
+
+// Conservative bounds of the values of NoiseFractal2D/3D and of the noise
+// maps without persistence map
+void NoiseFractalBounds(const NoiseParams *np, float &min, float &max);
+
 inline float NoiseFractal2D_PO(NoiseParams *np, float x, float xoff,
 	float y, float yoff, s32 seed)
 {
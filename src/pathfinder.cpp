@@ -166,7 +166,10 @@ class Pathfinder {
 
 public:
 	Pathfinder() = delete;
-	Pathfinder(Map *map, const NodeDefManager *ndef) : m_map(map), m_ndef(ndef) {}
+	Pathfinder(const std::function<MapNode(v3s16)> &get_node,
+			const NodeDefManager *ndef) :
+		m_get_node(get_node), m_ndef(ndef)
+	{}
 
 	/**
 	 * path evaluation function
@@ -306,7 +309,7 @@ class Pathfinder {
 	friend class GridNodeContainer;
 	std::unique_ptr<GridNodeContainer> m_nodes_container;
 
-	Map *m_map = nullptr;
+	const std::function<MapNode(v3s16)> &m_get_node;
 
 	const NodeDefManager *m_ndef = nullptr;
 
@@ -398,7 +401,23 @@ std::vector<v3s16> get_path(Map* map, const NodeDefManager *ndef,
 		unsigned int max_drop,
 		PathAlgorithm algo)
 {
-	return Pathfinder(map, ndef).getPath(source, destination,
+	auto get_node = [map] (v3s16 p) {
+		return map->getNode(p);
+	};
+	return get_path(get_node, ndef, source, destination,
+			searchdistance, max_jump, max_drop, algo);
+}
+
+std::vector<v3s16> get_path(const std::function<MapNode(v3s16)> &get_node,
+		const NodeDefManager *ndef,
+		v3s16 source,
+		v3s16 destination,
+		unsigned int searchdistance,
+		unsigned int max_jump,
+		unsigned int max_drop,
+		PathAlgorithm algo)
+{
+	return Pathfinder(get_node, ndef).getPath(source, destination,
 				searchdistance, max_jump, max_drop, algo);
 }
 
@@ -503,8 +522,8 @@ void GridNodeContainer::initNode(v3s16 ipos, PathGridnode *p_node)
 
 	v3s16 realpos = m_pathf->getRealPos(ipos);
 
-	MapNode current = m_pathf->m_map->getNode(realpos);
-	MapNode below   = m_pathf->m_map->getNode(realpos + v3s16(0, -1, 0));
+	MapNode current = m_pathf->m_get_node(realpos);
+	MapNode below   = m_pathf->m_get_node(realpos + v3s16(0, -1, 0));
 
 
 	if ((current.param0 == CONTENT_IGNORE) ||
@@ -648,13 +667,13 @@ std::vector<v3s16> Pathfinder::getPath(v3s16 source,
 #endif
 
 	//fail if source or destination is walkable
-	MapNode node_at_pos = m_map->getNode(destination);
+	MapNode node_at_pos = m_get_node(destination);
 	if (m_ndef->get(node_at_pos).walkable) {
 		VERBOSE_TARGET << "Destination is walkable. " <<
 				"Pos: " << destination << std::endl;
 		return retval;
 	}
-	node_at_pos = m_map->getNode(source);
+	node_at_pos = m_get_node(source);
 	if (m_ndef->get(node_at_pos).walkable) {
 		VERBOSE_TARGET << "Source is walkable. " <<
 				"Pos: " << source << std::endl;
@@ -817,7 +836,7 @@ PathCost Pathfinder::calcCost(v3s16 pos, v3s16 dir)
 		return retval;
 	}
 
-	MapNode node_at_pos2 = m_map->getNode(pos2);
+	MapNode node_at_pos2 = m_get_node(pos2);
 
 	//did we get information about node?
 	if (node_at_pos2.param0 == CONTENT_IGNORE ) {
@@ -828,7 +847,7 @@ PathCost Pathfinder::calcCost(v3s16 pos, v3s16 dir)
 
 	if (!m_ndef->get(node_at_pos2).walkable) {
 		MapNode node_below_pos2 =
-			m_map->getNode(pos2 + v3s16(0, -1, 0));
+			m_get_node(pos2 + v3s16(0, -1, 0));
 
 		//did we get information about node?
 		if (node_below_pos2.param0 == CONTENT_IGNORE ) {
@@ -849,13 +868,13 @@ PathCost Pathfinder::calcCost(v3s16 pos, v3s16 dir)
 		else {
 			//test if we can fall a couple of nodes (m_maxdrop)
 			v3s16 testpos = pos2 + v3s16(0, -1, 0);
-			MapNode node_at_pos = m_map->getNode(testpos);
+			MapNode node_at_pos = m_get_node(testpos);
 
 			while ((node_at_pos.param0 != CONTENT_IGNORE) &&
 					(!m_ndef->get(node_at_pos).walkable) &&
 					(testpos.Y > m_limits.MinEdge.Y)) {
 				testpos += v3s16(0, -1, 0);
-				node_at_pos = m_map->getNode(testpos);
+				node_at_pos = m_get_node(testpos);
 			}
 
 			//did we find surface?
@@ -887,8 +906,8 @@ PathCost Pathfinder::calcCost(v3s16 pos, v3s16 dir)
 
 		v3s16 targetpos = pos2; // position for jump target
 		v3s16 jumppos = pos; // position for checking if jumping space is free
-		MapNode node_target = m_map->getNode(targetpos);
-		MapNode node_jump = m_map->getNode(jumppos);
+		MapNode node_target = m_get_node(targetpos);
+		MapNode node_jump = m_get_node(jumppos);
 		bool headbanger = false; // true if anything blocks jumppath
 
 		while ((node_target.param0 != CONTENT_IGNORE) &&
@@ -902,8 +921,8 @@ PathCost Pathfinder::calcCost(v3s16 pos, v3s16 dir)
 			}
 			targetpos += v3s16(0, 1, 0);
 			jumppos   += v3s16(0, 1, 0);
-			node_target = m_map->getNode(targetpos);
-			node_jump   = m_map->getNode(jumppos);
+			node_target = m_get_node(targetpos);
+			node_jump   = m_get_node(jumppos);
 
 		}
 		//check headbanger one last time
@@ -1214,7 +1233,7 @@ v3s16 Pathfinder::walkDownwards(v3s16 pos, unsigned int max_down) {
 	if (max_down == 0)
 		return pos;
 	v3s16 testpos = v3s16(pos);
-	MapNode node_at_pos = m_map->getNode(testpos);
+	MapNode node_at_pos = m_get_node(testpos);
 	unsigned int down = 0;
 	while ((node_at_pos.param0 != CONTENT_IGNORE) &&
 			(!m_ndef->get(node_at_pos).walkable) &&
@@ -1222,7 +1241,7 @@ v3s16 Pathfinder::walkDownwards(v3s16 pos, unsigned int max_down) {
 			(down <= max_down)) {
 		testpos += v3s16(0, -1, 0);
 		down++;
-		node_at_pos = m_map->getNode(testpos);
+		node_at_pos = m_get_node(testpos);
 	}
 	//did we find surface?
 	if ((testpos.Y >= m_limits.MinEdge.Y) &&
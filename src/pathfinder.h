@@ -7,6 +7,7 @@
 /******************************************************************************/
 /* Includes                                                                   */
 /******************************************************************************/
+#include <functional>
 #include <vector>
 #include "irr_v3d.h"
 
@@ -16,6 +17,7 @@
 
 class NodeDefManager;
 class Map;
+struct MapNode;
 
 /******************************************************************************/
 /* Typedefs and macros                                                        */
@@ -47,3 +49,13 @@ std::vector<v3s16> get_path(Map *map, const NodeDefManager *ndef,
 		unsigned int max_jump,
 		unsigned int max_drop,
 		PathAlgorithm algo);
+
+/** same, but reading the nodes with get_node instead of from a map */
+std::vector<v3s16> get_path(const std::function<MapNode(v3s16)> &get_node,
+		const NodeDefManager *ndef,
+		v3s16 source,
+		v3s16 destination,
+		unsigned int searchdistance,
+		unsigned int max_jump,
+		unsigned int max_drop,
+		PathAlgorithm algo);
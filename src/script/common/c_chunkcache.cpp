@@ -0,0 +1,146 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "common/c_chunkcache.h"
+#include "filesys.h"
+#include "log.h"
+#include "porting.h"
+#include "util/numeric.h"
+#include "util/hex.h"
+#include "util/string.h"
+#include <atomic>
+#include <mutex>
+
+extern "C" {
+#include <lauxlib.h>
+}
+
+namespace
+{
+	std::mutex s_dir_mutex;
+	std::string s_dir;
+	std::atomic<bool> s_enabled{false};
+
+	std::atomic<u32> s_hits{0};
+	std::atomic<u32> s_misses{0};
+	std::atomic<u64> s_load_time_us{0};
+
+	// Written before the bytecode, so that a hash collision can not load the
+	// wrong chunk and bytecode of another Lua version is not tried
+	std::string make_header(std::string_view code, const char *chunk_name)
+	{
+		std::string header = "LuantiChunk " LUA_RELEASE
+#if USE_LUAJIT
+			" JIT"
+#endif
+			"\n";
+		header.append(chunk_name).append("\n");
+		header.append(std::to_string(code.size())).append(" ");
+		u64 hash = murmur_hash_64_ua(code.data(), code.size(), 0x4c75);
+		header.append(hex_encode(reinterpret_cast<const char *>(&hash), sizeof(hash)));
+		header.append("\n");
+		return header;
+	}
+
+	std::string cache_path(const std::string &header)
+	{
+		u64 hash = murmur_hash_64_ua(header.data(), header.size(), 0x4c75);
+		std::lock_guard lock(s_dir_mutex);
+		return s_dir + DIR_DELIM + hex_encode(
+				reinterpret_cast<const char *>(&hash), sizeof(hash)) + ".luac";
+	}
+
+	int dump_writer(lua_State *L, const void *p, size_t sz, void *ud)
+	{
+		static_cast<std::string *>(ud)->append(static_cast<const char *>(p), sz);
+		return 0;
+	}
+}
+
+namespace ChunkCache
+{
+
+void setDirectory(const std::string &dir)
+{
+	std::lock_guard lock(s_dir_mutex);
+	s_dir = dir;
+	s_enabled = !dir.empty();
+	if (s_enabled && !fs::CreateAllDirs(dir)) {
+		warningstream << "Failed to create Lua chunk cache directory " << dir << std::endl;
+		s_enabled = false;
+	}
+}
+
+bool isEnabled()
+{
+	return s_enabled;
+}
+
+int load(lua_State *L, std::string_view code, const char *chunk_name)
+{
+	const u64 t0 = porting::getTimeUs();
+	if (!isEnabled()) {
+		int ret = luaL_loadbuffer(L, code.data(), code.size(), chunk_name);
+		s_misses++;
+		s_load_time_us += porting::getTimeUs() - t0;
+		return ret;
+	}
+
+	const std::string header = make_header(code, chunk_name);
+	const std::string path = cache_path(header);
+
+	std::string cached;
+	if (fs::ReadFile(path, cached) && str_starts_with(cached, header)) {
+		std::string_view bytecode(cached);
+		bytecode.remove_prefix(header.size());
+		if (luaL_loadbuffer(L, bytecode.data(), bytecode.size(), chunk_name) == 0) {
+			s_hits++;
+			s_load_time_us += porting::getTimeUs() - t0;
+			return 0;
+		}
+		// Broken cache file, compile anew
+		lua_pop(L, 1);
+	}
+
+	int ret = luaL_loadbuffer(L, code.data(), code.size(), chunk_name);
+	if (ret != 0)
+		return ret;
+	s_misses++;
+
+	std::string out = header;
+	lua_dump(L, dump_writer, &out);
+	if (!fs::safeWriteToFile(path, out))
+		warningstream << "Failed to write Lua chunk cache file " << path << std::endl;
+
+	s_load_time_us += porting::getTimeUs() - t0;
+	return 0;
+}
+
+int loadFile(lua_State *L, const std::string &path)
+{
+	std::string code;
+	if (!fs::ReadFile(path, code)) {
+		lua_pushfstring(L, "cannot open %s", path.c_str());
+		return LUA_ERRFILE;
+	}
+	const std::string chunk_name = "@" + path;
+	// Precompiled files are loaded as they are
+	if (!code.empty() && code[0] == LUA_SIGNATURE[0])
+		return luaL_loadbuffer(L, code.data(), code.size(), chunk_name.c_str());
+	// Comment out the shebang line, keeping the line numbers
+	if (!code.empty() && code[0] == '#')
+		code.insert(0, "--");
+	return load(L, code, chunk_name.c_str());
+}
+
+Stats getStats()
+{
+	Stats stats;
+	stats.hits = s_hits;
+	stats.misses = s_misses;
+	stats.load_time_us = s_load_time_us;
+	return stats;
+}
+
+}
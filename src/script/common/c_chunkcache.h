@@ -0,0 +1,46 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include <string>
+#include <string_view>
+
+extern "C" {
+#include <lua.h>
+}
+
+/*
+	Cache of compiled Lua chunks on disk, to skip parsing the mods at startup.
+
+	Chunks are keyed by their chunk name (which contains the path) and a hash
+	of the source code, so a changed file is compiled anew. The bytecode is
+	only ever produced by the engine itself, never read from mods.
+	Stale files are not removed, the directory can be deleted at any time.
+*/
+namespace ChunkCache
+{
+	struct Stats {
+		u32 hits = 0;
+		u32 misses = 0;
+		// Time spent loading chunks, from source or from the cache [us]
+		u64 load_time_us = 0;
+	};
+
+	// Directory for the cache, empty to disable it (the default).
+	// Loading is still counted in the stats when disabled.
+	void setDirectory(const std::string &dir);
+	bool isEnabled();
+
+	// Like luaL_loadbuffer for source code, using the cached chunk if possible.
+	// Returns 0 on success, a Lua error code otherwise.
+	int load(lua_State *L, std::string_view code, const char *chunk_name);
+
+	// Like luaL_loadfile, with the cache
+	int loadFile(lua_State *L, const std::string &path);
+
+	// Counted since the start of the process
+	Stats getStats();
+}
@@ -7,6 +7,7 @@
 #include "cpp_api/s_security.h"
 #include "debug.h"
 #include "lua_api/l_object.h"
+#include "common/c_chunkcache.h"
 #include "common/c_converter.h"
 #include "server/player_sao.h"
 #include "filesys.h"
@@ -245,6 +246,8 @@ void ScriptApiBase::loadScript(const std::string &script_path)
 	bool ok;
 	if (ScriptApiSecurity::isSecure(L)) {
 		ok = ScriptApiSecurity::safeLoadFile(L, script_path.c_str());
+	} else if (ChunkCache::isEnabled()) {
+		ok = !ChunkCache::loadFile(L, script_path);
 	} else {
 		ok = !luaL_loadfile(L, script_path.c_str());
 	}
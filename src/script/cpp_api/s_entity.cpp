@@ -9,6 +9,8 @@
 #include "common/c_converter.h"
 #include "common/c_content.h"
 #include "server.h"
+#include "serverenvironment.h"
+#include "server/serveractiveobject.h"
 
 bool ScriptApiEntity::luaentity_Add(u16 id, const char *name)
 {
@@ -243,6 +245,123 @@ void ScriptApiEntity::luaentity_Step(u16 id, float dtime,
 	lua_pop(L, 2); // Pop object and error handler
 }
 
+bool ScriptApiEntity::luaentity_HasStepBatch(u16 id)
+{
+	SCRIPTAPI_PRECHECKHEADER
+
+	// Get core.luaentities[id]
+	luaentity_get(L, id);
+	lua_getfield(L, -1, "on_step_batch");
+	return lua_isfunction(L, -1);
+}
+
+void ScriptApiEntity::luaentity_QueueStep(const std::string &name, u16 id,
+	const collisionMoveResult *moveresult)
+{
+	auto it = m_step_batch_index.find(name);
+	if (it == m_step_batch_index.end()) {
+		it = m_step_batch_index.emplace(name, m_step_batches.size()).first;
+		m_step_batches.emplace_back().name = name;
+	}
+	StepBatch &batch = m_step_batches[it->second];
+
+	if (batch.count == batch.ids.size()) {
+		batch.ids.emplace_back();
+		batch.moveresults.emplace_back();
+		batch.has_moveresult.emplace_back();
+	}
+	batch.ids[batch.count] = id;
+	batch.has_moveresult[batch.count] = moveresult != nullptr;
+	if (moveresult)
+		batch.moveresults[batch.count] = *moveresult;
+	batch.count++;
+}
+
+// Calls def.on_step_batch(entities, dtime, moveresults) for every entity type
+void ScriptApiEntity::luaentity_StepBatches(float dtime)
+{
+	SCRIPTAPI_PRECHECKHEADER
+
+	auto *env = static_cast<ServerEnvironment *>(getEnv());
+
+	int error_handler = PUSH_ERROR_HANDLER(L);
+
+	lua_getglobal(L, "core");
+	lua_getfield(L, -1, "luaentities");
+	luaL_checktype(L, -1, LUA_TTABLE);
+	int luaentities = lua_gettop(L);
+	lua_getfield(L, -2, "registered_entities");
+	luaL_checktype(L, -1, LUA_TTABLE);
+	int registered_entities = lua_gettop(L);
+
+	for (StepBatch &batch : m_step_batches) {
+		if (batch.count == 0)
+			continue;
+		// Reset first, the callback may throw
+		const size_t queued = batch.count;
+		batch.count = 0;
+
+		if (batch.entities_ref == LUA_NOREF) {
+			lua_createtable(L, queued, 0);
+			batch.entities_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+			lua_createtable(L, queued, 0);
+			batch.moveresults_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+		}
+		lua_rawgeti(L, LUA_REGISTRYINDEX, batch.entities_ref);
+		int entities = lua_gettop(L);
+		lua_rawgeti(L, LUA_REGISTRYINDEX, batch.moveresults_ref);
+		int moveresults = lua_gettop(L);
+
+		size_t n = 0;
+		for (size_t i = 0; i < queued; i++) {
+			u16 id = batch.ids[i];
+			// Skip entities removed since they were queued
+			if (env) {
+				ServerActiveObject *obj = env->getActiveObject(id);
+				if (!obj || obj->isGone())
+					continue;
+			}
+			lua_rawgeti(L, luaentities, id);
+			if (lua_isnil(L, -1)) {
+				lua_pop(L, 1);
+				continue;
+			}
+			lua_rawseti(L, entities, ++n);
+			if (batch.has_moveresult[i])
+				push_collision_move_result(L, batch.moveresults[i]);
+			else
+				lua_pushnil(L);
+			lua_rawseti(L, moveresults, n);
+		}
+		// Clear what is left over from the previous step
+		for (size_t i = n + 1; i <= batch.lua_count; i++) {
+			lua_pushnil(L);
+			lua_rawseti(L, entities, i);
+			lua_pushnil(L);
+			lua_rawseti(L, moveresults, i);
+		}
+		batch.lua_count = n;
+
+		if (n == 0) {
+			lua_pop(L, 2); // Pop entities and moveresults
+			continue;
+		}
+
+		lua_getfield(L, registered_entities, batch.name.c_str());
+		int prototype = lua_gettop(L);
+		lua_getfield(L, prototype, "on_step_batch");
+		luaL_checktype(L, -1, LUA_TFUNCTION);
+		lua_pushvalue(L, entities);
+		lua_pushnumber(L, dtime);
+		lua_pushvalue(L, moveresults);
+
+		setOriginFromTable(prototype);
+		PCALL_RES(lua_pcall(L, 3, 0, error_handler));
+
+		lua_pop(L, 3); // Pop prototype, moveresults and entities
+	}
+}
+
 // Calls entity:on_punch(ObjectRef puncher, time_from_last_punch,
 //                       tool_capabilities, direction, damage)
 bool ScriptApiEntity::luaentity_Punch(u16 id,
@@ -6,11 +6,14 @@
 
 #include "cpp_api/s_base.h"
 #include "irr_v3d.h"
+#include "collision.h"
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 struct ObjectProperties;
 struct ToolCapabilities;
-struct collisionMoveResult;
 
 class ScriptApiEntity
 		: virtual public ScriptApiBase
@@ -26,6 +29,13 @@ class ScriptApiEntity
 			ServerActiveObject *self, ObjectProperties *prop, const std::string &entity_name);
 	void luaentity_Step(u16 id, float dtime,
 		const collisionMoveResult *moveresult);
+	// Whether the entity is stepped by the on_step_batch of its definition
+	bool luaentity_HasStepBatch(u16 id);
+	// Queues the entity for luaentity_StepBatches instead of stepping it now
+	void luaentity_QueueStep(const std::string &name, u16 id,
+		const collisionMoveResult *moveresult);
+	// Calls on_step_batch once for each entity type with queued entities
+	void luaentity_StepBatches(float dtime);
 	bool luaentity_Punch(u16 id,
 			ServerActiveObject *puncher, float time_from_last_punch,
 			const ToolCapabilities *toolcap, v3f dir, s32 damage);
@@ -44,4 +54,20 @@ class ScriptApiEntity
 	 * properties being outside of initial_properties. If an entity's name is in here,
 	 * it won't cause any more of those deprecation warnings. */
 	std::unordered_set<std::string> deprecation_warned_init_properties;
+
+	struct StepBatch {
+		std::string name;
+		std::vector<u16> ids;
+		// Copies reuse their memory from the previous steps
+		std::vector<collisionMoveResult> moveresults;
+		std::vector<bool> has_moveresult;
+		size_t count = 0;
+		// Lua tables passed to on_step_batch, reused every step
+		int entities_ref = LUA_NOREF;
+		int moveresults_ref = LUA_NOREF;
+		size_t lua_count = 0;
+	};
+	// In order of first use, so that the call order is deterministic
+	std::vector<StepBatch> m_step_batches;
+	std::unordered_map<std::string, size_t> m_step_batch_index;
 };
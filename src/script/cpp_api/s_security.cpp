@@ -4,6 +4,7 @@
 
 #include "cpp_api/s_security.h"
 #include "lua_api/l_base.h"
+#include "common/c_chunkcache.h"
 #include "filesys.h"
 #include "server.h"
 #if CHECK_CLIENT_BUILD()
@@ -519,7 +520,10 @@ bool ScriptApiSecurity::safeLoadFile(lua_State *L, const char *path, const char
 		return false;
 	}
 
-	bool result = safeLoadString(L, code, chunk_name);
+	// Source code may be loaded from the chunk cache instead
+	bool result = !code.empty() && code[0] != LUA_SIGNATURE[0] ?
+		ChunkCache::load(L, code, chunk_name) == 0 :
+		safeLoadString(L, code, chunk_name);
 	if (path)
 		delete [] chunk_name;
 	return result;
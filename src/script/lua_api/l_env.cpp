@@ -26,6 +26,7 @@
 #include "remoteplayer.h"
 #include "servermap.h"
 #include "server/luaentity_sao.h"
+#include "server/mapsnapshot.h"
 #include "server/player_sao.h"
 #include "util/string.h"
 #include "translation.h"
@@ -53,7 +54,25 @@ const EnumString ModApiEnvBase::es_BlockStatusType[] =
 
 int LuaRaycast::l_next(lua_State *L)
 {
-	GET_PLAIN_ENV_PTR;
+	MAP_LOCK_REQUIRED;
+
+	if (!getEnv(L) && getScriptApiBase(L)->getType() == ScriptingType::Async) {
+		// Only nodes are known to the async environment
+		LuaRaycast *o = checkObject<LuaRaycast>(L, 1);
+		MapSnapshotView view(ModApiEnvAsync::getMapSnapshot(L));
+		auto get_node = [&view] (v3s16 p, bool *is_valid_position) {
+			return view.getNode(p, is_valid_position);
+		};
+		PointedThing pointed;
+		continue_raycast_nodes(&o->state, &pointed, getGameDef(L)->ndef(), get_node);
+		if (pointed.type == POINTEDTHING_NOTHING)
+			lua_pushnil(L);
+		else
+			push_pointed_thing(L, pointed, false, true);
+		return 1;
+	}
+
+	GET_PLAIN_ENV_PTR_NO_MAP_LOCK;
 	ServerEnvironment *senv = dynamic_cast<ServerEnvironment*>(env);
 
 	bool csm = false;
@@ -264,33 +283,41 @@ int ModApiEnv::l_bulk_swap_node(lua_State *L)
 	return 1;
 }
 
+// Reads the x, y, z arguments of get_node_raw
+static v3s16 read_node_raw_pos(lua_State *L)
+{
+	// mirrors the implementation of read_v3s16 (with the exact same rounding)
+	if (lua_isnoneornil(L, 1))
+		log_deprecated(L, "X position is nil", 1, true);
+	if (lua_isnoneornil(L, 2))
+		log_deprecated(L, "Y position is nil", 1, true);
+	if (lua_isnoneornil(L, 3))
+		log_deprecated(L, "Z position is nil", 1, true);
+	double x = lua_tonumber(L, 1);
+	double y = lua_tonumber(L, 2);
+	double z = lua_tonumber(L, 3);
+	return doubleToInt(v3d(x, y, z), 1.0);
+}
+
+static int push_node_raw(lua_State *L, MapNode n, bool pos_ok)
+{
+	lua_pushinteger(L, n.getContent());
+	lua_pushinteger(L, n.getParam1());
+	lua_pushinteger(L, n.getParam2());
+	lua_pushboolean(L, pos_ok);
+	return 4;
+}
+
 // get_node_raw(x, y, z) -> content, param1, param2, pos_ok
 int ModApiEnv::l_get_node_raw(lua_State *L)
 {
 	GET_PLAIN_ENV_PTR;
 
-	v3s16 pos;
-	// mirrors the implementation of read_v3s16 (with the exact same rounding)
-	{
-		if (lua_isnoneornil(L, 1))
-			log_deprecated(L, "X position is nil", 1, true);
-		if (lua_isnoneornil(L, 2))
-			log_deprecated(L, "Y position is nil", 1, true);
-		if (lua_isnoneornil(L, 3))
-			log_deprecated(L, "Z position is nil", 1, true);
-		double x = lua_tonumber(L, 1);
-		double y = lua_tonumber(L, 2);
-		double z = lua_tonumber(L, 3);
-		pos = doubleToInt(v3d(x, y, z), 1.0);
-	}
+	v3s16 pos = read_node_raw_pos(L);
 	bool pos_ok;
 	MapNode n = env->getMap().getNode(pos, &pos_ok);
 	// Return node and pos_ok
-	lua_pushinteger(L, n.getContent());
-	lua_pushinteger(L, n.getParam1());
-	lua_pushinteger(L, n.getParam2());
-	lua_pushboolean(L, pos_ok);
-	return 4;
+	return push_node_raw(L, n, pos_ok);
 }
 
 // get_node_light(pos, timeofday)
@@ -790,22 +817,87 @@ int ModApiEnv::l_get_gametime(lua_State *L)
 }
 
 void ModApiEnvBase::collectNodeIds(lua_State *L, int idx, const NodeDefManager *ndef,
-	std::vector<content_t> &filter)
+	std::vector<content_t> &filter, bool allow_ids)
 {
 	if (lua_istable(L, idx)) {
 		lua_pushnil(L);
 		while (lua_next(L, idx) != 0) {
 			// key at index -2 and value at index -1
-			luaL_checktype(L, -1, LUA_TSTRING);
-			ndef->getIds(readParam<std::string>(L, -1), filter);
+			if (allow_ids && lua_type(L, -1) == LUA_TNUMBER) {
+				filter.push_back(lua_tointeger(L, -1));
+			} else {
+				luaL_checktype(L, -1, LUA_TSTRING);
+				ndef->getIds(readParam<std::string>(L, -1), filter);
+			}
 			// removes value, keeps key for next iteration
 			lua_pop(L, 1);
 		}
+	} else if (allow_ids && lua_type(L, idx) == LUA_TNUMBER) {
+		filter.push_back(lua_tointeger(L, idx));
 	} else if (lua_isstring(L, idx)) {
 		ndef->getIds(readParam<std::string>(L, idx), filter);
 	}
 }
 
+inline bool ModApiEnvBase::RawNodeFilter::matches(MapNode n) const
+{
+	const content_t c = n.getContent();
+	if (c >= contents.size() || !contents[c])
+		return false;
+	if (check_param2) {
+		u8 param2 = n.param2 & param2_mask;
+		if (param2 < param2_min || param2 > param2_max)
+			return false;
+	}
+	if (check_light) {
+		u8 light = n.getLight(light_bank, ndef->getLightingFlags(n));
+		if (light < light_min || light > light_max)
+			return false;
+	}
+	return true;
+}
+
+void ModApiEnvBase::readRawNodeFilter(lua_State *L, int idx,
+	const NodeDefManager *ndef, RawNodeFilter &filter)
+{
+	filter.ndef = ndef;
+
+	std::vector<content_t> ids;
+	collectNodeIds(L, idx, ndef, ids, true);
+	for (content_t c : ids) {
+		if (c >= filter.contents.size())
+			filter.contents.resize(c + 1, false);
+		filter.contents[c] = true;
+	}
+
+	const int options = idx + 1;
+	if (!lua_istable(L, options))
+		return;
+
+	int mask = 0xFF, min = 0, max = 0xFF;
+	filter.check_param2 = getintfield(L, options, "param2_mask", mask) |
+		getintfield(L, options, "param2_min", min) |
+		getintfield(L, options, "param2_max", max);
+	filter.param2_mask = mask;
+	filter.param2_min = rangelim(min, 0, 0xFF);
+	filter.param2_max = rangelim(max, 0, 0xFF);
+
+	min = 0;
+	max = LIGHT_SUN;
+	filter.check_light = getintfield(L, options, "light_min", min) |
+		getintfield(L, options, "light_max", max);
+	filter.light_min = rangelim(min, 0, LIGHT_SUN);
+	filter.light_max = rangelim(max, 0, LIGHT_SUN);
+
+	std::string bank = getstringfield_default(L, options, "light_bank", "day");
+	if (bank == "day")
+		filter.light_bank = LIGHTBANK_DAY;
+	else if (bank == "night")
+		filter.light_bank = LIGHTBANK_NIGHT;
+	else
+		throw LuaError("Invalid light_bank \"" + bank + "\"");
+}
+
 template <typename F>
 int ModApiEnvBase::findNodeNear(lua_State *L, v3s16 pos, int radius,
 		const std::vector<content_t> &filter, int start_radius, F &&getNode)
@@ -939,6 +1031,35 @@ int ModApiEnvBase::findNodesInArea(lua_State *L, const NodeDefManager *ndef,
 	}
 }
 
+template <typename F>
+int ModApiEnvBase::findNodesInAreaRaw(lua_State *L, const VoxelArea &area,
+		const RawNodeFilter &filter, F &&iterate)
+{
+	// Collect first, so the tables can be allocated at once
+	std::vector<std::pair<u32, content_t>> found;
+	iterate([&](v3s16 p, MapNode n) -> bool {
+		if (filter.matches(n))
+			found.emplace_back(area.index(p), n.getContent());
+		return true;
+	});
+
+	// The map is iterated by block
+	if (!std::is_sorted(found.begin(), found.end()))
+		std::sort(found.begin(), found.end());
+
+	lua_createtable(L, found.size(), 0);
+	for (u32 i = 0; i < found.size(); i++) {
+		lua_pushinteger(L, found[i].first + 1);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_createtable(L, found.size(), 0);
+	for (u32 i = 0; i < found.size(); i++) {
+		lua_pushinteger(L, found[i].second);
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 2;
+}
+
 // find_nodes_in_area(minp, maxp, nodenames, [grouped])
 int ModApiEnv::l_find_nodes_in_area(lua_State *L)
 {
@@ -1031,6 +1152,28 @@ int ModApiEnv::l_find_nodes_in_area_under_air(lua_State *L)
 	return findNodesInAreaUnderAir(L, minp, maxp, filter, getNode);
 }
 
+// find_nodes_in_area_raw(minp, maxp, nodes, [options]) -> indices, content IDs
+int ModApiEnv::l_find_nodes_in_area_raw(lua_State *L)
+{
+	GET_ENV_PTR;
+
+	v3s16 minp = read_v3s16(L, 1);
+	v3s16 maxp = read_v3s16(L, 2);
+	sortBoxVerticies(minp, maxp);
+	// Indices refer to the area as given
+	const VoxelArea area(minp, maxp);
+	checkArea(minp, maxp);
+
+	RawNodeFilter filter;
+	readRawNodeFilter(L, 3, env->getGameDef()->ndef(), filter);
+
+	Map &map = env->getMap();
+	auto iterate = [&] (auto &&callback) {
+		map.forEachNodeInArea(minp, maxp, callback);
+	};
+	return findNodesInAreaRaw(L, area, filter, iterate);
+}
+
 // get_value_noise(seeddiff, octaves, persistence, scale)
 // returns world-specific ValueNoise
 int ModApiEnv::l_get_value_noise(lua_State *L)
@@ -1258,10 +1401,9 @@ int ModApiEnv::l_delete_area(lua_State *L)
 
 // find_path(pos1, pos2, searchdistance,
 //     max_jump, max_drop, algorithm) -> table containing path
-int ModApiEnv::l_find_path(lua_State *L)
+template <typename M>
+int ModApiEnvBase::findPath(lua_State *L, const NodeDefManager *ndef, M &map)
 {
-	GET_ENV_PTR;
-
 	v3s16 pos1                  = read_v3s16(L, 1);
 	v3s16 pos2                  = read_v3s16(L, 2);
 	unsigned int searchdistance = luaL_checkint(L, 3);
@@ -1278,7 +1420,10 @@ int ModApiEnv::l_find_path(lua_State *L)
 			algo = PA_DIJKSTRA;
 	}
 
-	std::vector<v3s16> path = get_path(&env->getServerMap(), env->getGameDef()->ndef(), pos1, pos2,
+	auto get_node = [&map] (v3s16 p) {
+		return map.getNode(p);
+	};
+	std::vector<v3s16> path = get_path(get_node, ndef, pos1, pos2,
 		searchdistance, max_jump, max_drop, algo);
 
 	if (!path.empty()) {
@@ -1297,6 +1442,13 @@ int ModApiEnv::l_find_path(lua_State *L)
 	return 0;
 }
 
+int ModApiEnv::l_find_path(lua_State *L)
+{
+	GET_ENV_PTR;
+
+	return findPath(L, env->getGameDef()->ndef(), env->getServerMap());
+}
+
 // spawn_tree(pos, treedef)
 int ModApiEnv::l_spawn_tree(lua_State *L)
 {
@@ -1419,6 +1571,7 @@ void ModApiEnv::Initialize(lua_State *L, int top)
 	API_FCT(find_node_near);
 	API_FCT(find_nodes_in_area);
 	API_FCT(find_nodes_in_area_under_air);
+	API_FCT(find_nodes_in_area_raw);
 	API_FCT(fix_light);
 	API_FCT(load_area);
 	API_FCT(emerge_area);
@@ -1541,6 +1694,42 @@ int ModApiEnvVM::l_find_node_near(lua_State *L)
 	return findNodeNear(L, pos, radius, filter, start_radius, getNode);
 }
 
+// Iterates over the nodes of `vm` in `area` like Map::forEachNodeInArea,
+// `area` must be inside of the VoxelManipulator
+static auto vmanip_iterator(const VoxelManipulator *vm, const VoxelArea &area)
+{
+	return [vm, area] (auto &&callback) {
+		const v3s16 minp = area.MinEdge, maxp = area.MaxEdge;
+		for (s16 z = minp.Z; z <= maxp.Z; z++)
+		for (s16 y = minp.Y; y <= maxp.Y; y++) {
+			u32 vi = vm->m_area.index(minp.X, y, z);
+			for (s16 x = minp.X; x <= maxp.X; x++) {
+				v3s16 pos(x, y, z);
+				MapNode n = vm->m_data[vi];
+				if (!callback(pos, n))
+					return;
+				++vi;
+			}
+		}
+	};
+}
+
+int ModApiEnvBase::findNodesInVManip(lua_State *L, const NodeDefManager *ndef,
+		const VoxelManipulator *vm, VoxelArea area,
+		const std::vector<content_t> &filter, bool grouped)
+{
+	// avoid the loop going out-of-bounds
+	area = area.intersect(vm->m_area);
+	return findNodesInArea(L, ndef, filter, grouped, vmanip_iterator(vm, area));
+}
+
+int ModApiEnvBase::findNodesInVManipRaw(lua_State *L, const VoxelManipulator *vm,
+		const VoxelArea &area, const RawNodeFilter &filter)
+{
+	return findNodesInAreaRaw(L, area, filter,
+			vmanip_iterator(vm, area.intersect(vm->m_area)));
+}
+
 // find_nodes_in_area(minp, maxp, nodenames, [grouped])
 int ModApiEnvVM::l_find_nodes_in_area(lua_State *L)
 {
@@ -1553,32 +1742,13 @@ int ModApiEnvVM::l_find_nodes_in_area(lua_State *L)
 	sortBoxVerticies(minp, maxp);
 
 	checkArea(minp, maxp);
-	// avoid the loop going out-of-bounds
-	{
-		VoxelArea cropped = VoxelArea(minp, maxp).intersect(vm->m_area);
-		minp = cropped.MinEdge;
-		maxp = cropped.MaxEdge;
-	}
 
 	std::vector<content_t> filter;
 	collectNodeIds(L, 3, ndef, filter);
 
 	bool grouped = lua_isboolean(L, 4) && readParam<bool>(L, 4);
 
-	auto iterate = [&] (auto callback) {
-		for (s16 z = minp.Z; z <= maxp.Z; z++)
-		for (s16 y = minp.Y; y <= maxp.Y; y++) {
-			u32 vi = vm->m_area.index(minp.X, y, z);
-			for (s16 x = minp.X; x <= maxp.X; x++) {
-				v3s16 pos(x, y, z);
-				MapNode n = vm->m_data[vi];
-				if (!callback(pos, n))
-					return;
-				++vi;
-			}
-		}
-	};
-	return findNodesInArea(L, ndef, filter, grouped, iterate);
+	return findNodesInVManip(L, ndef, vm, VoxelArea(minp, maxp), filter, grouped);
 }
 
 // find_nodes_in_area_under_air(minp, maxp, nodenames)
@@ -1602,6 +1772,23 @@ int ModApiEnvVM::l_find_nodes_in_area_under_air(lua_State *L)
 	return findNodesInAreaUnderAir(L, minp, maxp, filter, getNode);
 }
 
+// find_nodes_in_area_raw(minp, maxp, nodes, [options])
+int ModApiEnvVM::l_find_nodes_in_area_raw(lua_State *L)
+{
+	GET_VM_PTR;
+
+	v3s16 minp = read_v3s16(L, 1);
+	v3s16 maxp = read_v3s16(L, 2);
+	sortBoxVerticies(minp, maxp);
+	const VoxelArea area(minp, maxp);
+	checkArea(minp, maxp);
+
+	RawNodeFilter filter;
+	readRawNodeFilter(L, 3, getGameDef(L)->ndef(), filter);
+
+	return findNodesInVManipRaw(L, vm, area, filter);
+}
+
 // spawn_tree(pos, treedef)
 int ModApiEnvVM::l_spawn_tree(lua_State *L)
 {
@@ -1643,7 +1830,170 @@ void ModApiEnvVM::InitializeEmerge(lua_State *L, int top)
 	API_FCT(find_node_near);
 	API_FCT(find_nodes_in_area);
 	API_FCT(find_nodes_in_area_under_air);
+	API_FCT(find_nodes_in_area_raw);
 	API_FCT(spawn_tree);
 }
 
 #undef GET_VM_PTR
+
+/*
+	ModApiEnvAsync: read-only access to the map snapshot
+*/
+
+const MapSnapshot &ModApiEnvAsync::getMapSnapshot(lua_State *L)
+{
+	const MapSnapshot *snapshot = getServer(L)->getEnv().getMapSnapshot();
+	if (!snapshot)
+		throw LuaError("Map access from the async environment is disabled "
+				"(setting async_map_access)");
+	return *snapshot;
+}
+
+// get_node_raw(x, y, z) -> content, param1, param2, pos_ok
+int ModApiEnvAsync::l_get_node_raw(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	v3s16 pos = read_node_raw_pos(L);
+	MapSnapshotView view(getMapSnapshot(L));
+	bool pos_ok;
+	MapNode n = view.getNode(pos, &pos_ok);
+	return push_node_raw(L, n, pos_ok);
+}
+
+// find_node_near(pos, radius, nodenames, [search_center]) -> pos or nil
+int ModApiEnvAsync::l_find_node_near(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	const NodeDefManager *ndef = getGameDef(L)->ndef();
+
+	v3s16 pos = read_v3s16(L, 1);
+	int radius = luaL_checkinteger(L, 2);
+	std::vector<content_t> filter;
+	collectNodeIds(L, 3, ndef, filter);
+
+	int start_radius = (lua_isboolean(L, 4) && readParam<bool>(L, 4)) ? 0 : 1;
+
+	MapSnapshotView view(getMapSnapshot(L));
+	auto getNode = [&view] (v3s16 p) -> MapNode {
+		return view.getNode(p);
+	};
+	return findNodeNear(L, pos, radius, filter, start_radius, getNode);
+}
+
+// find_nodes_in_area(minp, maxp, nodenames, [grouped])
+int ModApiEnvAsync::l_find_nodes_in_area(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	const NodeDefManager *ndef = getGameDef(L)->ndef();
+
+	v3s16 minp = read_v3s16(L, 1);
+	v3s16 maxp = read_v3s16(L, 2);
+	sortBoxVerticies(minp, maxp);
+	checkArea(minp, maxp);
+
+	std::vector<content_t> filter;
+	collectNodeIds(L, 3, ndef, filter);
+
+	bool grouped = lua_isboolean(L, 4) && readParam<bool>(L, 4);
+
+	MapSnapshotView view(getMapSnapshot(L));
+	auto iterate = [&] (auto &&callback) {
+		view.forEachNodeInArea(minp, maxp, callback);
+	};
+	return findNodesInArea(L, ndef, filter, grouped, iterate);
+}
+
+// find_nodes_in_area_under_air(minp, maxp, nodenames) -> list of positions
+int ModApiEnvAsync::l_find_nodes_in_area_under_air(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	const NodeDefManager *ndef = getGameDef(L)->ndef();
+
+	v3s16 minp = read_v3s16(L, 1);
+	v3s16 maxp = read_v3s16(L, 2);
+	sortBoxVerticies(minp, maxp);
+	checkArea(minp, maxp);
+
+	std::vector<content_t> filter;
+	collectNodeIds(L, 3, ndef, filter);
+
+	MapSnapshotView view(getMapSnapshot(L));
+	auto getNode = [&view] (v3s16 p) -> MapNode {
+		return view.getNode(p);
+	};
+	return findNodesInAreaUnderAir(L, minp, maxp, filter, getNode);
+}
+
+// find_nodes_in_area_raw(minp, maxp, nodes, [options]) -> indices, content IDs
+int ModApiEnvAsync::l_find_nodes_in_area_raw(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	v3s16 minp = read_v3s16(L, 1);
+	v3s16 maxp = read_v3s16(L, 2);
+	sortBoxVerticies(minp, maxp);
+	const VoxelArea area(minp, maxp);
+	checkArea(minp, maxp);
+
+	RawNodeFilter filter;
+	readRawNodeFilter(L, 3, getGameDef(L)->ndef(), filter);
+
+	MapSnapshotView view(getMapSnapshot(L));
+	auto iterate = [&] (auto &&callback) {
+		view.forEachNodeInArea(minp, maxp, callback);
+	};
+	return findNodesInAreaRaw(L, area, filter, iterate);
+}
+
+// line_of_sight(pos1, pos2) -> true/false, pos
+int ModApiEnvAsync::l_line_of_sight(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	v3f pos1 = checkFloatPos(L, 1);
+	v3f pos2 = checkFloatPos(L, 2);
+
+	MapSnapshotView view(getMapSnapshot(L));
+	auto get_node = [&view] (v3s16 p) {
+		return view.getNode(p);
+	};
+	v3s16 p;
+	bool success = line_of_sight(pos1, pos2, get_node, &p);
+	lua_pushboolean(L, success);
+	if (!success) {
+		push_v3s16(L, p);
+		return 2;
+	}
+	return 1;
+}
+
+// find_path(pos1, pos2, searchdistance, max_jump, max_drop, algorithm)
+int ModApiEnvAsync::l_find_path(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	MapSnapshotView view(getMapSnapshot(L));
+	return findPath(L, getGameDef(L)->ndef(), view);
+}
+
+int ModApiEnvAsync::l_raycast(lua_State *L)
+{
+	return LuaRaycast::create_object(L);
+}
+
+void ModApiEnvAsync::InitializeAsync(lua_State *L, int top)
+{
+	// get_node and get_node_or_nil are in builtin/async/game.lua
+	API_FCT(get_node_raw);
+	API_FCT(find_node_near);
+	API_FCT(find_nodes_in_area);
+	API_FCT(find_nodes_in_area_under_air);
+	API_FCT(find_nodes_in_area_raw);
+	API_FCT(line_of_sight);
+	API_FCT(find_path);
+	API_FCT(raycast);
+}
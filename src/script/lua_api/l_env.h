@@ -5,17 +5,46 @@
 #pragma once
 
 #include "lua_api/l_base.h"
+#include "mapnode.h"
 #include "raycast.h"
 #include "util/enum_string.h"
 
 class ServerScripting;
+class MapSnapshot;
+class VoxelArea;
+class VoxelManipulator;
 
 // base class containing helpers
 class ModApiEnvBase : public ModApiBase {
 protected:
 
+	// `allow_ids`: also accept content IDs
 	static void collectNodeIds(lua_State *L, int idx,
-		const NodeDefManager *ndef, std::vector<content_t> &filter);
+		const NodeDefManager *ndef, std::vector<content_t> &filter,
+		bool allow_ids = false);
+
+	// Which nodes find_nodes_in_area_raw looks for
+	struct RawNodeFilter {
+		const NodeDefManager *ndef = nullptr;
+		// Indexed by content ID
+		std::vector<bool> contents;
+
+		bool check_param2 = false;
+		u8 param2_mask = 0xFF;
+		u8 param2_min = 0;
+		u8 param2_max = 0xFF;
+
+		bool check_light = false;
+		LightBank light_bank = LIGHTBANK_DAY;
+		u8 light_min = 0;
+		u8 light_max = LIGHT_SUN;
+
+		inline bool matches(MapNode n) const;
+	};
+
+	// Reads the node names or IDs at `idx` and the options table at `idx + 1`
+	static void readRawNodeFilter(lua_State *L, int idx,
+		const NodeDefManager *ndef, RawNodeFilter &filter);
 
 	static void checkArea(v3s16 &minp, v3s16 &maxp);
 
@@ -31,11 +60,29 @@ class ModApiEnvBase : public ModApiBase {
 	static int findNodesInArea(lua_State *L,  const NodeDefManager *ndef,
 		const std::vector<content_t> &filter, bool grouped, F &&iterate);
 
+	// Pushes the indices in `area` and content IDs of the matching nodes
+	// F like for findNodesInArea
+	template <typename F>
+	static int findNodesInAreaRaw(lua_State *L, const VoxelArea &area,
+		const RawNodeFilter &filter, F &&iterate);
+
 	// F must be (v3s16 pos) -> MapNode
 	template <typename F>
 	static int findNodesInAreaUnderAir(lua_State *L, v3s16 minp, v3s16 maxp,
 		const std::vector<content_t> &filter, F &&getNode);
 
+	// find_nodes_in_area and find_nodes_in_area_raw on the part of `area`
+	// inside of `vm`
+	static int findNodesInVManip(lua_State *L, const NodeDefManager *ndef,
+		const VoxelManipulator *vm, VoxelArea area,
+		const std::vector<content_t> &filter, bool grouped);
+	static int findNodesInVManipRaw(lua_State *L, const VoxelManipulator *vm,
+		const VoxelArea &area, const RawNodeFilter &filter);
+
+	// find_path on anything with getNode(v3s16) like Map
+	template <typename M>
+	static int findPath(lua_State *L, const NodeDefManager *ndef, M &map);
+
 	static const EnumString es_ClearObjectsMode[];
 	static const EnumString es_BlockStatusType[];
 
@@ -168,6 +215,9 @@ class ModApiEnv : public ModApiEnvBase {
 	// nodenames: eg. {"ignore", "group:tree"} or "default:dirt"
 	static int l_find_nodes_in_area_under_air(lua_State *L);
 
+	// find_nodes_in_area_raw(minp, maxp, nodes, [options]) -> indices, content IDs
+	static int l_find_nodes_in_area_raw(lua_State *L);
+
 	// fix_light(p1, p2) -> true/false
 	static int l_fix_light(lua_State *L);
 
@@ -262,6 +312,9 @@ class ModApiEnvVM : public ModApiEnvBase {
 	// find_surface_nodes_in_area(minp, maxp, nodenames)
 	static int l_find_nodes_in_area_under_air(lua_State *L);
 
+	// find_nodes_in_area_raw(minp, maxp, nodes, [options])
+	static int l_find_nodes_in_area_raw(lua_State *L);
+
 	// spawn_tree(pos, treedef)
 	static int l_spawn_tree(lua_State *L);
 
@@ -272,6 +325,39 @@ class ModApiEnvVM : public ModApiEnvBase {
 	static void InitializeEmerge(lua_State *L, int top);
 };
 
+class ModApiEnvAsync : public ModApiEnvBase {
+private:
+	// get_node_raw(x, y, z) -> content, param1, param2, pos_ok
+	static int l_get_node_raw(lua_State *L);
+
+	// find_node_near(pos, radius, nodenames, [search_center])
+	static int l_find_node_near(lua_State *L);
+
+	// find_nodes_in_area(minp, maxp, nodenames, [grouped])
+	static int l_find_nodes_in_area(lua_State *L);
+
+	// find_nodes_in_area_under_air(minp, maxp, nodenames)
+	static int l_find_nodes_in_area_under_air(lua_State *L);
+
+	// find_nodes_in_area_raw(minp, maxp, nodes, [options])
+	static int l_find_nodes_in_area_raw(lua_State *L);
+
+	// line_of_sight(pos1, pos2) -> true/false, pos
+	static int l_line_of_sight(lua_State *L);
+
+	// find_path(pos1, pos2, searchdistance, max_jump, max_drop, algorithm)
+	static int l_find_path(lua_State *L);
+
+	// raycast(pos1, pos2, objects, liquids, pointabilities) -> Raycast
+	static int l_raycast(lua_State *L);
+
+public:
+	// Helper: get the map snapshot of the server, throws if disabled
+	static const MapSnapshot &getMapSnapshot(lua_State *L);
+
+	static void InitializeAsync(lua_State *L, int top);
+};
+
 //! Lua wrapper for RaycastState objects
 class LuaRaycast : public ModApiBase
 {
@@ -4,16 +4,13 @@
 #include "lua_api/l_ipc.h"
 #include "lua_api/l_internal.h"
 #include "common/c_packer.h"
-#include "server.h"
+#include "server/modipcstore.h"
 #include "debug.h"
 #include <chrono>
 
-typedef std::shared_lock<std::shared_mutex> SharedReadLock;
-typedef std::unique_lock<std::shared_mutex> SharedWriteLock;
-
-static inline auto read_pv(lua_State *L, int idx)
+static inline ModIPCStore::Value read_pv(lua_State *L, int idx)
 {
-	std::unique_ptr<PackedValue> ret;
+	std::shared_ptr<PackedValue> ret;
 	if (!lua_isnil(L, idx)) {
 		ret.reset(script_pack(L, idx));
 		if (ret->contains_userdata)
@@ -22,20 +19,32 @@ static inline auto read_pv(lua_State *L, int idx)
 	return ret;
 }
 
+static inline void push_pv(lua_State *L, const ModIPCStore::Value &pv)
+{
+	if (!pv) {
+		lua_pushnil(L);
+		return;
+	}
+	// Unpacking only modifies values with userdata, which are not allowed here.
+	// So the stored value can be shared by all readers.
+	script_unpack(L, const_cast<PackedValue *>(pv.get()));
+}
+
+static inline auto read_timeout(lua_State *L, int idx)
+{
+	return std::chrono::milliseconds(
+		std::max<int>(0, luaL_checkinteger(L, idx))
+	);
+}
+
 int ModApiIPC::l_ipc_get(lua_State *L)
 {
 	auto *store = getGameDef(L)->getModIPCStore();
 
 	auto key = readParam<std::string>(L, 1);
 
-	{
-		SharedReadLock autolock(store->mutex);
-		auto it = store->map.find(key);
-		if (it == store->map.end())
-			lua_pushnil(L);
-		else
-			script_unpack(L, it->second.get());
-	}
+	// Unpack without holding any lock
+	push_pv(L, store->get(key));
 	return 1;
 }
 
@@ -46,16 +55,7 @@ int ModApiIPC::l_ipc_set(lua_State *L)
 	auto key = readParam<std::string>(L, 1);
 
 	luaL_checkany(L, 2);
-	auto pv = read_pv(L, 2);
-
-	{
-		SharedWriteLock autolock(store->mutex);
-		if (pv)
-			store->map[key] = std::move(pv);
-		else
-			store->map.erase(key); // delete the map value for nil
-	}
-	store->signal();
+	store->set(key, read_pv(L, 2));
 	return 0;
 }
 
@@ -71,29 +71,22 @@ int ModApiIPC::l_ipc_cas(lua_State *L)
 	luaL_checkany(L, 3);
 	auto pv_new = read_pv(L, 3);
 
-	bool ok = false;
-	{
-		SharedWriteLock autolock(store->mutex);
-		// unpack and compare old value
-		auto it = store->map.find(key);
-		if (it == store->map.end()) {
+	// Compare outside of the lock, then set only if nothing changed meanwhile
+	bool ok;
+	for (;;) {
+		u64 version;
+		auto pv_old = store->get(key, &version);
+		if (!pv_old) {
 			ok = lua_isnil(L, idx_old);
 		} else {
-			script_unpack(L, it->second.get());
+			push_pv(L, pv_old);
 			ok = lua_equal(L, idx_old, -1);
 			lua_pop(L, 1);
 		}
-		// put new value
-		if (ok) {
-			if (pv_new)
-				store->map[key] = std::move(pv_new);
-			else
-				store->map.erase(key);
-		}
+		if (!ok || store->setIfVersion(key, version, pv_new))
+			break;
 	}
 
-	if (ok)
-		store->signal();
 	lua_pushboolean(L, ok);
 	return 1;
 }
@@ -103,22 +96,31 @@ int ModApiIPC::l_ipc_poll(lua_State *L)
 	auto *store = getGameDef(L)->getModIPCStore();
 
 	auto key = readParam<std::string>(L, 1);
+	auto timeout = read_timeout(L, 2);
 
-	auto timeout = std::chrono::milliseconds(
-		std::max<int>(0, luaL_checkinteger(L, 2))
-	);
+	lua_pushboolean(L, store->waitForValue(key, timeout));
+	return 1;
+}
 
-	bool ret;
-	{
-		SharedReadLock autolock(store->mutex);
+int ModApiIPC::l_ipc_version(lua_State *L)
+{
+	auto *store = getGameDef(L)->getModIPCStore();
 
-		// wait until value exists or timeout
-		ret = store->condvar.wait_for(autolock, timeout, [&] () -> bool {
-			return store->map.count(key) != 0;
-		});
-	}
+	auto key = readParam<std::string>(L, 1);
+
+	lua_pushnumber(L, store->getVersion(key));
+	return 1;
+}
+
+int ModApiIPC::l_ipc_wait(lua_State *L)
+{
+	auto *store = getGameDef(L)->getModIPCStore();
+
+	auto key = readParam<std::string>(L, 1);
+	u64 version = luaL_checknumber(L, 2);
+	auto timeout = read_timeout(L, 3);
 
-	lua_pushboolean(L, ret);
+	lua_pushboolean(L, store->waitForChange(key, version, timeout));
 	return 1;
 }
 
@@ -138,4 +140,6 @@ void ModApiIPC::Initialize(lua_State *L, int top)
 	API_FCT(ipc_set);
 	API_FCT(ipc_cas);
 	API_FCT(ipc_poll);
+	API_FCT(ipc_version);
+	API_FCT(ipc_wait);
 }
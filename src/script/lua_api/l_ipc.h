@@ -11,6 +11,8 @@ class ModApiIPC : public ModApiBase {
 	static int l_ipc_set(lua_State *L);
 	static int l_ipc_cas(lua_State *L);
 	static int l_ipc_poll(lua_State *L);
+	static int l_ipc_version(lua_State *L);
+	static int l_ipc_wait(lua_State *L);
 
 public:
 	static void Initialize(lua_State *L, int top);
@@ -146,6 +146,22 @@ int ObjectRef::l_get_pos(lua_State *L)
 	return 1;
 }
 
+// get_pos_xyz(self)
+int ObjectRef::l_get_pos_xyz(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+	ObjectRef *ref = checkObject<ObjectRef>(L, 1);
+	ServerActiveObject *sao = getobject(ref);
+	if (sao == nullptr)
+		return 0;
+
+	v3f pos = sao->getBasePosition() / BS;
+	lua_pushnumber(L, pos.X);
+	lua_pushnumber(L, pos.Y);
+	lua_pushnumber(L, pos.Z);
+	return 3;
+}
+
 // set_pos(self, pos)
 int ObjectRef::l_set_pos(lua_State *L)
 {
@@ -1071,6 +1087,22 @@ int ObjectRef::l_set_velocity(lua_State *L)
 	return 0;
 }
 
+// set_velocity_xyz(self, x, y, z)
+int ObjectRef::l_set_velocity_xyz(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+	ObjectRef *ref = checkObject<ObjectRef>(L, 1);
+	LuaEntitySAO *sao = getluaobject(ref);
+	if (sao == nullptr)
+		return 0;
+
+	v3f vel(luaL_checknumber(L, 2), luaL_checknumber(L, 3),
+		luaL_checknumber(L, 4));
+
+	sao->setVelocity(vel * BS);
+	return 0;
+}
+
 // add_velocity(self, velocity)
 int ObjectRef::l_add_velocity(lua_State *L)
 {
@@ -1118,6 +1150,29 @@ int ObjectRef::l_get_velocity(lua_State *L)
 	return 1;
 }
 
+// get_velocity_xyz(self)
+int ObjectRef::l_get_velocity_xyz(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+	ObjectRef *ref = checkObject<ObjectRef>(L, 1);
+	ServerActiveObject *sao = getobject(ref);
+	if (sao == nullptr)
+		return 0;
+
+	v3f vel;
+	if (sao->getType() == ACTIVEOBJECT_TYPE_LUAENTITY)
+		vel = static_cast<LuaEntitySAO *>(sao)->getVelocity() / BS;
+	else if (sao->getType() == ACTIVEOBJECT_TYPE_PLAYER)
+		vel = static_cast<PlayerSAO *>(sao)->getPlayer()->getSpeed() / BS;
+	else
+		return 0;
+
+	lua_pushnumber(L, vel.X);
+	lua_pushnumber(L, vel.Y);
+	lua_pushnumber(L, vel.Z);
+	return 3;
+}
+
 // set_acceleration(self, acceleration)
 int ObjectRef::l_set_acceleration(lua_State *L)
 {
@@ -2858,6 +2913,7 @@ luaL_Reg ObjectRef::methods[] = {
 	luamethod(ObjectRef, is_valid),
 	luamethod(ObjectRef, get_guid),
 	luamethod_aliased(ObjectRef, get_pos, getpos),
+	luamethod(ObjectRef, get_pos_xyz),
 	luamethod_aliased(ObjectRef, set_pos, setpos),
 	luamethod(ObjectRef, add_pos),
 	luamethod_aliased(ObjectRef, move_to, moveto),
@@ -2893,9 +2949,11 @@ luaL_Reg ObjectRef::methods[] = {
 	luamethod(ObjectRef, get_effective_observers),
 
 	luamethod_aliased(ObjectRef, set_velocity, setvelocity),
+	luamethod(ObjectRef, set_velocity_xyz),
 	luamethod_aliased(ObjectRef, add_velocity, add_player_velocity),
 	luamethod_aliased(ObjectRef, get_velocity, getvelocity),
 	luamethod_dep(ObjectRef, get_velocity, get_player_velocity),
+	luamethod(ObjectRef, get_velocity_xyz),
 
 	// LuaEntitySAO-only
 	luamethod_aliased(ObjectRef, set_acceleration, setacceleration),
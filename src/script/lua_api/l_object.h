@@ -67,6 +67,9 @@ class ObjectRef : public ModApiBase {
 	// get_pos(self)
 	static int l_get_pos(lua_State *L);
 
+	// get_pos_xyz(self)
+	static int l_get_pos_xyz(lua_State *L);
+
 	// set_pos(self, pos)
 	static int l_set_pos(lua_State *L);
 
@@ -174,12 +177,18 @@ class ObjectRef : public ModApiBase {
 	// set_velocity(self, velocity)
 	static int l_set_velocity(lua_State *L);
 
+	// set_velocity_xyz(self, x, y, z)
+	static int l_set_velocity_xyz(lua_State *L);
+
 	// add_velocity(self, velocity)
 	static int l_add_velocity(lua_State *L);
 
 	// get_velocity(self)
 	static int l_get_velocity(lua_State *L);
 
+	// get_velocity_xyz(self)
+	static int l_get_velocity_xyz(lua_State *L);
+
 	// set_acceleration(self, acceleration)
 	static int l_set_acceleration(lua_State *L);
 
@@ -245,6 +245,14 @@ int ModApiServer::l_get_player_information(lua_State *L)
 	lua_pushstring(L, info.vers_string.c_str());
 	lua_settable(L, table);
 
+	lua_pushstring(L, "block_send_window");
+	lua_pushnumber(L, info.block_send_window);
+	lua_settable(L, table);
+
+	lua_pushstring(L, "block_throughput");
+	lua_pushnumber(L, info.block_throughput);
+	lua_settable(L, table);
+
 #ifndef NDEBUG
 	lua_pushstring(L,"serialization_version");
 	lua_pushnumber(L, info.ser_vers);
@@ -14,6 +14,30 @@
 #include "servermap.h"
 #include "voxelalgorithms.h"
 
+// Returns the argument at `idx` if it is a VoxelBuffer, checking its type
+static LuaVoxelBuffer *check_buffer(lua_State *L, int idx,
+		LuaVoxelBuffer::Type type, const char *func)
+{
+	LuaVoxelBuffer *buf = LuaVoxelBuffer::toBuffer(L, idx);
+	if (buf && buf->getType() != type) {
+		throw LuaError(std::string("VoxelManip:") + func + " expects a " +
+				(type == LuaVoxelBuffer::U16 ? "u16" : "u8") + " VoxelBuffer");
+	}
+	return buf;
+}
+
+// Returns the argument at `idx` if it is a VoxelBuffer large enough for `volume`
+static LuaVoxelBuffer *check_buffer(lua_State *L, int idx,
+		LuaVoxelBuffer::Type type, const char *func, u32 volume)
+{
+	LuaVoxelBuffer *buf = check_buffer(L, idx, type, func);
+	if (buf && buf->getLength() < volume) {
+		throw LuaError(std::string("VoxelManip:") + func +
+				" called with a VoxelBuffer that is too small");
+	}
+	return buf;
+}
+
 // garbage collector
 int LuaVoxelManip::gc_object(lua_State *L)
 {
@@ -90,6 +114,14 @@ int LuaVoxelManip::l_get_data(lua_State *L)
 	MMVManip *vm = o->vm;
 	const u32 volume = vm->m_area.getVolume();
 
+	if (LuaVoxelBuffer *buf = check_buffer(L, 2, LuaVoxelBuffer::U16, "get_data")) {
+		u16 *data = buf->overwriteData16(volume);
+		for (u32 i = 0; i != volume; i++)
+			data[i] = (vm->m_flags[i] & VOXELFLAG_NO_DATA) ? CONTENT_IGNORE : vm->m_data[i].getContent();
+		lua_pushvalue(L, 2);
+		return 1;
+	}
+
 	if (use_buffer)
 		lua_pushvalue(L, 2);
 	else
@@ -112,17 +144,23 @@ int LuaVoxelManip::l_set_data(lua_State *L)
 	LuaVoxelManip *o = checkObject<LuaVoxelManip>(L, 1);
 	MMVManip *vm = o->vm;
 
-	if (!lua_istable(L, 2))
-		throw LuaError("VoxelManip:set_data called with missing parameter");
-
 	u32 volume = vm->m_area.getVolume();
-	for (u32 i = 0; i != volume; i++) {
-		lua_rawgeti(L, 2, i + 1);
-		content_t c = lua_tointeger(L, -1);
+	if (LuaVoxelBuffer *buf = check_buffer(L, 2, LuaVoxelBuffer::U16, "set_data", volume)) {
+		const u16 *data = buf->getData16();
+		for (u32 i = 0; i != volume; i++)
+			vm->m_data[i].setContent(data[i]);
+	} else {
+		if (!lua_istable(L, 2))
+			throw LuaError("VoxelManip:set_data called with missing parameter");
 
-		vm->m_data[i].setContent(c);
+		for (u32 i = 0; i != volume; i++) {
+			lua_rawgeti(L, 2, i + 1);
+			content_t c = lua_tointeger(L, -1);
 
-		lua_pop(L, 1);
+			vm->m_data[i].setContent(c);
+
+			lua_pop(L, 1);
+		}
 	}
 
 	// Mark all data as present, since we just got it from Lua
@@ -257,6 +295,14 @@ int LuaVoxelManip::l_get_light_data(lua_State *L)
 	MMVManip *vm = o->vm;
 	const u32 volume = vm->m_area.getVolume();
 
+	if (LuaVoxelBuffer *buf = check_buffer(L, 2, LuaVoxelBuffer::U8, "get_light_data")) {
+		u8 *data = buf->overwriteData8(volume);
+		for (u32 i = 0; i != volume; i++)
+			data[i] = (vm->m_flags[i] & VOXELFLAG_NO_DATA) ? 0 : vm->m_data[i].getParam1();
+		lua_pushvalue(L, 2);
+		return 1;
+	}
+
 	if (use_buffer)
 		lua_pushvalue(L, 2);
 	else
@@ -279,11 +325,18 @@ int LuaVoxelManip::l_set_light_data(lua_State *L)
 	LuaVoxelManip *o = checkObject<LuaVoxelManip>(L, 1);
 	MMVManip *vm = o->vm;
 
+	u32 volume = vm->m_area.getVolume();
+	if (LuaVoxelBuffer *buf = check_buffer(L, 2, LuaVoxelBuffer::U8, "set_light_data", volume)) {
+		const u8 *data = buf->getData8();
+		for (u32 i = 0; i != volume; i++)
+			vm->m_data[i].param1 = data[i];
+		return 0;
+	}
+
 	if (!lua_istable(L, 2))
 		throw LuaError("VoxelManip:set_light_data called with missing "
 				"parameter");
 
-	u32 volume = vm->m_area.getVolume();
 	for (u32 i = 0; i != volume; i++) {
 		lua_rawgeti(L, 2, i + 1);
 		u8 light = lua_tointeger(L, -1);
@@ -306,6 +359,14 @@ int LuaVoxelManip::l_get_param2_data(lua_State *L)
 	MMVManip *vm = o->vm;
 	const u32 volume = vm->m_area.getVolume();
 
+	if (LuaVoxelBuffer *buf = check_buffer(L, 2, LuaVoxelBuffer::U8, "get_param2_data")) {
+		u8 *data = buf->overwriteData8(volume);
+		for (u32 i = 0; i != volume; i++)
+			data[i] = (vm->m_flags[i] & VOXELFLAG_NO_DATA) ? 0 : vm->m_data[i].getParam2();
+		lua_pushvalue(L, 2);
+		return 1;
+	}
+
 	if (use_buffer)
 		lua_pushvalue(L, 2);
 	else
@@ -328,11 +389,18 @@ int LuaVoxelManip::l_set_param2_data(lua_State *L)
 	LuaVoxelManip *o = checkObject<LuaVoxelManip>(L, 1);
 	MMVManip *vm = o->vm;
 
+	u32 volume = vm->m_area.getVolume();
+	if (LuaVoxelBuffer *buf = check_buffer(L, 2, LuaVoxelBuffer::U8, "set_param2_data", volume)) {
+		const u8 *data = buf->getData8();
+		for (u32 i = 0; i != volume; i++)
+			vm->m_data[i].param2 = data[i];
+		return 0;
+	}
+
 	if (!lua_istable(L, 2))
 		throw LuaError("VoxelManip:set_param2_data called with missing "
 				"parameter");
 
-	u32 volume = vm->m_area.getVolume();
 	for (u32 i = 0; i != volume; i++) {
 		lua_rawgeti(L, 2, i + 1);
 		u8 param2 = lua_tointeger(L, -1);
@@ -501,3 +569,262 @@ const luaL_Reg LuaVoxelManip::methods[] = {
 	luamethod(LuaVoxelManip, close),
 	{0,0}
 };
+
+///////////////////////////////////////
+/*
+	LuaVoxelBuffer
+*/
+
+LuaVoxelBuffer::LuaVoxelBuffer(Type type, u32 length) :
+	m_type(type)
+{
+	if (m_type == U16)
+		m_data16 = std::make_shared<std::vector<u16>>(length);
+	else
+		m_data8 = std::make_shared<std::vector<u8>>(length);
+}
+
+LuaVoxelBuffer::LuaVoxelBuffer(std::string_view bytes) :
+	m_type(U8),
+	m_data8(std::make_shared<std::vector<u8>>(bytes.begin(), bytes.end()))
+{
+}
+
+u32 LuaVoxelBuffer::getLength() const
+{
+	return m_type == U16 ? m_data16->size() : m_data8->size();
+}
+
+void LuaVoxelBuffer::detach()
+{
+	// Another owner can only drop its reference meanwhile, at worst
+	// causing an unneeded copy
+	if (m_type == U16) {
+		if (m_data16.use_count() > 1)
+			m_data16 = std::make_shared<std::vector<u16>>(*m_data16);
+	} else {
+		if (m_data8.use_count() > 1)
+			m_data8 = std::make_shared<std::vector<u8>>(*m_data8);
+	}
+}
+
+u8 *LuaVoxelBuffer::overwriteData8(u32 length)
+{
+	assert(m_type == U8);
+	if (m_data8.use_count() > 1)
+		m_data8 = std::make_shared<std::vector<u8>>(length);
+	else
+		m_data8->resize(length);
+	return m_data8->data();
+}
+
+u16 *LuaVoxelBuffer::overwriteData16(u32 length)
+{
+	assert(m_type == U16);
+	if (m_data16.use_count() > 1)
+		m_data16 = std::make_shared<std::vector<u16>>(length);
+	else
+		m_data16->resize(length);
+	return m_data16->data();
+}
+
+int LuaVoxelBuffer::gc_object(lua_State *L)
+{
+	LuaVoxelBuffer *o = *(LuaVoxelBuffer **)(lua_touserdata(L, 1));
+	delete o;
+	return 0;
+}
+
+int LuaVoxelBuffer::mt_index(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	// Only called for buffers, skip the type check as this is hot
+	LuaVoxelBuffer *o = *(LuaVoxelBuffer **)(lua_touserdata(L, 1));
+	if (lua_type(L, 2) != LUA_TNUMBER) {
+		// Method lookup
+		lua_pushvalue(L, 2);
+		lua_rawget(L, lua_upvalueindex(1));
+		return 1;
+	}
+
+	lua_Integer i = lua_tointeger(L, 2);
+	if (i < 1 || i > o->getLength()) {
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_pushinteger(L, o->m_type == U16 ? (*o->m_data16)[i - 1] : (*o->m_data8)[i - 1]);
+	return 1;
+}
+
+int LuaVoxelBuffer::mt_newindex(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	// Only called for buffers, skip the type check as this is hot
+	LuaVoxelBuffer *o = *(LuaVoxelBuffer **)(lua_touserdata(L, 1));
+	lua_Integer i = luaL_checkinteger(L, 2);
+	lua_Integer value = luaL_checkinteger(L, 3);
+	if (i < 1 || i > o->getLength())
+		throw LuaError("VoxelBuffer index out of range");
+
+	o->detach();
+	if (o->m_type == U16)
+		(*o->m_data16)[i - 1] = value;
+	else
+		(*o->m_data8)[i - 1] = value;
+	return 0;
+}
+
+int LuaVoxelBuffer::mt_len(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelBuffer *o = checkObject<LuaVoxelBuffer>(L, 1);
+	lua_pushinteger(L, o->getLength());
+	return 1;
+}
+
+int LuaVoxelBuffer::l_get_type(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelBuffer *o = checkObject<LuaVoxelBuffer>(L, 1);
+	lua_pushstring(L, o->m_type == U16 ? "u16" : "u8");
+	return 1;
+}
+
+int LuaVoxelBuffer::l_get_pointer(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelBuffer *o = checkObject<LuaVoxelBuffer>(L, 1);
+	// The pointer might be written to
+	o->detach();
+	if (o->m_type == U16)
+		lua_pushlightuserdata(L, o->m_data16->data());
+	else
+		lua_pushlightuserdata(L, o->m_data8->data());
+	return 1;
+}
+
+int LuaVoxelBuffer::l_to_table(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelBuffer *o = checkObject<LuaVoxelBuffer>(L, 1);
+	const u32 length = o->getLength();
+	lua_createtable(L, length, 0);
+	for (u32 i = 0; i != length; i++) {
+		lua_pushinteger(L, o->m_type == U16 ? (*o->m_data16)[i] : (*o->m_data8)[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+int LuaVoxelBuffer::l_to_string(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	LuaVoxelBuffer *o = checkObject<LuaVoxelBuffer>(L, 1);
+	if (o->m_type != U8)
+		throw LuaError("VoxelBuffer:to_string called for a u16 buffer");
+	lua_pushlstring(L, reinterpret_cast<const char *>(o->m_data8->data()),
+			o->m_data8->size());
+	return 1;
+}
+
+int LuaVoxelBuffer::create_object(lua_State *L)
+{
+	NO_MAP_LOCK_REQUIRED;
+
+	std::string type_str = luaL_checkstring(L, 1);
+	Type type;
+	if (type_str == "u16")
+		type = U16;
+	else if (type_str == "u8")
+		type = U8;
+	else
+		throw LuaError("VoxelBuffer: unknown type \"" + type_str + "\"");
+
+	LuaVoxelBuffer *o;
+	if (lua_type(L, 2) == LUA_TSTRING) {
+		if (type != U8)
+			throw LuaError("VoxelBuffer: only u8 buffers can be created from a string");
+		size_t len;
+		const char *str = lua_tolstring(L, 2, &len);
+		o = new LuaVoxelBuffer(std::string_view(str, len));
+	} else {
+		lua_Integer length = luaL_optinteger(L, 2, 0);
+		if (length < 0 || length > U32_MAX)
+			throw LuaError("VoxelBuffer: invalid length");
+		o = new LuaVoxelBuffer(type, length);
+	}
+
+	*(void **)(lua_newuserdata(L, sizeof(void *))) = o;
+	luaL_getmetatable(L, className);
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+LuaVoxelBuffer *LuaVoxelBuffer::toBuffer(lua_State *L, int idx)
+{
+	if (!lua_isuserdata(L, idx) || !lua_getmetatable(L, idx))
+		return nullptr;
+	luaL_getmetatable(L, className);
+	bool is_buffer = lua_rawequal(L, -1, -2);
+	lua_pop(L, 2);
+	return is_buffer ? *(LuaVoxelBuffer **)lua_touserdata(L, idx) : nullptr;
+}
+
+void *LuaVoxelBuffer::packIn(lua_State *L, int idx)
+{
+	// Shares the elements
+	LuaVoxelBuffer *o = checkObject<LuaVoxelBuffer>(L, idx);
+	return new LuaVoxelBuffer(*o);
+}
+
+void LuaVoxelBuffer::packOut(lua_State *L, void *ptr)
+{
+	LuaVoxelBuffer *o = reinterpret_cast<LuaVoxelBuffer*>(ptr);
+	if (!L) {
+		delete o;
+		return;
+	}
+
+	*(void **)(lua_newuserdata(L, sizeof(void *))) = o;
+	luaL_getmetatable(L, className);
+	lua_setmetatable(L, -2);
+}
+
+void LuaVoxelBuffer::Register(lua_State *L)
+{
+	static const luaL_Reg metamethods[] = {
+		{"__gc", gc_object},
+		{"__newindex", mt_newindex},
+		{"__len", mt_len},
+		{0, 0}
+	};
+	registerClass<LuaVoxelBuffer>(L, methods, metamethods);
+
+	// Replace the method table as __index, so that elements can be indexed
+	luaL_getmetatable(L, className);
+	lua_getfield(L, -1, "__metatable");
+	lua_pushcclosure(L, mt_index, 1);
+	lua_setfield(L, -2, "__index");
+	lua_pop(L, 1);
+
+	// Can be created from Lua (VoxelBuffer(type, [length]))
+	lua_register(L, className, create_object);
+
+	script_register_packer(L, className, packIn, packOut);
+}
+
+const char LuaVoxelBuffer::className[] = "VoxelBuffer";
+const luaL_Reg LuaVoxelBuffer::methods[] = {
+	luamethod(LuaVoxelBuffer, get_type),
+	luamethod(LuaVoxelBuffer, get_pointer),
+	luamethod(LuaVoxelBuffer, to_table),
+	luamethod(LuaVoxelBuffer, to_string),
+	{0,0}
+};
@@ -6,6 +6,9 @@
 
 #include "irr_v3d.h"
 #include "lua_api/l_base.h"
+#include <memory>
+#include <string_view>
+#include <vector>
 
 class Map;
 class MMVManip;
@@ -67,3 +70,77 @@ class LuaVoxelManip : public ModApiBase
 
 	static const char className[];
 };
+
+/*
+	VoxelBuffer
+
+	Flat array of node content IDs (u16) or params (u8) that VoxelManip
+	can read from and write to in bulk, without a Lua table in between.
+
+	The elements are shared copy-on-write between buffers, so passing a
+	buffer to another Lua state (async, mapgen) does not copy them.
+*/
+class LuaVoxelBuffer : public ModApiBase
+{
+public:
+	enum Type : u8 {
+		U8,
+		U16,
+	};
+
+private:
+	Type m_type;
+	// Only the one of m_type is used. Never modified while shared.
+	std::shared_ptr<std::vector<u8>> m_data8;
+	std::shared_ptr<std::vector<u16>> m_data16;
+
+	// Makes sure the elements are not shared, so they can be modified
+	void detach();
+
+	static const luaL_Reg methods[];
+
+	static int gc_object(lua_State *L);
+
+	// buffer[i], also looks up the methods
+	static int mt_index(lua_State *L);
+	// buffer[i] = value
+	static int mt_newindex(lua_State *L);
+	// #buffer
+	static int mt_len(lua_State *L);
+
+	// get_type(self) -> "u8" or "u16"
+	static int l_get_type(lua_State *L);
+	// get_pointer(self) -> light userdata
+	static int l_get_pointer(lua_State *L);
+	// to_table(self) -> table
+	static int l_to_table(lua_State *L);
+	// to_string(self) -> string
+	static int l_to_string(lua_State *L);
+
+public:
+	LuaVoxelBuffer(Type type, u32 length);
+	LuaVoxelBuffer(std::string_view bytes);
+
+	Type getType() const { return m_type; }
+	u32 getLength() const;
+
+	const u8 *getData8() const { return m_data8->data(); }
+	const u16 *getData16() const { return m_data16->data(); }
+	// Returns unshared elements to overwrite, resized to `length` (old values are lost)
+	u8 *overwriteData8(u32 length);
+	u16 *overwriteData16(u32 length);
+
+	// VoxelBuffer(type, [length]) or VoxelBuffer(string)
+	// Creates a LuaVoxelBuffer and leaves it on top of stack
+	static int create_object(lua_State *L);
+
+	// Returns the buffer at `idx`, or nullptr if it is something else
+	static LuaVoxelBuffer *toBuffer(lua_State *L, int idx);
+
+	static void *packIn(lua_State *L, int idx);
+	static void packOut(lua_State *L, void *ptr);
+
+	static void Register(lua_State *L);
+
+	static const char className[];
+};
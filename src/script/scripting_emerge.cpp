@@ -66,6 +66,7 @@ void EmergeScripting::InitializeModApi(lua_State *L, int top)
 	LuaPcgRandom::Register(L);
 	LuaSecureRandom::Register(L);
 	LuaVoxelManip::Register(L);
+	LuaVoxelBuffer::Register(L);
 	LuaSettings::Register(L);
 
 	// Initialize mod api modules
@@ -23,12 +23,15 @@
 #include "profiler.h"
 #include "remoteplayer.h"
 #include "server/ban.h"
+#include "server/nodechanges.h"
 #include "serverenvironment.h"
 #include "servermap.h"
 #include "server/player_sao.h"
 #include "server/rollback.h"
 #include "server/serveractiveobject.h"
 #include "server/serverinventorymgr.h"
+#include "script/common/c_chunkcache.h"
+#include "threading/parallel.h"
 #include "server/serverlist.h"
 #include "settings.h"
 #include "translation.h"
@@ -83,15 +86,6 @@ class ClientNotFoundException : public BaseException
 	{}
 };
 
-ModIPCStore::~ModIPCStore()
-{
-	// we don't have to do this, it's pure debugging aid
-	if (!std::unique_lock(mutex, std::try_to_lock).owns_lock()) {
-		errorstream << FUNCTION_NAME << ": lock is still in use!" << std::endl;
-		assert(0);
-	}
-}
-
 class ServerThread : public Thread
 {
 public:
@@ -269,14 +263,17 @@ Server::Server(
 		Address bind_addr,
 		bool dedicated,
 		ChatInterface *iface,
-		std::string *shutdown_errmsg
+		std::string *shutdown_errmsg,
+		std::shared_ptr<con::IConnection> replay_con
 	):
 	m_bind_addr(bind_addr),
 	m_path_world(path_world),
 	m_gamespec(gamespec),
 	m_simple_singleplayer_mode(simple_singleplayer_mode),
 	m_dedicated(dedicated),
-	m_con(con::createMTP(CONNECTION_TIMEOUT, m_bind_addr.isIPv6(), this)),
+	m_con(replay_con ? replay_con :
+		std::shared_ptr<con::IConnection>(con::createMTP(CONNECTION_TIMEOUT, m_bind_addr.isIPv6(), this))),
+	m_packet_replay(replay_con != nullptr),
 	m_itemdef(createItemDefManager()),
 	m_nodedef(createNodeDefManager()),
 	m_craftdef(createCraftDefManager()),
@@ -334,6 +331,22 @@ Server::Server(
 			"minetest_core_map_edit_events",
 			"Number of map edit events");
 
+	m_block_send_window_gauge = m_metrics_backend->addGauge(
+			"minetest_core_block_send_window",
+			"Average block send window of the active clients");
+
+	m_block_send_throughput_gauge = m_metrics_backend->addGauge(
+			"minetest_core_block_send_throughput",
+			"Acknowledged block data (in bytes per second)");
+
+	m_blocks_in_flight_gauge = m_metrics_backend->addGauge(
+			"minetest_core_blocks_in_flight",
+			"Number of blocks sent but not yet acknowledged");
+
+	m_mods_load_time_gauge = m_metrics_backend->addGauge(
+			"minetest_core_mods_load_time",
+			"Time it took to load builtin and the mods (in seconds)");
+
 	m_lag_gauge->set(g_settings->getFloat("dedicated_server_step"));
 
 	m_path_mod_data = porting::path_user + DIR_DELIM "mod_data";
@@ -440,6 +453,15 @@ Server::~Server()
 
 void Server::init()
 {
+	// Duration of each phase of the startup, for the log
+	std::vector<std::pair<const char *, u64>> startup_phases;
+	u64 phase_start = porting::getTimeMs();
+	auto end_phase = [&] (const char *name) {
+		u64 now = porting::getTimeMs();
+		startup_phases.emplace_back(name, now - phase_start);
+		phase_start = now;
+	};
+
 	infostream << "Server created for gameid \"" << m_gamespec.id << "\"";
 	if (m_simple_singleplayer_mode)
 		infostream << " in simple singleplayer mode" << std::endl;
@@ -492,8 +514,16 @@ void Server::init()
 			"corrupted or in an unsupported format.\n") + e.what());
 	}
 
+	end_phase("world");
+
+	// Compiled Lua chunks are kept between restarts
+	ChunkCache::setDirectory(g_settings->getBool("lua_chunk_cache") ?
+			porting::path_cache + DIR_DELIM + "luachunks" : "");
+
 	// Initialize scripting
 	infostream << "Server: Initializing Lua" << std::endl;
+	const u64 load_start = porting::getTimeUs();
+	const auto chunk_stats = ChunkCache::getStats();
 
 	m_script = std::make_unique<ServerScripting>(this);
 
@@ -505,10 +535,22 @@ void Server::init()
 	m_gamespec.checkAndLog();
 	m_modmgr->loadMods(*m_script);
 
+	{
+		const float load_time = (porting::getTimeUs() - load_start) / 1e6f;
+		m_mods_load_time_gauge->set(load_time);
+		const auto stats = ChunkCache::getStats();
+		actionstream << "Server: Loaded builtin and mods in " << load_time << " s, "
+			<< (stats.load_time_us - chunk_stats.load_time_us) / 1000 << " ms of it"
+			<< " loading Lua chunks (" << (stats.hits - chunk_stats.hits) << " cached, "
+			<< (stats.misses - chunk_stats.misses) << " compiled)" << std::endl;
+	}
+
 	m_script->saveGlobals();
+	end_phase("mods");
 
 	// Read Textures and calculate sha1 sums
 	fillMediaCache();
+	end_phase("media");
 
 	// Apply item aliases in the node definition manager
 	m_nodedef->updateAliases(m_itemdef);
@@ -531,8 +573,17 @@ void Server::init()
 	// unmap node names in cross-references
 	m_nodedef->resolveCrossrefs();
 
-	// init the recipe hashes to speed up crafting
-	m_craftdef->initHashes(this);
+	// The definitions are final now: serialize them for the clients in the
+	// background, while the recipe hashes are initialized to speed up crafting
+	parallel_for(2, 1, [this] (size_t begin, size_t end) {
+		for (size_t task = begin; task < end; task++) {
+			if (task == 0)
+				m_craftdef->initHashes(this);
+			else
+				getSerializedDefs(LATEST_PROTOCOL_VERSION);
+		}
+	});
+	end_phase("definitions");
 
 	// Initialize Environment
 	m_env = new ServerEnvironment(std::move(startup_server_map),
@@ -563,6 +614,17 @@ void Server::init()
 	servermap.addEventReceiver(this);
 
 	m_env->loadMeta();
+	end_phase("environment");
+
+	{
+		u64 total = 0;
+		auto &os = actionstream << "Server: Startup phases:";
+		for (auto &phase : startup_phases) {
+			os << " " << phase.first << " " << phase.second << " ms,";
+			total += phase.second;
+		}
+		os << " total " << total << " ms" << std::endl;
+	}
 
 	// Those settings can be overwritten in world.mt, they are
 	// intended to be cached after environment loading.
@@ -584,6 +646,14 @@ void Server::start()
 	// Initialize connection
 	m_con->Serve(m_bind_addr);
 
+	const std::string capture_path = g_settings->get("packet_capture_file");
+	if (!capture_path.empty() && !m_packet_replay) {
+		if (m_con->startPacketCapture(capture_path))
+			actionstream << "Server: writing packet capture to " << capture_path << std::endl;
+		else
+			errorstream << "Server: cannot write packet capture to " << capture_path << std::endl;
+	}
+
 	// Start thread
 	m_thread->start();
 
@@ -972,11 +1042,6 @@ void Server::AsyncRunStep(float dtime, bool initial_step)
 		// We will be accessing the environment
 		EnvAutoLock lock(this);
 
-		// Single change sending is disabled if queue size is big
-		bool disable_single_change_sending = false;
-		if(m_unsent_map_edit_queue.size() >= 4)
-			disable_single_change_sending = true;
-
 		const auto event_count = m_unsent_map_edit_queue.size();
 		m_map_edit_event_counter->increment(event_count);
 
@@ -985,29 +1050,30 @@ void Server::AsyncRunStep(float dtime, bool initial_step)
 
 		size_t block_count = 0;
 		std::unordered_set<v3s16> node_meta_updates;
+		// Single node changes, grouped by block
+		std::unordered_map<v3s16, NodeChangeList> node_changes;
 
 		while (!m_unsent_map_edit_queue.empty()) {
 			MapEditEvent* event = m_unsent_map_edit_queue.front();
 			m_unsent_map_edit_queue.pop();
 
-			// Players far away from the change are stored here.
-			// Instead of sending the changes, MapBlocks are set not sent
-			// for them.
-			std::unordered_set<u16> far_players;
-
 			switch (event->type) {
 			case MEET_ADDNODE:
 			case MEET_SWAPNODE:
-				prof.add("MEET_ADDNODE", 1);
-				sendAddNode(event->p, event->n, &far_players,
-						disable_single_change_sending ? 5 : 30,
-						event->type == MEET_ADDNODE);
-				break;
-			case MEET_REMOVENODE:
-				prof.add("MEET_REMOVENODE", 1);
-				sendRemoveNode(event->p, &far_players,
-						disable_single_change_sending ? 5 : 30);
+			case MEET_REMOVENODE: {
+				prof.add(event->type == MEET_REMOVENODE ?
+						"MEET_REMOVENODE" : "MEET_ADDNODE", 1);
+				v3s16 block_pos = getNodeBlockPos(event->p);
+				NodeChangeList &changes = node_changes[block_pos];
+				if (event->type == MEET_REMOVENODE)
+					changes.add(event->p - block_pos * MAP_BLOCKSIZE,
+							MapNode(CONTENT_AIR), false);
+				else
+					changes.add(event->p - block_pos * MAP_BLOCKSIZE,
+							event->n, event->type == MEET_SWAPNODE);
+				changes.addModifiedBlocks(event->modified_blocks);
 				break;
+			}
 			case MEET_BLOCK_NODE_METADATA_CHANGED: {
 				prof.add("MEET_BLOCK_NODE_METADATA_CHANGED", 1);
 				if (!event->is_private_change) {
@@ -1034,14 +1100,6 @@ void Server::AsyncRunStep(float dtime, bool initial_step)
 
 			block_count += event->modified_blocks.size();
 
-			/*
-				Set blocks not sent to far players
-			*/
-			for (const u16 far_player : far_players) {
-				if (RemoteClient *client = getClient(far_player))
-					client->SetBlocksNotSent(event->modified_blocks);
-			}
-
 			delete event;
 		}
 
@@ -1051,6 +1109,10 @@ void Server::AsyncRunStep(float dtime, bool initial_step)
 			prof.print(verbosestream);
 		}
 
+		// Send all node changes
+		if (!node_changes.empty())
+			sendNodeChanges(node_changes);
+
 		// Send all metadata updates
 		if (!node_meta_updates.empty())
 			sendMetadataChanged(node_meta_updates);
@@ -1403,6 +1465,9 @@ bool Server::getClientInfo(session_t peer_id, ClientInfo &ret)
 
 	ret.lang_code = client->getLangCode();
 
+	ret.block_send_window = client->getSendWindow().getSize();
+	ret.block_throughput = client->getSendWindow().getThroughput();
+
 	return true;
 }
 
@@ -1499,24 +1564,40 @@ void Server::SendAccessDenied(session_t peer_id, AccessDeniedCode reason,
 	Send(&pkt);
 }
 
-void Server::SendItemDef(session_t peer_id,
-		IItemDefManager *itemdef, u16 protocol_version)
+const Server::SerializedDefs &Server::getSerializedDefs(u16 protocol_version)
 {
-	auto *client = m_clients.getClientNoEx(peer_id, CS_Created);
-	assert(client);
+	// The definitions can not change after startup, so this is done once
+	std::lock_guard lock(m_serialized_defs_mutex);
+	auto it = m_serialized_defs.find(protocol_version);
+	if (it != m_serialized_defs.end())
+		return it->second;
 
-	NetworkPacket pkt(TOCLIENT_ITEMDEF, 0, peer_id);
-
-	std::ostringstream tmp_os2(std::ios::binary);
-	{
-		std::ostringstream tmp_os(std::ios::binary);
-		itemdef->serialize(tmp_os, protocol_version);
-		if (client->net_proto_version >= 48)
-			compressZstd(tmp_os.str(), tmp_os2);
+	SerializedDefs &defs = m_serialized_defs[protocol_version];
+	auto compress = [protocol_version] (const std::string &data) {
+		std::ostringstream os(std::ios::binary);
+		if (protocol_version >= 48)
+			compressZstd(data, os);
 		else
-			compressZlib(tmp_os.str(), tmp_os2);
+			compressZlib(data, os);
+		return os.str();
+	};
+	{
+		std::ostringstream os(std::ios::binary);
+		m_itemdef->serialize(os, protocol_version);
+		defs.items = compress(os.str());
+	}
+	{
+		std::ostringstream os(std::ios::binary);
+		m_nodedef->serialize(os, protocol_version);
+		defs.nodes = compress(os.str());
 	}
-	pkt.putLongString(tmp_os2.str());
+	return defs;
+}
+
+void Server::SendItemDef(session_t peer_id, u16 protocol_version)
+{
+	NetworkPacket pkt(TOCLIENT_ITEMDEF, 0, peer_id);
+	pkt.putLongString(getSerializedDefs(protocol_version).items);
 
 	// Make data buffer
 	verbosestream << "Server: Sending item definitions to id(" << peer_id
@@ -1525,24 +1606,10 @@ void Server::SendItemDef(session_t peer_id,
 	Send(&pkt);
 }
 
-void Server::SendNodeDef(session_t peer_id,
-	const NodeDefManager *nodedef, u16 protocol_version)
+void Server::SendNodeDef(session_t peer_id, u16 protocol_version)
 {
-	auto *client = m_clients.getClientNoEx(peer_id, CS_Created);
-	assert(client);
-
 	NetworkPacket pkt(TOCLIENT_NODEDEF, 0, peer_id);
-
-	std::ostringstream tmp_os2(std::ios::binary);
-	{
-		std::ostringstream tmp_os(std::ios::binary);
-		nodedef->serialize(tmp_os, protocol_version);
-		if (client->net_proto_version >= 48)
-			compressZstd(tmp_os.str(), tmp_os2);
-		else
-			compressZlib(tmp_os.str(), tmp_os2);
-	}
-	pkt.putLongString(tmp_os2.str());
+	pkt.putLongString(getSerializedDefs(protocol_version).nodes);
 
 	// Make data buffer
 	verbosestream << "Server: Sending node definitions to id(" << peer_id
@@ -2375,56 +2442,73 @@ void Server::fadeSound(s32 handle, float step, float gain)
 		m_playing_sounds.erase(it);
 }
 
-void Server::sendRemoveNode(v3s16 p, std::unordered_set<u16> *far_players,
+void Server::sendNodeChanges(const std::unordered_map<v3s16, NodeChangeList> &node_changes,
 		float far_d_nodes)
 {
-	v3f p_f = intToFloat(p, BS);
-	v3s16 block_pos = getNodeBlockPos(p);
+	thread_local const int net_compression_level =
+		rangelim(g_settings->getS16("map_compression_level_net"), -1, 9);
+	const float maxd = far_d_nodes * BS;
 
-	NetworkPacket pkt(TOCLIENT_REMOVENODE, 6);
-	pkt << p;
+	std::vector<session_t> clients = m_clients.getClientIDs();
+	ClientInterface::AutoLock clientlock(m_clients);
 
-	sendNodeChangePkt(pkt, block_pos, p_f, far_d_nodes, far_players);
-}
+	// Serialized size of the current block, per serialization version
+	std::unordered_map<u8, size_t> block_sizes;
 
-void Server::sendAddNode(v3s16 p, MapNode n, std::unordered_set<u16> *far_players,
-		float far_d_nodes, bool remove_metadata)
-{
-	v3f p_f = intToFloat(p, BS);
-	v3s16 block_pos = getNodeBlockPos(p);
+	for (const auto &[block_pos, changes] : node_changes) {
+		MapBlock *block = m_env->getMap().getBlockNoCreateNoEx(block_pos);
+		v3f block_center = intToFloat(block_pos * MAP_BLOCKSIZE +
+				v3s16(MAP_BLOCKSIZE / 2), BS);
+		block_sizes.clear();
 
-	NetworkPacket pkt(TOCLIENT_ADDNODE, 6 + 2 + 1 + 1 + 1);
-	pkt << p << n.param0 << n.param1 << n.param2
-			<< (u8) (remove_metadata ? 0 : 1);
-	sendNodeChangePkt(pkt, block_pos, p_f, far_d_nodes, far_players);
-}
+		for (session_t client_id : clients) {
+			RemoteClient *client = m_clients.lockedGetClientNoEx(client_id);
+			if (!client)
+				continue;
 
-void Server::sendNodeChangePkt(NetworkPacket &pkt, v3s16 block_pos,
-		v3f p, float far_d_nodes, std::unordered_set<u16> *far_players)
-{
-	float maxd = far_d_nodes * BS;
-	std::vector<session_t> clients = m_clients.getClientIDs();
-	ClientInterface::AutoLock clientlock(m_clients);
+			RemotePlayer *player = m_env->getPlayer(client_id);
+			PlayerSAO *sao = player ? player->getPlayerSAO() : nullptr;
 
-	for (session_t client_id : clients) {
-		RemoteClient *client = m_clients.lockedGetClientNoEx(client_id);
-		if (!client)
-			continue;
+			// If player is far away, only set modified blocks not sent
+			if (!block || !client->isBlockSent(block_pos) || (sao &&
+					sao->getBasePosition().getDistanceFrom(block_center) > maxd)) {
+				client->SetBlocksNotSent(changes.getModifiedBlocks());
+				continue;
+			}
 
-		RemotePlayer *player = m_env->getPlayer(client_id);
-		PlayerSAO *sao = player ? player->getPlayerSAO() : nullptr;
+			// Send whichever is smaller: the node changes or the whole block.
+			// Small diffs are always smaller, so skip serializing the block.
+			const u8 ver = client->serialization_version;
+			const size_t diff_size = changes.getPacketSize(ver);
+			if (diff_size > NodeChangeList::getPacketSize(8, ver)) {
+				auto it = block_sizes.find(ver);
+				if (it == block_sizes.end()) {
+					std::ostringstream os(std::ios_base::binary);
+					block->serialize(os, ver, false, net_compression_level);
+					block->serializeNetworkSpecific(os);
+					it = block_sizes.emplace(ver, 6 + static_cast<size_t>(os.tellp())).first;
+				}
+				if (it->second < diff_size) {
+					client->SetBlockNotSent(block_pos);
+					continue;
+				}
+			}
 
-		// If player is far away, only set modified blocks not sent
-		if (!client->isBlockSent(block_pos) || (sao &&
-				sao->getBasePosition().getDistanceFrom(p) > maxd)) {
-			if (far_players)
-				far_players->emplace(client_id);
-			else
-				client->SetBlockNotSent(block_pos);
-			continue;
-		}
+			// Older clients only understand single node changes
+			if (client->net_proto_version < 51) {
+				changes.forEach(block_pos, [&] (v3s16 p, MapNode n, bool keep_metadata) {
+					NetworkPacket pkt(TOCLIENT_ADDNODE, 6 + 2 + 1 + 1 + 1, client_id);
+					pkt << p << n.param0 << n.param1 << n.param2
+							<< (u8) (keep_metadata ? 1 : 0);
+					Send(&pkt);
+				});
+				continue;
+			}
 
-		Send(client_id, &pkt);
+			NetworkPacket pkt(TOCLIENT_NODE_CHANGES, diff_size, client_id);
+			changes.serialize(pkt, block_pos, ver);
+			Send(&pkt);
+		}
 	}
 }
 
@@ -2480,7 +2564,7 @@ void Server::sendMetadataChanged(const std::unordered_set<v3s16> &positions, flo
 	}
 }
 
-void Server::SendBlockNoLock(session_t peer_id, MapBlock *block, u8 ver,
+u32 Server::SendBlockNoLock(session_t peer_id, MapBlock *block, u8 ver,
 		u16 net_proto_version, SerializedBlockCache *cache)
 {
 	thread_local const int net_compression_level = rangelim(g_settings->getS16("map_compression_level_net"), -1, 9);
@@ -2504,11 +2588,14 @@ void Server::SendBlockNoLock(session_t peer_id, MapBlock *block, u8 ver,
 	NetworkPacket pkt(TOCLIENT_BLOCKDATA, 2 + 2 + 2 + sptr->size(), peer_id);
 	pkt << block->getPos();
 	pkt.putRawString(*sptr);
+	const u32 size = pkt.getSize();
 	Send(&pkt);
 
 	// Store away in cache
 	if (cache && sptr == &s)
 		(*cache)[{block->getPos(), ver}] = std::move(s);
+
+	return size;
 }
 
 void Server::SendBlocks(float dtime)
@@ -2525,6 +2612,8 @@ void Server::SendBlocks(float dtime)
 		std::vector<session_t> clients = m_clients.getClientIDs();
 
 		ClientInterface::AutoLock clientlock(m_clients);
+		u32 active_clients = 0, window_sum = 0;
+		float throughput = 0.0f;
 		for (const session_t client_id : clients) {
 			RemoteClient *client = m_clients.lockedGetClientNoEx(client_id, CS_Active);
 
@@ -2535,7 +2624,16 @@ void Server::SendBlocks(float dtime)
 			const auto old_count = queue.size();
 			client->GetNextBlocks(m_env, m_emerge.get(), dtime, queue);
 			unique_clients += queue.size() > old_count ? 1 : 0;
+
+			active_clients++;
+			window_sum += client->getSendWindow().getSize();
+			throughput += client->getSendWindow().getThroughput();
 		}
+
+		m_block_send_window_gauge->set(active_clients ?
+				(double)window_sum / active_clients : 0.0);
+		m_block_send_throughput_gauge->set(throughput);
+		m_blocks_in_flight_gauge->set(total_sending);
 	}
 
 	// Sort.
@@ -2559,24 +2657,54 @@ void Server::SendBlocks(float dtime)
 		cache_ptr = &cache;
 	}
 
-	for (const PrioritySortedBlockTransfer &block_to_send : queue) {
-		if (total_sending >= max_blocks_to_send)
-			break;
-
+	auto send_block = [&] (const PrioritySortedBlockTransfer &block_to_send) {
 		MapBlock *block = map.getBlockNoCreateNoEx(block_to_send.pos);
 		if (!block)
-			continue;
+			return false;
 
 		RemoteClient *client = m_clients.lockedGetClientNoEx(block_to_send.peer_id,
 				CS_Active);
 		if (!client)
-			continue;
+			return false;
 
-		SendBlockNoLock(block_to_send.peer_id, block, client->serialization_version,
-				client->net_proto_version, cache_ptr);
+		u32 size = SendBlockNoLock(block_to_send.peer_id, block,
+				client->serialization_version, client->net_proto_version, cache_ptr);
 
-		client->SentBlock(block_to_send.pos);
+		client->SentBlock(block_to_send.pos, size);
 		total_sending++;
+		return true;
+	};
+
+	if (total_sending + queue.size() <= max_blocks_to_send || unique_clients <= 1) {
+		for (const PrioritySortedBlockTransfer &block_to_send : queue) {
+			if (total_sending >= max_blocks_to_send)
+				break;
+			send_block(block_to_send);
+		}
+		return;
+	}
+
+	/*
+		Not everything fits, so share the free slots fairly: first every client
+		gets up to an equal share of its most important blocks, then the rest
+		goes by priority.
+		Otherwise a client close to many unsent blocks could starve the others.
+	*/
+	const u32 fair_share = std::max<u32>(1,
+		(max_blocks_to_send - std::min(total_sending, max_blocks_to_send)) / unique_clients);
+	std::unordered_map<session_t, u32> selected;
+	std::vector<bool> sent(queue.size(), false);
+	for (size_t i = 0; i < queue.size() && total_sending < max_blocks_to_send; i++) {
+		u32 &count = selected[queue[i].peer_id];
+		if (count >= fair_share)
+			continue;
+		count++;
+		sent[i] = true;
+		send_block(queue[i]);
+	}
+	for (size_t i = 0; i < queue.size() && total_sending < max_blocks_to_send; i++) {
+		if (!sent[i])
+			send_block(queue[i]);
 	}
 }
 
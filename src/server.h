@@ -14,6 +14,7 @@
 #include "util/basic_macros.h"
 #include "util/metricsbackend.h"
 #include "server/clientiface.h"
+#include "server/modipcstore.h"
 #include "threading/ordered_mutex.h"
 #include "translation.h"
 #include "sound_spec.h"
@@ -39,6 +40,7 @@ class IWritableItemDefManager;
 class LuaError;
 class MetricsBackend;
 class ModChannelMgr;
+class NodeChangeList;
 class NodeDefManager;
 class Player;
 class PlayerSAO;
@@ -152,25 +154,8 @@ struct ClientInfo {
 	u16 prot_vers;
 	u8 major, minor, patch;
 	std::string vers_string, lang_code;
-};
-
-struct ModIPCStore {
-	ModIPCStore() = default;
-	~ModIPCStore();
-
-	/// RW lock for this entire structure
-	std::shared_mutex mutex;
-	/// Signalled on any changes to the map contents
-	std::condition_variable_any condvar;
-	/**
-	 * Map storing the data
-	 *
-	 * @note Do not store `nil` data in this map, instead remove the whole key.
-	 */
-	std::unordered_map<std::string, std::unique_ptr<PackedValue>> map;
-
-	/// @note Should be called without holding the lock.
-	inline void signal() { condvar.notify_all(); }
+	u16 block_send_window;
+	float block_throughput; // bytes per second
 };
 
 class Server : public con::PeerHandler, public MapEventReceiver,
@@ -188,7 +173,9 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 		Address bind_addr,
 		bool dedicated,
 		ChatInterface *iface = nullptr,
-		std::string *shutdown_errmsg = nullptr
+		std::string *shutdown_errmsg = nullptr,
+		// Only used to replay captured packets (see server/packetreplay.h)
+		std::shared_ptr<con::IConnection> replay_con = nullptr
 	);
 	~Server();
 	DISABLE_CLASS_COPY(Server);
@@ -533,9 +520,14 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	void SendBreath(session_t peer_id, u16 breath);
 	void SendAccessDenied(session_t peer_id, AccessDeniedCode reason,
 		std::string_view custom_reason, bool reconnect = false);
-	void SendItemDef(session_t peer_id, IItemDefManager *itemdef, u16 protocol_version);
-	void SendNodeDef(session_t peer_id, const NodeDefManager *nodedef,
-		u16 protocol_version);
+	// Compressed item and node definitions for the clients
+	struct SerializedDefs {
+		std::string items;
+		std::string nodes;
+	};
+	const SerializedDefs &getSerializedDefs(u16 protocol_version);
+	void SendItemDef(session_t peer_id, u16 protocol_version);
+	void SendNodeDef(session_t peer_id, u16 protocol_version);
 
 
 	virtual void SendChatMessage(session_t peer_id, const ChatMessage &message);
@@ -566,25 +558,21 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 			const std::string &message, session_t from_peer);
 
 	/*
-		Send a node removal/addition event to all clients except ignore_id.
-		Additionally, if far_players!=NULL, players further away than
-		far_d_nodes are ignored and their peer_ids are added to far_players
+		Send the node changes of this step to all clients, one packet
+		per block. For players further away than far_d_nodes or if the
+		serialized block is smaller, the block is set not sent instead.
 	*/
-	// Envlock and conlock should be locked when calling these
-	void sendRemoveNode(v3s16 p, std::unordered_set<u16> *far_players = nullptr,
-			float far_d_nodes = 100);
-	void sendAddNode(v3s16 p, MapNode n,
-			std::unordered_set<u16> *far_players = nullptr,
-			float far_d_nodes = 100, bool remove_metadata = true);
-	void sendNodeChangePkt(NetworkPacket &pkt, v3s16 block_pos,
-			v3f p, float far_d_nodes, std::unordered_set<u16> *far_players);
+	// Envlock should be locked when calling this
+	void sendNodeChanges(const std::unordered_map<v3s16, NodeChangeList> &node_changes,
+			float far_d_nodes = 30);
 
 	void sendMetadataChanged(const std::unordered_set<v3s16> &positions,
 			float far_d_nodes = 100);
 
 	// Environment and Connection must be locked when called
 	// `cache` may only be very short lived! (invalidation not handeled)
-	void SendBlockNoLock(session_t peer_id, MapBlock *block, u8 ver,
+	// Returns the size of the sent packet
+	u32 SendBlockNoLock(session_t peer_id, MapBlock *block, u8 ver,
 		u16 net_proto_version, SerializedBlockCache *cache = nullptr);
 
 	// Sends blocks to clients (locks env and con on its own)
@@ -697,6 +685,8 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 
 	// server connection
 	std::shared_ptr<con::IConnection> m_con;
+	// Packets come from a capture file instead of the network
+	const bool m_packet_replay;
 
 	// Ban checking
 	BanManager *m_banmanager = nullptr;
@@ -716,6 +706,10 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	// Craft definition manager
 	IWritableCraftDefManager *m_craftdef;
 
+	std::mutex m_serialized_defs_mutex;
+	// [protocol version] = definitions
+	std::unordered_map<u16, SerializedDefs> m_serialized_defs;
+
 	// NOTE: Cannot use forward declaration of 'Translations'. Whereas most
 	// modern compilers support incomplete types here, it's not in the C++ spec.
 	std::unordered_map<std::string, Translations> server_translations;
@@ -812,6 +806,10 @@ class Server : public con::PeerHandler, public MapEventReceiver,
 	MetricCounterPtr m_packet_recv_counter;
 	MetricCounterPtr m_packet_recv_processed_counter;
 	MetricCounterPtr m_map_edit_event_counter;
+	MetricGaugePtr m_block_send_window_gauge;
+	MetricGaugePtr m_block_send_throughput_gauge;
+	MetricGaugePtr m_blocks_in_flight_gauge;
+	MetricGaugePtr m_mods_load_time_gauge;
 
 	// Particles to send this server step
 	// [playername] = list of params, empty playername for broadcast
@@ -0,0 +1,58 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "blocksendfrontier.h"
+#include "face_position_cache.h"
+#include "mapblock.h"
+#include <algorithm>
+
+void BlockSendFrontier::setCenter(v3s16 center)
+{
+	if (center == m_center)
+		return;
+	m_center = center;
+	for (Shell &shell : m_shells)
+		shell.valid = false;
+}
+
+const std::vector<v3s16> &BlockSendFrontier::getUnsent(u16 d,
+		const std::unordered_set<v3s16> &sent)
+{
+	if (d >= m_shells.size())
+		m_shells.resize(d + 1);
+	Shell &shell = m_shells[d];
+
+	if (!shell.valid) {
+		shell.unsent = FacePositionCache::getFacePositions(d);
+		shell.valid = true;
+	}
+
+	// Drop what was sent since the last visit
+	auto &unsent = shell.unsent;
+	unsent.erase(std::remove_if(unsent.begin(), unsent.end(), [&] (v3s16 rel) {
+		const v3s16 p = m_center + rel;
+		return blockpos_over_max_limit(p) || sent.find(p) != sent.end();
+	}), unsent.end());
+
+	if (unsent.capacity() > 64 && unsent.size() < unsent.capacity() / 4)
+		unsent.shrink_to_fit();
+
+	return unsent;
+}
+
+void BlockSendFrontier::setNotSent(v3s16 p)
+{
+	p -= m_center;
+	u16 d = std::max({std::abs(p.X), std::abs(p.Y), std::abs(p.Z)});
+	if (d < m_shells.size())
+		m_shells[d].valid = false;
+}
+
+size_t BlockSendFrontier::size() const
+{
+	size_t n = 0;
+	for (const Shell &shell : m_shells)
+		n += shell.valid ? shell.unsent.size() : 0;
+	return n;
+}
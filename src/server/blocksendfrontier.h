@@ -0,0 +1,50 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include "irr_v3d.h"
+#include <unordered_set>
+#include <vector>
+
+/*
+	Blocks around a center which were not sent to a client yet, by distance.
+
+	RemoteClient::GetNextBlocks() walks the cube surfaces ("shells") around
+	the player outwards and restarts from the center quite often. Already
+	sent blocks are dropped from the shells here, so repeated walks only
+	visit the blocks which could still be sent.
+
+	A shell is built from FacePositionCache when visited first, and again
+	when one of its blocks became unsent. Moving the center forgets all shells.
+*/
+class BlockSendFrontier
+{
+public:
+	v3s16 getCenter() const { return m_center; }
+	void setCenter(v3s16 center);
+
+	/*
+		Returns the positions of shell `d` relative to the center, in the
+		order of FacePositionCache, without the blocks in `sent` and those
+		outside of the map.
+	*/
+	const std::vector<v3s16> &getUnsent(u16 d, const std::unordered_set<v3s16> &sent);
+
+	// Block `p` has to be sent again
+	void setNotSent(v3s16 p);
+
+	// Number of positions in all shells (for statistics)
+	size_t size() const;
+
+private:
+	struct Shell {
+		std::vector<v3s16> unsent;
+		bool valid = false;
+	};
+
+	v3s16 m_center;
+	std::vector<Shell> m_shells;
+};
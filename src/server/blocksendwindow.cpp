@@ -0,0 +1,65 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "blocksendwindow.h"
+#include <algorithm>
+
+// Latency allowed on top of twice the base latency before the window shrinks [s].
+// Clients acknowledge blocks once per frame, which adds some noise.
+static constexpr float LATENCY_MARGIN = 0.05f;
+
+BlockSendWindow::BlockSendWindow(u16 initial_size, u16 max_size, bool adaptive) :
+	m_max_size(std::max(initial_size, max_size)),
+	m_adaptive(adaptive),
+	m_size(std::max(initial_size, MIN_SIZE))
+{
+}
+
+void BlockSendWindow::onAck(u32 bytes, float latency)
+{
+	m_acked_blocks++;
+	m_acked_bytes += bytes;
+
+	if (m_latency == 0.0f)
+		m_latency = latency;
+	else
+		m_latency = m_latency * 0.875f + latency * 0.125f;
+
+	if (m_base_latency == 0.0f || latency < m_base_latency)
+		m_base_latency = latency;
+	if (m_next_base_latency == 0.0f || latency < m_next_base_latency)
+		m_next_base_latency = latency;
+}
+
+void BlockSendWindow::update(float dtime)
+{
+	m_timer += dtime;
+	if (m_timer < UPDATE_INTERVAL)
+		return;
+
+	const float rate = m_acked_bytes / m_timer;
+	m_throughput = m_throughput * 0.5f + rate * 0.5f;
+
+	// Without ACKs there is nothing to judge the window by
+	if (m_adaptive && m_acked_blocks > 0) {
+		if (m_latency > 2.0f * m_base_latency + LATENCY_MARGIN) {
+			// Blocks queue up somewhere on the way
+			m_size = std::max<u16>(MIN_SIZE, m_size * 3 / 4);
+		} else if (m_limited) {
+			m_size = std::min<u16>(m_max_size, m_size + std::max(1, m_size / 4));
+		}
+	}
+
+	m_base_timer += m_timer;
+	if (m_base_timer >= BASE_LATENCY_INTERVAL && m_next_base_latency > 0.0f) {
+		m_base_latency = m_next_base_latency;
+		m_next_base_latency = 0.0f;
+		m_base_timer = 0.0f;
+	}
+
+	m_timer = 0.0f;
+	m_acked_blocks = 0;
+	m_acked_bytes = 0;
+	m_limited = false;
+}
@@ -0,0 +1,64 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "irrlichttypes.h"
+
+/*
+	Number of blocks that may be in flight to one client at a time.
+
+	The window is sized from the ACKs (TOSERVER_GOTBLOCKS) of the client:
+	- If the ACK latency rises well above the lowest latency seen recently,
+	  blocks are queueing up somewhere and the window shrinks.
+	- Otherwise, if the window was the limiting factor, it grows.
+
+	When not adaptive, the window stays at its initial size.
+*/
+class BlockSendWindow
+{
+public:
+	// Smallest window (any fewer and throughput suffers for no gain)
+	static constexpr u16 MIN_SIZE = 2;
+	// Interval in which the window is adjusted [s]
+	static constexpr float UPDATE_INTERVAL = 0.5f;
+	// Interval after which the base latency is measured anew [s]
+	static constexpr float BASE_LATENCY_INTERVAL = 10.0f;
+
+	BlockSendWindow(u16 initial_size, u16 max_size, bool adaptive);
+
+	u16 getSize() const { return m_size; }
+
+	// Acknowledged bytes per second
+	float getThroughput() const { return m_throughput; }
+	// Smoothed ACK latency [s]
+	float getLatency() const { return m_latency; }
+
+	// A block of `bytes` size was acknowledged `latency` seconds after sending
+	void onAck(u32 bytes, float latency);
+	// More blocks were waiting to be sent than the window allowed
+	void onLimited() { m_limited = true; }
+
+	void update(float dtime);
+
+private:
+	const u16 m_max_size;
+	const bool m_adaptive;
+	u16 m_size;
+
+	float m_timer = 0.0f;
+	float m_base_timer = 0.0f;
+
+	// Samples of the current interval
+	u32 m_acked_blocks = 0;
+	u32 m_acked_bytes = 0;
+	bool m_limited = false;
+
+	float m_throughput = 0.0f;
+	float m_latency = 0.0f;
+	// Lowest ACK latency, approximating the latency without any queueing.
+	// Measured anew regularly, as the route to the client may change.
+	float m_base_latency = 0.0f;
+	float m_next_base_latency = 0.0f;
+};
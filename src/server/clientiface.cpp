@@ -22,7 +22,6 @@
 #include "log.h"
 #include "util/srp.h"
 #include "util/string.h"
-#include "face_position_cache.h"
 
 static std::string string_sanitize_ascii(const std::string &s, u32 max_length)
 {
@@ -66,6 +65,8 @@ RemoteClient::RemoteClient() :
 	m_block_cull_optimize_distance(g_settings->getS16("block_cull_optimize_distance")),
 	m_max_gen_distance(g_settings->getS16("max_block_generate_distance")),
 	m_occ_cull(g_settings->getBool("server_side_occlusion_culling")),
+	m_send_window(m_max_simul_sends, m_max_simul_sends * 4,
+		g_settings->getBool("adaptive_block_send_window")),
 	m_connection_time(porting::getTimeS())
 {
 }
@@ -96,6 +97,9 @@ void RemoteClient::GetNextBlocks (
 	// Increment timers
 	m_nothing_to_send_pause_timer -= dtime;
 	m_map_send_completion_timer += dtime;
+	m_sent_usage_timer += dtime;
+
+	m_send_window.update(dtime);
 
 	if (m_map_send_completion_timer > g_settings->getFloat("server_unload_unused_data_timeout") * 0.8f) {
 		infostream << "Server: Player " << m_name << ", peer_id=" << peer_id
@@ -119,9 +123,12 @@ void RemoteClient::GetNextBlocks (
 	if (!sao)
 		return;
 
+	const u16 window_size = m_send_window.getSize();
+
 	// Won't send anything if already sending
-	if (m_blocks_sending.size() >= m_max_simul_sends) {
+	if (m_blocks_sending.size() >= window_size) {
 		//infostream<<"Not sending any blocks, Queue full."<<std::endl;
+		m_send_window.onLimited();
 		return;
 	}
 
@@ -148,7 +155,7 @@ void RemoteClient::GetNextBlocks (
 	if (sao->getCameraInverted())
 		camera_dir = -camera_dir;
 
-	u16 max_simul_sends_usually = m_max_simul_sends;
+	u16 max_simul_sends_usually = window_size;
 
 	/*
 		Decrease send rate if player is building stuff.
@@ -188,9 +195,9 @@ void RemoteClient::GetNextBlocks (
 	/*
 		Get the starting value of the block finder radius.
 	*/
-	if (m_last_center != center) {
+	if (m_frontier.getCenter() != center) {
 		m_nearest_unsent_d = 0;
-		m_last_center = center;
+		m_frontier.setCenter(center);
 		m_map_send_completion_timer = 0.0f;
 	}
 	// reset the unsent distance if the view angle has changed more that 10% of the fov
@@ -240,6 +247,23 @@ void RemoteClient::GetNextBlocks (
 		camera_fov = camera_fov / (1 + dot / 300.0f);
 	}
 
+	/*
+		Sent blocks are not visited by the loop below anymore, so keep
+		the ones in sight from being unloaded here.
+	*/
+	if (m_sent_usage_timer > g_settings->getFloat("server_unload_unused_data_timeout") * 0.5f) {
+		m_sent_usage_timer = 0.0f;
+		for (v3s16 p : m_blocks_sent) {
+			const v3s16 rel = p - center;
+			if (std::max({std::abs(rel.X), std::abs(rel.Y), std::abs(rel.Z)}) > full_d_max)
+				continue;
+			if (!isBlockInSight(p, camera_pos, camera_dir, camera_fov, d_blocks_in_sight))
+				continue;
+			if (MapBlock *block = env->getMap().getBlockNoCreateNoEx(p))
+				block->resetUsageTimer();
+		}
+	}
+
 	s32 nearest_emerged_d = -1;
 	s32 nearest_sent_d = -1;
 	//bool queue_is_full = false;
@@ -250,9 +274,9 @@ void RemoteClient::GetNextBlocks (
 	for (d = d_start; d <= d_max; d++) {
 		/*
 			Get the border/face dot coordinates of a "d-radiused"
-			box
+			box, without the blocks that were sent already
 		*/
-		const auto &list = FacePositionCache::getFacePositions(d);
+		const auto &list = m_frontier.getUnsent(d, m_blocks_sent);
 
 		for (auto li = list.begin(); li != list.end(); ++li) {
 			v3s16 p = *li + center;
@@ -268,13 +292,7 @@ void RemoteClient::GetNextBlocks (
 			u16 max_simul_dynamic = max_simul_sends_usually;
 			// If block is very close, allow full maximum
 			if (d <= BLOCK_ALWAYS_SEND_MAX_D)
-				max_simul_dynamic = m_max_simul_sends;
-
-			/*
-				Do not go over max mapgen limit
-			*/
-			if (blockpos_over_max_limit(p))
-				continue;
+				max_simul_dynamic = window_size;
 
 			// If this is true, inexistent block will be made from scratch
 			bool generate = d <= d_max_gen;
@@ -308,6 +326,8 @@ void RemoteClient::GetNextBlocks (
 			// Don't select too many blocks for sending
 			if (num_blocks_selected >= max_simul_dynamic) {
 				//queue_is_full = true;
+				if (max_simul_dynamic == window_size)
+					m_send_window.onLimited();
 				goto queue_full_break;
 			}
 
@@ -315,12 +335,6 @@ void RemoteClient::GetNextBlocks (
 			if (m_blocks_sending.find(p) != m_blocks_sending.end())
 				continue;
 
-			/*
-				Don't send already sent blocks
-			*/
-			if (m_blocks_sent.find(p) != m_blocks_sent.end())
-				continue;
-
 			if (block) {
 				/*
 					If block is not generated and generating new ones is
@@ -411,7 +425,11 @@ void RemoteClient::GetNextBlocks (
 
 void RemoteClient::GotBlock(v3s16 p)
 {
-	if (m_blocks_sending.erase(p) > 0) {
+	auto it = m_blocks_sending.find(p);
+	if (it != m_blocks_sending.end()) {
+		const u64 latency_us = porting::getTimeUs() - it->second.sent_time_us;
+		m_send_window.onAck(it->second.bytes, latency_us / 1e6f);
+		m_blocks_sending.erase(it);
 		// only add to sent blocks if it actually was sending
 		// (it might have been modified since)
 		m_blocks_sent.insert(p);
@@ -420,9 +438,10 @@ void RemoteClient::GotBlock(v3s16 p)
 	}
 }
 
-void RemoteClient::SentBlock(v3s16 p)
+void RemoteClient::SentBlock(v3s16 p, u32 bytes)
 {
-	if (!m_blocks_sending.insert(p).second)
+	BlockInFlight transfer{porting::getTimeUs(), bytes};
+	if (!m_blocks_sending.emplace(p, transfer).second)
 		infostream<<"RemoteClient::SentBlock(): Sent block"
 				" already in m_blocks_sending"<<std::endl;
 }
@@ -439,9 +458,10 @@ void RemoteClient::SetBlockNotSent(v3s16 p)
 		// This resets the distance to the maximum cube size that
 		// still guarantees that this block will be scanned again right away.
 		//
-		// Using m_last_center is OK, as a change in center
+		// Using the current center is OK, as a change in center
 		// will reset m_nearest_unsent_d to 0 anyway (see getNextBlocks).
-		p -= m_last_center;
+		m_frontier.setNotSent(p);
+		p -= m_frontier.getCenter();
 		s16 this_d = std::max({std::abs(p.X), std::abs(p.Y), std::abs(p.Z)});
 		m_nearest_unsent_d = std::min(m_nearest_unsent_d, this_d);
 	}
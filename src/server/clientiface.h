@@ -11,6 +11,8 @@
 #include "threading/mutex_auto_lock.h"
 #include "clientdynamicinfo.h"
 #include "constants.h" // PEER_ID_INEXISTENT
+#include "server/blocksendfrontier.h"
+#include "server/blocksendwindow.h"
 
 #include <memory>
 #include <mutex>
@@ -248,7 +250,8 @@ class RemoteClient
 
 	void GotBlock(v3s16 p);
 
-	void SentBlock(v3s16 p);
+	// `bytes` is the size of the sent packet
+	void SentBlock(v3s16 p, u32 bytes);
 
 	void SetBlockNotSent(v3s16 p);
 	void SetBlocksNotSent(const std::vector<v3s16> &blocks);
@@ -263,6 +266,8 @@ class RemoteClient
 
 	u32 getSendingCount() const { return m_blocks_sending.size(); }
 
+	const BlockSendWindow &getSendWindow() const { return m_send_window; }
+
 	bool isBlockSent(v3s16 p) const
 	{
 		return m_blocks_sent.find(p) != m_blocks_sent.end();
@@ -279,8 +284,12 @@ class RemoteClient
 			<<"blocks_sent=" << m_blocks_sent.size()
 			<<", blocks_sending=" << m_blocks_sending.size()
 			<<", nearest_unsent_d=" << m_nearest_unsent_d
+			<<", frontier_size=" << m_frontier.size()
 			<<", map_send_completion_timer=" << (int)(m_map_send_completion_timer + 0.5f)
-			<<", excess_gotblocks=" << m_excess_gotblocks;
+			<<", excess_gotblocks=" << m_excess_gotblocks
+			<<", send_window=" << m_send_window.getSize()
+			<<", block_throughput=" << (int)(m_send_window.getThroughput() / 1024) << "KiB/s"
+			<<", block_ack_latency=" << (int)(m_send_window.getLatency() * 1000) << "ms";
 		m_excess_gotblocks = 0;
 	}
 
@@ -363,8 +372,13 @@ class RemoteClient
 	 */
 	std::unordered_set<v3s16> m_blocks_occ;
 
+	/*
+		Blocks around the last center that were not sent yet.
+		Saves GetNextBlocks from looking at the sent blocks again and again.
+	*/
+	BlockSendFrontier m_frontier;
+
 	s16 m_nearest_unsent_d = 0;
-	v3s16 m_last_center;
 	v3f m_last_camera_dir;
 
 	const u16 m_max_simul_sends;
@@ -375,6 +389,9 @@ class RemoteClient
 	const s16 m_max_gen_distance;
 	const bool m_occ_cull;
 
+	// Limits m_blocks_sending, starting at m_max_simul_sends
+	BlockSendWindow m_send_window;
+
 	/*
 		Set of media files the client has already requested
 		We won't send the same file twice to avoid bandwidth consumption attacks.
@@ -384,11 +401,15 @@ class RemoteClient
 	/*
 		Blocks that are currently on the line.
 		This is used for throttling the sending of blocks.
-		- The size of this list is limited to some value
+		- The size of this list is limited by m_send_window
 		Block is added when it is sent with BLOCKDATA.
 		Block is removed when GOTBLOCKS is received.
 	*/
-	std::unordered_set<v3s16> m_blocks_sending;
+	struct BlockInFlight {
+		u64 sent_time_us;
+		u32 bytes;
+	};
+	std::unordered_map<v3s16, BlockInFlight> m_blocks_sending;
 
 	/*
 		Count of excess GotBlocks().
@@ -404,6 +425,8 @@ class RemoteClient
 
 	// measure how long it takes the server to send the complete map
 	float m_map_send_completion_timer = 0.0f;
+	// Time since the usage timers of the sent blocks were reset
+	float m_sent_usage_timer = 0.0f;
 
 	/*
 		name of player using this client
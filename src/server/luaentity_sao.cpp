@@ -111,6 +111,8 @@ void LuaEntitySAO::addedToEnvironment(u32 dtime_s)
 			luaentity_GetProperties(m_id, this, &m_prop, m_init_name);
 		// Initialize HP from properties
 		m_hp = m_prop.hp_max;
+		m_step_batched = m_env->getScriptIface()->
+			luaentity_HasStepBatch(m_id);
 		// Activate entity, supplying serialized state
 		m_env->getScriptIface()->
 			luaentity_Activate(m_id, m_init_state, dtime_s);
@@ -212,7 +214,10 @@ void LuaEntitySAO::step(float dtime, bool send_recommended)
 				m_prop.automatic_rotate);
 	}
 
-	if(m_registered) {
+	if (m_registered && m_step_batched) {
+		// Stepped by ServerEnvironment::step after all objects
+		m_env->getScriptIface()->luaentity_QueueStep(m_init_name, m_id, moveresult_p);
+	} else if (m_registered) {
 		m_env->getScriptIface()->luaentity_Step(m_id, dtime, moveresult_p);
 	}
 
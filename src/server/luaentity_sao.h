@@ -83,6 +83,8 @@ class LuaEntitySAO : public UnitSAO
 	std::string m_init_name;
 	std::string m_init_state;
 	bool m_registered = false;
+	// Whether the definition has on_step_batch
+	bool m_step_batched = false;
 
 	MyGUID m_guid;
 
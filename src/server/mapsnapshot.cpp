@@ -0,0 +1,63 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "mapsnapshot.h"
+#include <mutex>
+
+void MapSnapshot::update(MapBlock *block)
+{
+	// Copy outside of the lock, readers only wait for the swap
+	auto copy = std::make_shared<Block>();
+	block->copyNodesTo(copy->nodes);
+
+	std::unique_lock lock(m_mutex);
+	m_blocks[block->getPos()] = std::move(copy);
+}
+
+void MapSnapshot::remove(v3s16 blockpos)
+{
+	std::shared_ptr<const Block> old;
+	std::unique_lock lock(m_mutex);
+	auto it = m_blocks.find(blockpos);
+	if (it == m_blocks.end())
+		return;
+	// Free the copy after unlocking
+	old = std::move(it->second);
+	m_blocks.erase(it);
+}
+
+void MapSnapshot::clear()
+{
+	decltype(m_blocks) old;
+	std::unique_lock lock(m_mutex);
+	old.swap(m_blocks);
+}
+
+std::shared_ptr<const MapSnapshot::Block> MapSnapshot::get(v3s16 blockpos) const
+{
+	std::shared_lock lock(m_mutex);
+	auto it = m_blocks.find(blockpos);
+	return it == m_blocks.end() ? nullptr : it->second;
+}
+
+size_t MapSnapshot::size() const
+{
+	std::shared_lock lock(m_mutex);
+	return m_blocks.size();
+}
+
+const MapSnapshot::Block *MapSnapshotView::getBlock(v3s16 blockpos)
+{
+	if (m_last_valid && m_last_pos == blockpos)
+		return m_last_block;
+
+	auto it = m_blocks.find(blockpos);
+	if (it == m_blocks.end())
+		it = m_blocks.emplace(blockpos, m_snapshot.get(blockpos)).first;
+
+	m_last_pos = blockpos;
+	m_last_block = it->second.get();
+	m_last_valid = true;
+	return m_last_block;
+}
@@ -0,0 +1,117 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include "irr_v3d.h"
+#include "constants.h"
+#include "mapblock.h" // getNodeBlockPos
+#include "mapnode.h"
+#include "util/numeric.h"
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Read-only copy of the nodes of the active blocks, so that other threads
+	(the async environment) can read the map while the server thread runs.
+
+	Blocks are copied on write: when a block changes, the server thread
+	replaces its copy with a new one. Readers keep the copy they got, so
+	they may see data that is up to one server step old.
+*/
+class MapSnapshot
+{
+public:
+	struct Block {
+		// A single node if all nodes are identical, otherwise all of them
+		std::vector<MapNode> nodes;
+
+		MapNode getNode(v3s16 relpos) const
+		{
+			if (nodes.size() == 1)
+				return nodes[0];
+			return nodes[relpos.Z * MAP_BLOCKSIZE * MAP_BLOCKSIZE +
+					relpos.Y * MAP_BLOCKSIZE + relpos.X];
+		}
+	};
+
+	// Server thread only: keep the copy of `block` up to date
+	void update(MapBlock *block);
+	void remove(v3s16 blockpos);
+	void clear();
+
+	// Any thread
+	std::shared_ptr<const Block> get(v3s16 blockpos) const;
+	size_t size() const;
+
+private:
+	mutable std::shared_mutex m_mutex;
+	std::unordered_map<v3s16, std::shared_ptr<const Block>> m_blocks;
+};
+
+/*
+	View of a MapSnapshot for one query. Each block is fetched once and then
+	kept, so that the query sees a consistent state of every block.
+	Not thread-safe, every thread needs its own view.
+*/
+class MapSnapshotView
+{
+public:
+	MapSnapshotView(const MapSnapshot &snapshot) : m_snapshot(snapshot) {}
+
+	// Like Map::getNode: CONTENT_IGNORE and invalid outside of the snapshot
+	MapNode getNode(v3s16 p, bool *is_valid_position = nullptr)
+	{
+		v3s16 blockpos = getNodeBlockPos(p);
+		const MapSnapshot::Block *block = getBlock(blockpos);
+		if (is_valid_position)
+			*is_valid_position = block != nullptr;
+		if (!block)
+			return {CONTENT_IGNORE};
+		return block->getNode(p - blockpos * MAP_BLOCKSIZE);
+	}
+
+	// Like Map::forEachNodeInArea
+	template <typename F>
+	void forEachNodeInArea(v3s16 minp, v3s16 maxp, F func)
+	{
+		v3s16 bpmin = getNodeBlockPos(minp);
+		v3s16 bpmax = getNodeBlockPos(maxp);
+		for (s16 bz = bpmin.Z; bz <= bpmax.Z; bz++)
+		for (s16 by = bpmin.Y; by <= bpmax.Y; by++)
+		for (s16 bx = bpmin.X; bx <= bpmax.X; bx++) {
+			v3s16 bp(bx, by, bz);
+			const MapSnapshot::Block *block = getBlock(bp);
+			v3s16 basep = bp * MAP_BLOCKSIZE;
+			s16 minx_block = rangelim(minp.X - basep.X, 0, MAP_BLOCKSIZE - 1);
+			s16 miny_block = rangelim(minp.Y - basep.Y, 0, MAP_BLOCKSIZE - 1);
+			s16 minz_block = rangelim(minp.Z - basep.Z, 0, MAP_BLOCKSIZE - 1);
+			s16 maxx_block = rangelim(maxp.X - basep.X, 0, MAP_BLOCKSIZE - 1);
+			s16 maxy_block = rangelim(maxp.Y - basep.Y, 0, MAP_BLOCKSIZE - 1);
+			s16 maxz_block = rangelim(maxp.Z - basep.Z, 0, MAP_BLOCKSIZE - 1);
+			for (s16 z = minz_block; z <= maxz_block; z++)
+			for (s16 y = miny_block; y <= maxy_block; y++)
+			for (s16 x = minx_block; x <= maxx_block; x++) {
+				v3s16 relpos(x, y, z);
+				MapNode n = block ? block->getNode(relpos) : MapNode(CONTENT_IGNORE);
+				if (!func(basep + relpos, n))
+					return;
+			}
+		}
+	}
+
+private:
+	const MapSnapshot::Block *getBlock(v3s16 blockpos);
+
+	const MapSnapshot &m_snapshot;
+	std::unordered_map<v3s16, std::shared_ptr<const MapSnapshot::Block>> m_blocks;
+
+	// Cache of the last block, most lookups hit the same one
+	v3s16 m_last_pos;
+	const MapSnapshot::Block *m_last_block = nullptr;
+	bool m_last_valid = false;
+};
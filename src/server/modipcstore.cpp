@@ -0,0 +1,145 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "modipcstore.h"
+#include "script/common/c_packer.h"
+#include "debug.h"
+#include "log.h"
+#include <mutex>
+
+ModIPCStore::~ModIPCStore()
+{
+	// we don't have to do this, it's pure debugging aid
+	for (auto &shard : m_shards) {
+		if (!std::unique_lock(shard.mutex, std::try_to_lock).owns_lock()) {
+			errorstream << FUNCTION_NAME << ": lock is still in use!" << std::endl;
+			assert(0);
+		}
+	}
+}
+
+ModIPCStore::Shard &ModIPCStore::getShard(const std::string &key)
+{
+	return m_shards[std::hash<std::string>{}(key) % SHARD_COUNT];
+}
+
+const ModIPCStore::Shard &ModIPCStore::getShard(const std::string &key) const
+{
+	return m_shards[std::hash<std::string>{}(key) % SHARD_COUNT];
+}
+
+ModIPCStore::Value ModIPCStore::get(const std::string &key, u64 *version) const
+{
+	const Shard &shard = getShard(key);
+	std::shared_lock lock(shard.mutex);
+	auto it = shard.entries.find(key);
+	if (it == shard.entries.end()) {
+		if (version)
+			*version = NO_VERSION;
+		return nullptr;
+	}
+	if (version)
+		*version = it->second.version;
+	return it->second.value;
+}
+
+u64 ModIPCStore::getVersion(const std::string &key) const
+{
+	const Shard &shard = getShard(key);
+	std::shared_lock lock(shard.mutex);
+	auto it = shard.entries.find(key);
+	return it == shard.entries.end() ? NO_VERSION : it->second.version;
+}
+
+u64 ModIPCStore::store(Shard &shard,
+		std::unordered_map<std::string, Entry>::iterator it, Value value)
+{
+	Entry &entry = it->second;
+	u64 version = NO_VERSION;
+	if (value) {
+		version = m_next_version.fetch_add(1, std::memory_order_relaxed);
+		entry.value = std::move(value);
+		entry.version = version;
+	} else {
+		entry.value.reset();
+		entry.version = NO_VERSION;
+	}
+
+	if (entry.waiters > 0)
+		entry.changed.notify_all();
+	else if (!entry.value)
+		shard.entries.erase(it);
+	return version;
+}
+
+u64 ModIPCStore::set(const std::string &key, Value value)
+{
+	Value old;
+	Shard &shard = getShard(key);
+	std::unique_lock lock(shard.mutex);
+	auto it = shard.entries.find(key);
+	if (it == shard.entries.end()) {
+		if (!value)
+			return NO_VERSION;
+		it = shard.entries.try_emplace(key).first;
+	}
+	// Free the old value after unlocking
+	old = it->second.value;
+	return store(shard, it, std::move(value));
+}
+
+bool ModIPCStore::setIfVersion(const std::string &key, u64 expected, Value value)
+{
+	Value old;
+	Shard &shard = getShard(key);
+	std::unique_lock lock(shard.mutex);
+	auto it = shard.entries.find(key);
+	if (it == shard.entries.end()) {
+		if (expected != NO_VERSION)
+			return false;
+		if (value)
+			store(shard, shard.entries.try_emplace(key).first, std::move(value));
+		return true;
+	}
+	if (it->second.version != expected)
+		return false;
+	old = it->second.value;
+	store(shard, it, std::move(value));
+	return true;
+}
+
+template <typename F>
+bool ModIPCStore::wait(const std::string &key, Duration timeout, F done)
+{
+	Shard &shard = getShard(key);
+	std::unique_lock lock(shard.mutex);
+	auto it = shard.entries.find(key);
+	if (it == shard.entries.end())
+		it = shard.entries.try_emplace(key).first;
+	Entry &entry = it->second;
+
+	entry.waiters++;
+	bool ret = entry.changed.wait_for(lock, timeout, [&] {
+		return done(entry);
+	});
+	entry.waiters--;
+
+	if (entry.waiters == 0 && !entry.value)
+		shard.entries.erase(key);
+	return ret;
+}
+
+bool ModIPCStore::waitForChange(const std::string &key, u64 version, Duration timeout)
+{
+	return wait(key, timeout, [&] (const Entry &entry) {
+		return entry.version != version;
+	});
+}
+
+bool ModIPCStore::waitForValue(const std::string &key, Duration timeout)
+{
+	return wait(key, timeout, [] (const Entry &entry) {
+		return entry.value != nullptr;
+	});
+}
@@ -0,0 +1,85 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+struct PackedValue;
+
+/*
+	Key-value store shared by all Lua environments (core.ipc_*).
+
+	The keys are spread over shards with one lock each, and values are
+	immutable once stored: readers only hold the lock to copy a pointer,
+	and unpack the value after releasing it.
+
+	Each change gives the key a new version, which is unique across all keys
+	of the store. Waiting is per key, so a change only wakes up the threads
+	waiting for that key.
+*/
+class ModIPCStore
+{
+public:
+	using Value = std::shared_ptr<const PackedValue>;
+	using Duration = std::chrono::milliseconds;
+
+	// Version of keys that do not exist
+	static constexpr u64 NO_VERSION = 0;
+
+	ModIPCStore() = default;
+	~ModIPCStore();
+
+	// Returns the value (nullptr if the key does not exist) and its version
+	Value get(const std::string &key, u64 *version = nullptr) const;
+	u64 getVersion(const std::string &key) const;
+
+	// A nullptr value removes the key. Returns the new version.
+	u64 set(const std::string &key, Value value);
+	// Sets the value only if the key still has the version `expected`
+	bool setIfVersion(const std::string &key, u64 expected, Value value);
+
+	// Waits until the version of the key differs from `version`.
+	// Returns false on timeout.
+	bool waitForChange(const std::string &key, u64 version, Duration timeout);
+	// Waits until the key exists. Returns false on timeout.
+	bool waitForValue(const std::string &key, Duration timeout);
+
+private:
+	static constexpr size_t SHARD_COUNT = 16;
+
+	struct Entry {
+		Value value;
+		u64 version = NO_VERSION;
+		// Threads waiting for this key, the entry is kept while there are any
+		u32 waiters = 0;
+		std::condition_variable_any changed;
+	};
+
+	struct Shard {
+		mutable std::shared_mutex mutex;
+		std::unordered_map<std::string, Entry> entries;
+	};
+
+	Shard &getShard(const std::string &key);
+	const Shard &getShard(const std::string &key) const;
+
+	// Stores the value in the entry, shard must be locked for writing
+	u64 store(Shard &shard, std::unordered_map<std::string, Entry>::iterator it,
+			Value value);
+
+	template <typename F>
+	bool wait(const std::string &key, Duration timeout, F done);
+
+	std::array<Shard, SHARD_COUNT> m_shards;
+	std::atomic<u64> m_next_version{1};
+};
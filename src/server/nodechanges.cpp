@@ -0,0 +1,59 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "nodechanges.h"
+#include "network/networkpacket.h"
+#include "util/basic_macros.h"
+#include <cassert>
+
+void NodeChangeList::add(v3s16 p, MapNode n, bool keep_metadata)
+{
+	assert(p.X >= 0 && p.X < MAP_BLOCKSIZE && p.Y >= 0 && p.Y < MAP_BLOCKSIZE &&
+		p.Z >= 0 && p.Z < MAP_BLOCKSIZE);
+	const u16 index = p.Z * MAP_BLOCKSIZE * MAP_BLOCKSIZE + p.Y * MAP_BLOCKSIZE + p.X;
+
+	if (m_present[index]) {
+		for (auto &change : m_changes) {
+			if (change.index != index)
+				continue;
+			change.n = n;
+			// Metadata removed by any of the changes stays removed
+			change.keep_metadata &= keep_metadata;
+			return;
+		}
+	}
+
+	m_present[index] = true;
+	m_changes.push_back({index, n, keep_metadata});
+}
+
+void NodeChangeList::addModifiedBlocks(const std::vector<v3s16> &blocks)
+{
+	for (v3s16 bp : blocks) {
+		if (!CONTAINS(m_modified_blocks, bp))
+			m_modified_blocks.push_back(bp);
+	}
+}
+
+size_t NodeChangeList::getPacketSize(size_t count, u8 ser_ver)
+{
+	return 6 + 2 + count * (2 + MapNode::serializedLength(ser_ver) + 1);
+}
+
+void NodeChangeList::serialize(NetworkPacket &pkt, v3s16 blockpos, u8 ser_ver) const
+{
+	assert(m_changes.size() <= U16_MAX);
+
+	pkt << blockpos << static_cast<u16>(m_changes.size());
+
+	const u32 node_len = MapNode::serializedLength(ser_ver);
+	u8 buf[8];
+	assert(node_len <= sizeof(buf));
+	for (const auto &change : m_changes) {
+		pkt << change.index;
+		change.n.serialize(buf, ser_ver);
+		pkt.putRawString(reinterpret_cast<char *>(buf), node_len);
+		pkt << static_cast<u8>(change.keep_metadata ? 1 : 0);
+	}
+}
@@ -0,0 +1,70 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include "irr_v3d.h"
+#include "mapnode.h"
+#include "constants.h"
+#include <bitset>
+#include <vector>
+
+class NetworkPacket;
+
+/*
+	Collects the single-node changes of one mapblock during a server step,
+	so they can be sent to clients as one TOCLIENT_NODE_CHANGES packet
+	instead of one TOCLIENT_ADDNODE/TOCLIENT_REMOVENODE packet per node.
+*/
+class NodeChangeList
+{
+public:
+	NodeChangeList() = default;
+
+	// p is relative to the mapblock. A later change of the same node
+	// replaces the earlier one.
+	void add(v3s16 p, MapNode n, bool keep_metadata);
+
+	// Blocks whose contents (incl. lighting) were touched by the changes,
+	// to be resent to clients which do not receive the diff.
+	void addModifiedBlocks(const std::vector<v3s16> &blocks);
+	const std::vector<v3s16> &getModifiedBlocks() const { return m_modified_blocks; }
+
+	size_t size() const { return m_changes.size(); }
+	bool empty() const { return m_changes.empty(); }
+
+	// Size of the packet payload written by serialize()
+	static size_t getPacketSize(size_t count, u8 ser_ver);
+	size_t getPacketSize(u8 ser_ver) const { return getPacketSize(size(), ser_ver); }
+
+	// Writes the TOCLIENT_NODE_CHANGES payload (see networkprotocol.h)
+	void serialize(NetworkPacket &pkt, v3s16 blockpos, u8 ser_ver) const;
+
+	// Calls f(v3s16 p, MapNode n, bool keep_metadata) for each change,
+	// with p being the absolute node position
+	template <typename F>
+	void forEach(v3s16 blockpos, F &&f) const
+	{
+		const v3s16 p_base = blockpos * MAP_BLOCKSIZE;
+		for (const auto &change : m_changes) {
+			v3s16 p(change.index % MAP_BLOCKSIZE,
+					(change.index / MAP_BLOCKSIZE) % MAP_BLOCKSIZE,
+					change.index / (MAP_BLOCKSIZE * MAP_BLOCKSIZE));
+			f(p_base + p, change.n, change.keep_metadata);
+		}
+	}
+
+private:
+	struct Change {
+		u16 index;
+		MapNode n;
+		bool keep_metadata;
+	};
+
+	std::vector<Change> m_changes;
+	// Marks which node indices have an entry in m_changes
+	std::bitset<MAP_BLOCKSIZE * MAP_BLOCKSIZE * MAP_BLOCKSIZE> m_present;
+	std::vector<v3s16> m_modified_blocks;
+};
@@ -0,0 +1,293 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "packetreplay.h"
+#include "exceptions.h"
+#include "gameparams.h"
+#include "log.h"
+#include "porting.h"
+#include "server.h"
+#include "settings.h"
+#include "threading/mutex_auto_lock.h"
+#include "network/networkexceptions.h"
+#include "network/networkpacket.h"
+#include "network/serveropcodes.h"
+#include "util/serialize.h"
+#include <iomanip>
+
+namespace {
+
+class ReplayPeer : public con::IPeer
+{
+public:
+	ReplayPeer(session_t id, const Address &address) :
+		con::IPeer(id), m_address(address)
+	{}
+
+	const Address &getAddress() const override { return m_address; }
+
+private:
+	Address m_address;
+};
+
+}
+
+ReplayConnection::ReplayConnection(std::unique_ptr<con::PacketCaptureReader> reader,
+		bool realtime) :
+	m_reader(std::move(reader)),
+	m_realtime(realtime)
+{
+}
+
+void ReplayConnection::DisconnectPeer(session_t peer_id)
+{
+	// The peer is removed on the next receive, like for a real connection
+	MutexAutoLock lock(m_mutex);
+	m_pending_disconnects.push_back(peer_id);
+}
+
+Address ReplayConnection::GetPeerAddress(session_t peer_id)
+{
+	MutexAutoLock lock(m_mutex);
+	auto it = m_peers.find(peer_id);
+	if (it == m_peers.end())
+		throw con::PeerNotFoundException("No address for peer found!");
+	return it->second;
+}
+
+void ReplayConnection::Send(session_t peer_id, u8 channelnum,
+		NetworkPacket *pkt, bool reliable)
+{
+	const u16 command = pkt->getCommand();
+	if (command >= TOCLIENT_NUM_MSG_TYPES)
+		return;
+
+	MutexAutoLock lock(m_mutex);
+	OpcodeStats &stats = m_send_stats[command];
+	stats.count++;
+	stats.bytes += 2 + pkt->getSize();
+}
+
+void ReplayConnection::accountElapsed(u64 now)
+{
+	if (m_last_return_us == 0)
+		return;
+
+	const u64 elapsed = now - m_last_return_us;
+	if (m_last_was_packet) {
+		// The server processed the packet we returned last
+		m_recv_stats[m_last_command].time_us += elapsed;
+	} else {
+		// No data was returned, so the server went on with its step
+		m_steps++;
+		m_step_time_us += elapsed;
+		m_step_time_max_us = std::max(m_step_time_max_us, elapsed);
+	}
+}
+
+void ReplayConnection::removePeer(session_t peer_id, bool timeout)
+{
+	Address address;
+	{
+		MutexAutoLock lock(m_mutex);
+		auto it = m_peers.find(peer_id);
+		if (it == m_peers.end())
+			return;
+		address = it->second;
+		m_peers.erase(it);
+	}
+
+	ReplayPeer peer(peer_id, address);
+	if (m_handler)
+		m_handler->deletingPeer(&peer, timeout);
+}
+
+bool ReplayConnection::ReceiveTimeoutMs(NetworkPacket *pkt, u32 timeout_ms)
+{
+	u64 now = porting::getTimeUs();
+	accountElapsed(now);
+	if (!m_started) {
+		m_started = true;
+		m_replay_start_us = now;
+	}
+
+	auto return_data = [&] (bool is_packet) {
+		m_last_was_packet = is_packet;
+		m_last_return_us = porting::getTimeUs();
+		return is_packet;
+	};
+
+	for (;;) {
+		std::vector<session_t> disconnects;
+		{
+			MutexAutoLock lock(m_mutex);
+			disconnects.swap(m_pending_disconnects);
+		}
+		for (session_t peer_id : disconnects)
+			removePeer(peer_id, false);
+
+		if (!m_next_valid) {
+			if (!m_reader->read(m_next)) {
+				// End of capture, keep the server idling
+				m_finished = true;
+				sleep_ms(timeout_ms);
+				return return_data(false);
+			}
+			m_next_valid = true;
+			if (m_time_offset_us == 0)
+				m_time_offset_us = now - std::min(now, m_next.time_us);
+		}
+
+		if (m_realtime) {
+			// Wait until the event is due, but not longer than allowed
+			const u64 due = m_time_offset_us + m_next.time_us;
+			now = porting::getTimeUs();
+			if (due > now) {
+				const u64 wait_us = std::min<u64>(due - now, timeout_ms * 1000);
+				if (wait_us > 0)
+					sleep_us(wait_us);
+				if (due > now + wait_us)
+					return return_data(false);
+			}
+		} else if (timeout_ms == 0) {
+			// The server wants to do its step
+			return return_data(false);
+		}
+
+		m_next_valid = false;
+		switch (m_next.type) {
+		case con::PacketCaptureEvent::DATA: {
+			const std::string &data = m_next.data;
+			{
+				MutexAutoLock lock(m_mutex);
+				if (data.size() < 2 || m_peers.count(m_next.peer_id) == 0)
+					continue;
+			}
+			pkt->putRawPacket(reinterpret_cast<const u8 *>(data.data()),
+					data.size(), m_next.peer_id);
+			m_last_command = pkt->getCommand();
+			if (m_last_command >= TOSERVER_NUM_MSG_TYPES) {
+				// The server rejects it, no need to measure
+				m_last_command = 0;
+			}
+			OpcodeStats &stats = m_recv_stats[m_last_command];
+			stats.count++;
+			stats.bytes += data.size();
+			return return_data(true);
+		}
+		case con::PacketCaptureEvent::PEER_ADDED: {
+			const std::string &data = m_next.data;
+			size_t sep = data.find('\0');
+			if (sep == std::string::npos || data.size() < sep + 3)
+				throw SerializationError("ReplayConnection: invalid peer address");
+
+			Address address;
+			try {
+				address.Resolve(data.substr(0, sep).c_str());
+			} catch (ResolveError &e) {
+				warningstream << "ReplayConnection: " << e.what() << std::endl;
+			}
+			address.setPort(readU16(reinterpret_cast<const u8 *>(&data[sep + 1])));
+
+			{
+				MutexAutoLock lock(m_mutex);
+				m_peers[m_next.peer_id] = address;
+			}
+			ReplayPeer peer(m_next.peer_id, address);
+			if (m_handler)
+				m_handler->peerAdded(&peer);
+			continue;
+		}
+		case con::PacketCaptureEvent::PEER_REMOVED:
+			removePeer(m_next.peer_id, !m_next.data.empty() && m_next.data[0]);
+			continue;
+		}
+	}
+}
+
+void ReplayConnection::printStats(std::ostream &os)
+{
+	const u64 duration_us = porting::getTimeUs() - m_replay_start_us;
+
+	u64 total_count = 0;
+	for (const auto &stats : m_recv_stats)
+		total_count += stats.count;
+
+	os << "Replayed " << total_count << " packets in "
+		<< std::fixed << std::setprecision(2) << duration_us / 1e6f << "s"
+		<< (m_realtime ? " (realtime)" : "") << std::endl;
+	os << "Server steps: " << m_steps << ", average "
+		<< (m_steps ? m_step_time_us / 1e3f / m_steps : 0.0f) << "ms, max "
+		<< m_step_time_max_us / 1e3f << "ms" << std::endl;
+
+	os << std::endl << "Received packets:" << std::endl;
+	os << std::left << std::setw(36) << "command" << std::right
+		<< std::setw(10) << "count" << std::setw(12) << "bytes"
+		<< std::setw(12) << "total ms" << std::setw(12) << "avg us" << std::endl;
+	for (u16 i = 0; i < TOSERVER_NUM_MSG_TYPES; i++) {
+		const OpcodeStats &stats = m_recv_stats[i];
+		if (stats.count == 0)
+			continue;
+		const char *name = toServerCommandTable[i].name;
+		os << std::left << std::setw(36) << (name ? name : "(invalid)") << std::right
+			<< std::setw(10) << stats.count << std::setw(12) << stats.bytes
+			<< std::setw(12) << stats.time_us / 1e3f
+			<< std::setw(12) << (float)stats.time_us / stats.count << std::endl;
+	}
+
+	MutexAutoLock lock(m_mutex);
+	os << std::endl << "Sent packets:" << std::endl;
+	os << std::left << std::setw(36) << "command" << std::right
+		<< std::setw(10) << "count" << std::setw(12) << "bytes" << std::endl;
+	for (u16 i = 0; i < TOCLIENT_NUM_MSG_TYPES; i++) {
+		const OpcodeStats &stats = m_send_stats[i];
+		if (stats.count == 0)
+			continue;
+		const char *name = clientCommandFactoryTable[i].name;
+		os << std::left << std::setw(36) << (name ? name : "(invalid)") << std::right
+			<< std::setw(10) << stats.count << std::setw(12) << stats.bytes << std::endl;
+	}
+}
+
+bool replay_packet_capture(const GameParams &game_params, const Settings &cmd_args)
+{
+	const std::string path = cmd_args.get("replay-packets");
+	auto reader = std::make_unique<con::PacketCaptureReader>(path);
+	if (!reader->isOpen()) {
+		errorstream << "Cannot read packet capture " << path << std::endl;
+		return false;
+	}
+	if (reader->getProtocolVersion() != LATEST_PROTOCOL_VERSION) {
+		warningstream << "Packet capture was recorded with protocol version "
+			<< reader->getProtocolVersion() << ", this server uses "
+			<< LATEST_PROTOCOL_VERSION << std::endl;
+	}
+
+	warningstream << "Replaying packets modifies the world, "
+		"make sure to use a copy of it" << std::endl;
+
+	auto con = std::make_shared<ReplayConnection>(std::move(reader),
+			cmd_args.getFlag("replay-realtime"));
+
+	try {
+		Server server(game_params.world_path, game_params.game_spec, false,
+				Address(), true, nullptr, nullptr, con);
+		con->setPeerHandler(&server);
+		server.start();
+
+		volatile auto &kill = *porting::signal_handler_killstatus();
+		while (!kill && !con->isFinished()) {
+			// throws if the server thread failed
+			server.step();
+			sleep_ms(100);
+		}
+		server.stop();
+	} catch (ServerError &e) {
+		errorstream << "ServerError: " << e.what() << std::endl;
+		return false;
+	}
+
+	con->printStats(rawstream);
+	return true;
+}
@@ -0,0 +1,100 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "network/address.h"
+#include "network/connection.h"
+#include "network/packetcapture.h"
+#include "network/peerhandler.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+class Settings;
+struct GameParams;
+
+/*
+	Stand-in for the network connection of a server which feeds it the
+	contents of a packet capture (see network/packetcapture.h).
+	Everything the server sends is discarded, but accounted for.
+
+	In realtime mode packets are delivered with their original timing,
+	otherwise as fast as the server can process them.
+*/
+class ReplayConnection final : public con::IConnection
+{
+public:
+	ReplayConnection(std::unique_ptr<con::PacketCaptureReader> reader, bool realtime);
+
+	void setPeerHandler(con::PeerHandler *handler) { m_handler = handler; }
+
+	// True once all captured events were handed to the server
+	bool isFinished() const { return m_finished; }
+
+	void printStats(std::ostream &os);
+
+	void Serve(Address bind_addr) override {}
+	void Connect(Address address) override {}
+	bool Connected() override { return true; }
+	void Disconnect() override {}
+	void DisconnectPeer(session_t peer_id) override;
+
+	bool ReceiveTimeoutMs(NetworkPacket *pkt, u32 timeout_ms) override;
+	void Send(session_t peer_id, u8 channelnum, NetworkPacket *pkt, bool reliable) override;
+
+	session_t GetPeerID() const override { return 1; } // PEER_ID_SERVER
+	Address GetPeerAddress(session_t peer_id) override;
+	float getPeerStat(session_t peer_id, con::rtt_stat_type type) override { return 0.0f; }
+	float getLocalStat(con::rate_stat_type type) override { return 0.0f; }
+
+	bool startPacketCapture(const std::string &path) override { return false; }
+
+private:
+	struct OpcodeStats {
+		u64 count = 0;
+		u64 bytes = 0;
+		u64 time_us = 0;
+	};
+
+	// Accounts the time since the last return to the packet or step it was spent on
+	void accountElapsed(u64 now);
+	void removePeer(session_t peer_id, bool timeout);
+
+	std::unique_ptr<con::PacketCaptureReader> m_reader;
+	const bool m_realtime;
+	con::PeerHandler *m_handler = nullptr;
+	std::atomic<bool> m_finished = false;
+
+	// Next captured event, not yet due
+	con::PacketCaptureEvent m_next;
+	bool m_next_valid = false;
+	// Offset between capture time and wall time (realtime mode)
+	u64 m_time_offset_us = 0;
+	bool m_started = false;
+
+	// What the server did since ReceiveTimeoutMs() returned last
+	u64 m_last_return_us = 0;
+	u16 m_last_command = 0;
+	bool m_last_was_packet = false;
+
+	std::array<OpcodeStats, TOSERVER_NUM_MSG_TYPES> m_recv_stats;
+	u64 m_steps = 0;
+	u64 m_step_time_us = 0;
+	u64 m_step_time_max_us = 0;
+	u64 m_replay_start_us = 0;
+
+	// Accessed from multiple server threads
+	std::mutex m_mutex;
+	std::unordered_map<session_t, Address> m_peers;
+	std::vector<session_t> m_pending_disconnects;
+	std::array<OpcodeStats, TOCLIENT_NUM_MSG_TYPES> m_send_stats;
+};
+
+// Runs the server of `game_params` with the capture given in `cmd_args`
+bool replay_packet_capture(const GameParams &game_params, const Settings &cmd_args);
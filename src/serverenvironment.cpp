@@ -272,6 +272,11 @@ void ServerEnvironment::init()
 		m_map->addEventReceiver(&m_on_mapblocks_changed_receiver);
 		m_on_mapblocks_changed_receiver.receiving = true;
 	}
+
+	if (m_map && g_settings->getBool("async_map_access")) {
+		m_map->addEventReceiver(&m_map_snapshot_receiver);
+		m_map_snapshot_receiver.receiving = true;
+	}
 }
 
 void ServerEnvironment::deactivateBlocksAndObjects()
@@ -283,6 +288,7 @@ void ServerEnvironment::deactivateBlocksAndObjects()
 	// Clear active block list.
 	// This makes the next code delete all active objects.
 	m_active_blocks.clear();
+	m_map_snapshot.clear();
 
 	deactivateFarObjects(true);
 }
@@ -551,6 +557,9 @@ void ServerEnvironment::activateBlock(MapBlock *block)
 	// of opportunity for it to break from seconds to nanoseconds)
 	block->resetUsageTimer();
 
+	if (m_map_snapshot_receiver.receiving)
+		m_map_snapshot.update(block);
+
 	// Get time difference
 	u32 dtime_s = 0;
 	u32 stamp = block->getTimestamp();
@@ -930,6 +939,8 @@ void ServerEnvironment::step(float dtime)
 		deactivateFarObjects(false);
 
 		for (const v3s16 &p: blocks_removed) {
+			m_map_snapshot.remove(p);
+
 			MapBlock *block = m_map->getBlockNoCreateNoEx(p);
 			if (!block)
 				continue;
@@ -1101,6 +1112,9 @@ void ServerEnvironment::step(float dtime)
 		};
 		m_ao_manager.step(dtime, cb_state);
 
+		// Entities with on_step_batch were only queued by their step
+		m_script->luaentity_StepBatches(dtime);
+
 		m_active_object_gauge->set(object_count);
 	}
 
@@ -1151,6 +1165,19 @@ void ServerEnvironment::step(float dtime)
 		m_script->on_mapblocks_changed(modified_blocks);
 	}
 
+	// Update the copy of the modified active blocks
+	if (m_map_snapshot_receiver.receiving) {
+		ScopeProfiler sp(g_profiler, "ServerEnv: update map snapshot", SPT_AVG);
+		for (const v3s16 &p : m_map_snapshot_receiver.modified_blocks) {
+			if (!m_active_blocks.contains(p))
+				continue;
+			if (MapBlock *block = m_map->getBlockNoCreateNoEx(p))
+				m_map_snapshot.update(block);
+		}
+		m_map_snapshot_receiver.modified_blocks.clear();
+		g_profiler->avg("ServerEnv: map snapshot blocks", m_map_snapshot.size());
+	}
+
 	const auto end_time = porting::getTimeUs();
 	m_step_time_counter->increment(end_time - start_time);
 }
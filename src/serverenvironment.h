@@ -15,6 +15,7 @@
 #include "map.h" // MapEventReceiver
 #include "server/activeobjectmgr.h"
 #include "server/blockmodifier.h"
+#include "server/mapsnapshot.h"
 #include "util/numeric.h"
 #include "util/metricsbackend.h"
 
@@ -88,7 +89,9 @@ class ActiveBlockList
 };
 
 /*
-	ServerEnvironment::m_on_mapblocks_changed_receiver
+	Collects the positions of modified mapblocks
+	(ServerEnvironment::m_on_mapblocks_changed_receiver and
+	ServerEnvironment::m_map_snapshot_receiver)
 */
 struct OnMapblocksChangedReceiver : public MapEventReceiver {
 	std::unordered_set<v3s16> modified_blocks;
@@ -266,6 +269,13 @@ class ServerEnvironment final : public Environment
 
 	std::set<v3s16>* getForceloadedBlocks() { return &m_active_blocks.m_forceloaded_list; }
 
+	// Copy of the active blocks for the async environment,
+	// nullptr if disabled. Thread-safe.
+	const MapSnapshot *getMapSnapshot() const
+	{
+		return m_map_snapshot_receiver.receiving ? &m_map_snapshot : nullptr;
+	}
+
 	// Sorted by how ready a mapblock is
 	enum BlockStatus {
 		BS_UNKNOWN,
@@ -371,6 +381,9 @@ class ServerEnvironment final : public Environment
 	server::ActiveObjectMgr m_ao_manager;
 	// on_mapblocks_changed map event receiver
 	OnMapblocksChangedReceiver m_on_mapblocks_changed_receiver;
+	// Copy of the active blocks, updated from the blocks the receiver collects
+	MapSnapshot m_map_snapshot;
+	OnMapblocksChangedReceiver m_map_snapshot_receiver;
 	GUIDGenerator m_guid_generator;
 	// Outgoing network message buffer for active objects
 	std::queue<ActiveObjectMessage> m_active_object_messages;
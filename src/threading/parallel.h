@@ -0,0 +1,58 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "threading/thread.h"
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/**
+ * Calls `func(begin, end)` for consecutive ranges covering [0, count),
+ * spread over the processors. Blocks until all ranges are done.
+ *
+ * Ranges are never smaller than `min_chunk` (except the last one), so that
+ * small inputs do not pay for starting threads. The first exception thrown
+ * by `func` is rethrown after all threads have finished.
+ */
+template <typename F>
+void parallel_for(size_t count, size_t min_chunk, F func)
+{
+	size_t threads = std::min<size_t>(Thread::getNumberOfProcessors(),
+			count / std::max<size_t>(min_chunk, 1));
+	if (threads <= 1) {
+		if (count > 0)
+			func(0, count);
+		return;
+	}
+
+	const size_t chunk = (count + threads - 1) / threads;
+	std::vector<std::exception_ptr> errors(threads);
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	for (size_t t = 1; t < threads; t++) {
+		workers.emplace_back([&, t] {
+			try {
+				func(t * chunk, std::min(count, (t + 1) * chunk));
+			} catch (...) {
+				errors[t] = std::current_exception();
+			}
+		});
+	}
+	// The calling thread does the first range
+	try {
+		func(0, chunk);
+	} catch (...) {
+		errors[0] = std::current_exception();
+	}
+	for (auto &worker : workers)
+		worker.join();
+
+	for (auto &error : errors) {
+		if (error)
+			std::rethrow_exception(error);
+	}
+}
@@ -0,0 +1,198 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "threading/taskpool.h"
+#include "threading/thread.h"
+#include <cassert>
+
+namespace {
+	// Pool and queue of the current worker thread
+	thread_local TaskPool *t_pool = nullptr;
+	thread_local size_t t_queue = 0;
+}
+
+class TaskPool::Worker : public Thread
+{
+public:
+	Worker(TaskPool *pool, size_t index, const std::string &name) :
+		Thread(name), m_pool(pool), m_index(index)
+	{}
+
+protected:
+	void *run() override
+	{
+		m_pool->workerLoop(m_index);
+		return nullptr;
+	}
+
+private:
+	TaskPool *m_pool;
+	size_t m_index;
+};
+
+TaskPool::TaskPool(unsigned int num_threads, const std::string &name)
+{
+	for (unsigned int i = 0; i < num_threads; i++)
+		m_queues.push_back(std::make_unique<Queue>());
+	for (unsigned int i = 0; i < num_threads; i++) {
+		m_workers.push_back(std::make_unique<Worker>(this, i,
+				name + "-" + std::to_string(i)));
+		m_workers.back()->start();
+	}
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard lock(m_idle_mutex);
+		m_stop = true;
+	}
+	m_idle_cv.notify_all();
+	for (auto &worker : m_workers)
+		worker->wait();
+	// Graphs must have finished running before
+	assert(m_queued == 0);
+}
+
+void TaskPool::push(Item item)
+{
+	size_t index = t_pool == this ? t_queue :
+			m_next_queue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+	// Count first, so that the count never drops below the number of tasks
+	m_queued++;
+	{
+		Queue &queue = *m_queues[index];
+		std::lock_guard lock(queue.mutex);
+		queue.items.push_back(item);
+	}
+
+	// Lock so that a worker can't miss the task between checking and waiting
+	{
+		std::lock_guard lock(m_idle_mutex);
+	}
+	m_idle_cv.notify_one();
+}
+
+bool TaskPool::runOne()
+{
+	if (m_queued == 0)
+		return false;
+
+	const bool is_worker = t_pool == this;
+	const size_t first = is_worker ? t_queue :
+			m_next_queue.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < m_queues.size(); i++) {
+		Queue &queue = *m_queues[(first + i) % m_queues.size()];
+		Item item;
+		{
+			std::lock_guard lock(queue.mutex);
+			if (queue.items.empty())
+				continue;
+			// Own tasks newest first, as their data is likely still cached
+			if (is_worker && i == 0) {
+				item = queue.items.back();
+				queue.items.pop_back();
+			} else {
+				item = queue.items.front();
+				queue.items.pop_front();
+			}
+		}
+		m_queued--;
+		item.graph->execute(item.task);
+		return true;
+	}
+	return false;
+}
+
+void TaskPool::workerLoop(size_t index)
+{
+	t_pool = this;
+	t_queue = index;
+
+	while (true) {
+		if (runOne())
+			continue;
+
+		std::unique_lock lock(m_idle_mutex);
+		m_idle_cv.wait(lock, [this] { return m_stop || m_queued > 0; });
+		if (m_stop)
+			break;
+	}
+}
+
+TaskGraph::TaskId TaskGraph::add(std::function<void()> func,
+		std::initializer_list<TaskId> deps)
+{
+	const TaskId id = m_tasks.size();
+	Task &task = m_tasks.emplace_back();
+	task.func = std::move(func);
+	for (TaskId dep : deps) {
+		assert(dep < id);
+		m_tasks[dep].successors.push_back(id);
+		task.num_deps++;
+	}
+	return id;
+}
+
+void TaskGraph::run()
+{
+	if (!m_pool || m_pool->getNumThreads() == 0) {
+		// Dependencies always come first
+		for (Task &task : m_tasks)
+			task.func();
+		return;
+	}
+
+	m_remaining = m_tasks.size();
+	for (Task &task : m_tasks)
+		task.pending = task.num_deps;
+	for (TaskId id = 0; id < m_tasks.size(); id++) {
+		if (m_tasks[id].num_deps == 0)
+			m_pool->push({this, id});
+	}
+
+	// Help until all tasks are done
+	std::unique_lock lock(m_mutex);
+	while (m_remaining > 0) {
+		const size_t completed = m_completed;
+		lock.unlock();
+		const bool ran = m_pool->runOne();
+		lock.lock();
+		if (!ran) {
+			m_done_cv.wait(lock, [&] {
+				return m_completed != completed || m_remaining == 0;
+			});
+		}
+	}
+
+	if (m_error)
+		std::rethrow_exception(m_error);
+}
+
+void TaskGraph::execute(TaskId id)
+{
+	Task &task = m_tasks[id];
+	if (!m_failed) {
+		try {
+			task.func();
+		} catch (...) {
+			std::lock_guard lock(m_mutex);
+			if (!m_error)
+				m_error = std::current_exception();
+			m_failed = true;
+		}
+	}
+
+	for (TaskId successor : task.successors) {
+		if (--m_tasks[successor].pending == 0)
+			m_pool->push({this, successor});
+	}
+
+	// Notify with the lock held: run() may return and destroy the graph as
+	// soon as the lock is released
+	std::lock_guard lock(m_mutex);
+	m_completed++;
+	m_remaining--;
+	m_done_cv.notify_all();
+}
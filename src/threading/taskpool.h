@@ -0,0 +1,141 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "irrlichttypes.h"
+#include "util/basic_macros.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class TaskGraph;
+
+/*
+	Worker threads that run the tasks of TaskGraphs.
+
+	Every worker has its own queue. It runs the newest task of its own queue
+	first and takes the oldest task of another queue when its own is empty.
+	Threads that wait for a graph run queued tasks too, so that a pool can be
+	shared by several threads and graphs can be nested.
+*/
+class TaskPool
+{
+public:
+	TaskPool(unsigned int num_threads, const std::string &name = "TaskPool");
+	~TaskPool();
+	DISABLE_CLASS_COPY(TaskPool)
+
+	unsigned int getNumThreads() const { return m_workers.size(); }
+
+private:
+	friend class TaskGraph;
+
+	struct Item {
+		TaskGraph *graph;
+		size_t task;
+	};
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Item> items;
+	};
+
+	class Worker;
+
+	void push(Item item);
+	// Runs one queued task. Returns false if all queues are empty.
+	bool runOne();
+	void workerLoop(size_t index);
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::atomic<size_t> m_queued{0};
+	std::atomic<size_t> m_next_queue{0};
+
+	std::mutex m_idle_mutex;
+	std::condition_variable m_idle_cv;
+	bool m_stop = false;
+};
+
+/*
+	Tasks with dependencies between them. A task is started once all tasks
+	it depends on are done.
+
+	Without a pool, run() runs the tasks one after another in the order they
+	were added. Not thread-safe, the tasks must be added by one thread.
+*/
+class TaskGraph
+{
+public:
+	using TaskId = size_t;
+
+	TaskGraph(TaskPool *pool) : m_pool(pool) {}
+	DISABLE_CLASS_COPY(TaskGraph)
+
+	// `deps` must be tasks that were added before
+	TaskId add(std::function<void()> func, std::initializer_list<TaskId> deps = {});
+
+	/*
+		Runs all tasks and blocks until they are done. The first exception
+		thrown by a task is rethrown, the tasks that were not started by
+		then are skipped.
+	*/
+	void run();
+
+private:
+	friend class TaskPool;
+
+	struct Task {
+		std::function<void()> func;
+		std::vector<TaskId> successors;
+		u32 num_deps = 0;
+		std::atomic<u32> pending{0};
+	};
+
+	void execute(TaskId id);
+
+	TaskPool *m_pool;
+	// Deque, as the tasks must not move
+	std::deque<Task> m_tasks;
+
+	std::atomic<bool> m_failed{false};
+	std::mutex m_mutex;
+	std::condition_variable m_done_cv;
+	size_t m_remaining = 0;
+	size_t m_completed = 0;
+	std::exception_ptr m_error;
+};
+
+/**
+ * Like parallel_for, but runs the ranges on the threads of `pool`, and on
+ * the calling thread. Runs serially if `pool` is null.
+ */
+template <typename F>
+void parallel_for(TaskPool *pool, size_t count, size_t min_chunk, F func)
+{
+	// A few ranges per thread, so that threads that finish early can help
+	size_t chunk = pool ? count / ((pool->getNumThreads() + 1) * 2) : count;
+	chunk = std::max<size_t>(chunk, std::max<size_t>(min_chunk, 1));
+	if (chunk >= count) {
+		if (count > 0)
+			func(0, count);
+		return;
+	}
+
+	TaskGraph graph(pool);
+	for (size_t begin = 0; begin < count; begin += chunk) {
+		size_t end = std::min(count, begin + chunk);
+		graph.add([&func, begin, end] { func(begin, end); });
+	}
+	graph.run();
+}
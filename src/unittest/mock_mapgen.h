@@ -0,0 +1,203 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#pragma once
+
+#include "mock_server.h"
+#include "dummymap.h"
+#include "emerge.h"
+#include "nodedef.h"
+#include "mapgen/mapgen.h"
+#include "mapgen/mg_biome.h"
+#include "mapgen/mg_decoration.h"
+#include "mapgen/mg_schematic.h"
+#include "util/numeric.h"
+#include <cstring>
+#include <memory>
+
+/*
+	Runs mapgens without emerge threads or a map database, for tests and
+	benchmarks. Register biomes, ores or decorations through emerge()
+	before calling init().
+*/
+class MockMapgen
+{
+public:
+	MockMapgen()
+	{
+		NodeDefManager *ndef = m_server.getWritableNodeDefManager();
+
+		ContentFeatures f;
+		f.is_ground_content = true;
+		for (const char *name : {"mapgen_stone", "mapgen_cobble",
+				"mapgen_mossycobble", "mapgen_desert_stone"}) {
+			f.name = name;
+			ndef->set(f.name, f);
+		}
+
+		f = ContentFeatures();
+		f.drawtype = NDT_LIQUID;
+		f.walkable = false;
+		f.light_propagates = true;
+		f.liquid_type = LIQUID_SOURCE;
+		for (const char *name : {"mapgen_water_source",
+				"mapgen_river_water_source"}) {
+			f.name = name;
+			ndef->set(f.name, f);
+		}
+		f.name = "mapgen_lava_source";
+		f.light_source = LIGHT_MAX;
+		ndef->set(f.name, f);
+
+		// Server::init is not called, so create it here
+		m_emerge = std::make_unique<EmergeManager>(&m_server, &m_metrics);
+	}
+
+	EmergeManager *emerge() { return m_emerge.get(); }
+	const NodeDefManager *ndef() { return m_server.getNodeDefManager(); }
+
+	/*
+		Registers `count` decorations of all kinds: simple ones on the ground,
+		on liquids and on all floors or ceilings, with a fill ratio or noise,
+		and schematics. Call before init().
+	*/
+	void addDecorations(u32 count)
+	{
+		const NodeDefManager *ndef = this->ndef();
+		DecorationManager *decomgr = emerge()->getWritableDecorationManager();
+
+		// A small tree: a trunk with a crown on top
+		Schematic *schem = SchematicManager::create(SCHEMATIC_NORMAL);
+		schem->name = "tree";
+		schem->m_nodenames = {"ignore", "mapgen_cobble", "mapgen_mossycobble"};
+		schem->m_nnlistsizes.push_back(3);
+		schem->size = v3s16(3, 5, 3);
+		schem->schemdata = new MapNode[3 * 5 * 3];
+		schem->slice_probs = new u8[5];
+		for (s16 y = 0; y < 5; y++) {
+			schem->slice_probs[y] = MTSCHEM_PROB_ALWAYS;
+			for (s16 z = 0; z < 3; z++)
+			for (s16 x = 0; x < 3; x++) {
+				u16 id = (x == 1 && z == 1 && y < 4) ? 1 : (y >= 2 ? 2 : 0);
+				schem->schemdata[(z * 5 + y) * 3 + x] =
+					MapNode(id, MTSCHEM_PROB_ALWAYS, 0);
+			}
+		}
+		ndef->pendNodeResolve(schem);
+		emerge()->getWritableSchematicManager()->add(schem);
+
+		static const s16 sidelens[] = {16, 8, 80, 4, 1};
+		for (u32 i = 0; i < count; i++) {
+			const u32 kind = i % 6;
+			Decoration *deco = DecorationManager::create(
+				kind == 5 ? DECO_SCHEMATIC : DECO_SIMPLE);
+			deco->name = "deco" + std::to_string(i);
+			deco->sidelen = sidelens[i % ARRLEN(sidelens)];
+			deco->fill_ratio = 0.002f * (1 + i % 7);
+			deco->y_min = i % 4 == 0 ? -40 - i : -31000;
+			deco->y_max = 31000;
+			deco->nspawnby = -1;
+			deco->m_nodenames.emplace_back(
+				kind == 4 ? "mapgen_water_source" : "mapgen_stone");
+			deco->m_nnlistsizes.push_back(1);
+			deco->m_nodenames.emplace_back("mapgen_stone");
+			deco->m_nnlistsizes.push_back(1);
+			if (i % 9 == 0)
+				deco->nspawnby = 1;
+
+			if (kind == 1) {
+				deco->np = NoiseParams(0, 0.02f, v3f(60, 60, 60), i, 3, 0.6f, 2.0f);
+				deco->flags |= DECO_USE_NOISE;
+			} else if (kind == 2 || kind == 5) {
+				deco->flags |= DECO_ALL_FLOORS;
+			} else if (kind == 3) {
+				deco->flags |= DECO_ALL_CEILINGS;
+			} else if (kind == 4) {
+				deco->flags |= DECO_LIQUID_SURFACE;
+			}
+
+			if (kind == 5) {
+				auto *deco_schem = static_cast<DecoSchematic *>(deco);
+				deco_schem->schematic = schem;
+				deco_schem->rotation = ROTATE_RAND;
+				deco->flags |= DECO_PLACE_CENTER_X | DECO_PLACE_CENTER_Z;
+			} else {
+				auto *deco_simple = static_cast<DecoSimple *>(deco);
+				deco_simple->m_nodenames.emplace_back(
+					i % 2 ? "mapgen_cobble" : "mapgen_desert_stone");
+				deco_simple->m_nnlistsizes.push_back(1);
+				deco_simple->deco_height = 1;
+				deco_simple->deco_height_max = i % 3;
+				deco_simple->deco_param2 = 0;
+				deco_simple->deco_param2_max = 0;
+			}
+
+			ndef->pendNodeResolve(deco);
+			decomgr->add(deco);
+		}
+	}
+
+	// Takes ownership of `params`
+	Mapgen *init(MapgenParams *params)
+	{
+		m_params.reset(params);
+		if (!params->bparams) {
+			params->bparams = BiomeManager::createBiomeParams(BIOMEGEN_ORIGINAL);
+			params->bparams->seed = params->seed;
+		}
+
+		NodeDefManager *ndef = m_server.getWritableNodeDefManager();
+		ndef->setNodeRegistrationStatus(true);
+		ndef->runNodeResolveCallbacks();
+		ndef->resolveCrossrefs();
+
+		emerge()->initMapgens(params);
+		m_mapgen.reset(emerge()->createMapgen());
+		return m_mapgen.get();
+	}
+
+	/*
+		Generates the chunk that contains `blockpos` into a new voxel
+		manipulator, like ServerMap::initBlockMake does.
+	*/
+	std::unique_ptr<BlockMakeData> makeChunk(v3s16 blockpos)
+	{
+		const v3s16 csize = m_params->chunksize;
+		auto data = std::make_unique<BlockMakeData>();
+		data->seed = m_params->seed;
+		data->blockpos_min = EmergeManager::getContainingChunk(blockpos, csize);
+		data->blockpos_max = data->blockpos_min + csize - v3s16(1);
+		data->nodedef = ndef();
+
+		// With the one block border of ServerMap::EMERGE_EXTRA_BORDER
+		const v3s16 full_bpmin = data->blockpos_min - v3s16(1);
+		const v3s16 full_bpmax = data->blockpos_max + v3s16(1);
+		data->vmanip = new MMVManip(&m_map);
+		MMVManip *vm = data->vmanip;
+		vm->addArea(VoxelArea(full_bpmin * MAP_BLOCKSIZE,
+				(full_bpmax + 1) * MAP_BLOCKSIZE - v3s16(1)));
+		const u32 volume = vm->m_area.getVolume();
+		std::fill_n(vm->m_data, volume, MapNode(CONTENT_IGNORE));
+		memset(vm->m_flags, 0, volume);
+
+		m_mapgen->makeChunk(data.get());
+		return data;
+	}
+
+	// Hash of all nodes in the voxel manipulator
+	static u64 hashNodes(const MMVManip *vm)
+	{
+		return murmur_hash_64_ua(vm->m_data,
+				vm->m_area.getVolume() * sizeof(MapNode), 0);
+	}
+
+private:
+	// Outlives the server, which keeps a pointer to it
+	std::unique_ptr<MapgenParams> m_params;
+	MockServer m_server;
+	MetricsBackend m_metrics;
+	std::unique_ptr<EmergeManager> m_emerge;
+	DummyMap m_map{&m_server, v3s16(0), v3s16(-1)};
+	std::unique_ptr<Mapgen> m_mapgen;
+};
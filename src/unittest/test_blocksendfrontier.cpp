@@ -0,0 +1,62 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "constants.h"
+#include "face_position_cache.h"
+#include "server/blocksendfrontier.h"
+
+TEST_CASE("BlockSendFrontier")
+{
+	const v3s16 center(10, -3, 7);
+	BlockSendFrontier frontier;
+	frontier.setCenter(center);
+	std::unordered_set<v3s16> sent;
+
+	const auto &all = FacePositionCache::getFacePositions(2);
+
+	SECTION("initially everything is unsent") {
+		CHECK(frontier.getUnsent(2, sent) == all);
+	}
+
+	SECTION("sent blocks are dropped in order") {
+		sent.insert(center + all[0]);
+		sent.insert(center + all[5]);
+		std::vector<v3s16> expected;
+		for (size_t i = 0; i < all.size(); i++) {
+			if (i != 0 && i != 5)
+				expected.push_back(all[i]);
+		}
+		CHECK(frontier.getUnsent(2, sent) == expected);
+		CHECK(frontier.size() == expected.size());
+	}
+
+	SECTION("blocks set not sent come back") {
+		for (v3s16 rel : all)
+			sent.insert(center + rel);
+		CHECK(frontier.getUnsent(2, sent).empty());
+
+		sent.erase(center + all[3]);
+		frontier.setNotSent(center + all[3]);
+		CHECK(frontier.getUnsent(2, sent) == std::vector<v3s16>{all[3]});
+	}
+
+	SECTION("moving forgets the shells") {
+		for (v3s16 rel : all)
+			sent.insert(center + rel);
+		CHECK(frontier.getUnsent(2, sent).empty());
+
+		frontier.setCenter(center + v3s16(1, 0, 0));
+		const auto &unsent = frontier.getUnsent(2, sent);
+		CHECK(!unsent.empty());
+		for (v3s16 rel : unsent)
+			CHECK(sent.count(frontier.getCenter() + rel) == 0);
+	}
+
+	SECTION("blocks outside of the map are dropped") {
+		frontier.setCenter(v3s16(0, MAX_MAP_GENERATION_LIMIT / MAP_BLOCKSIZE, 0));
+		for (v3s16 rel : frontier.getUnsent(2, sent))
+			CHECK(rel.Y <= 0);
+	}
+}
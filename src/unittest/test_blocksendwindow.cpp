@@ -0,0 +1,65 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "server/blocksendwindow.h"
+
+// One update interval in which `count` blocks are acknowledged
+static void ackInterval(BlockSendWindow &window, u32 count, float latency,
+		bool limited)
+{
+	for (u32 i = 0; i < count; i++)
+		window.onAck(1000, latency);
+	if (limited)
+		window.onLimited();
+	window.update(BlockSendWindow::UPDATE_INTERVAL);
+}
+
+TEST_CASE("BlockSendWindow")
+{
+	SECTION("static") {
+		BlockSendWindow window(40, 160, false);
+		for (int i = 0; i < 10; i++)
+			ackInterval(window, 40, 0.02f, true);
+		CHECK(window.getSize() == 40);
+		CHECK(window.getThroughput() > 0.0f);
+	}
+
+	SECTION("grows when limited") {
+		BlockSendWindow window(40, 160, true);
+		ackInterval(window, 40, 0.02f, true);
+		CHECK(window.getSize() > 40);
+		for (int i = 0; i < 20; i++)
+			ackInterval(window, 40, 0.02f, true);
+		CHECK(window.getSize() == 160);
+	}
+
+	SECTION("stays when not limited") {
+		BlockSendWindow window(40, 160, true);
+		for (int i = 0; i < 10; i++)
+			ackInterval(window, 10, 0.02f, false);
+		CHECK(window.getSize() == 40);
+	}
+
+	SECTION("shrinks when latency rises") {
+		BlockSendWindow window(40, 160, true);
+		ackInterval(window, 40, 0.02f, true);
+		const u16 size = window.getSize();
+		for (int i = 0; i < 3; i++)
+			ackInterval(window, 40, 0.5f, true);
+		CHECK(window.getSize() < size);
+		for (int i = 0; i < 20; i++)
+			ackInterval(window, 40, 0.5f, true);
+		CHECK(window.getSize() == BlockSendWindow::MIN_SIZE);
+	}
+
+	SECTION("throughput") {
+		BlockSendWindow window(40, 160, true);
+		for (int i = 0; i < 20; i++)
+			ackInterval(window, 50, 0.02f, false);
+		// 50 blocks of 1000 bytes per half second
+		CHECK(window.getThroughput() > 99000.0f);
+		CHECK(window.getThroughput() <= 100000.0f);
+	}
+}
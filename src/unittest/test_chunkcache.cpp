@@ -0,0 +1,62 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "filesys.h"
+#include "script/common/c_chunkcache.h"
+
+extern "C" {
+#include <lauxlib.h>
+#include <lualib.h>
+}
+
+TEST_CASE("ChunkCache")
+{
+	const std::string dir = fs::CreateTempDir();
+	REQUIRE(!dir.empty());
+	ChunkCache::setDirectory(dir);
+	REQUIRE(ChunkCache::isEnabled());
+
+	lua_State *L = luaL_newstate();
+	luaL_openlibs(L);
+
+	// Loads and runs the code, returning its number
+	auto run = [&] (const std::string &code, const char *chunk_name) {
+		REQUIRE(ChunkCache::load(L, code, chunk_name) == 0);
+		REQUIRE(lua_pcall(L, 0, 1, 0) == 0);
+		lua_Number ret = lua_tonumber(L, -1);
+		lua_pop(L, 1);
+		return ret;
+	};
+
+	const auto stats0 = ChunkCache::getStats();
+	CHECK(run("return 1 + 1", "@a.lua") == 2);
+	CHECK(run("return 1 + 1", "@a.lua") == 2);
+	auto stats = ChunkCache::getStats();
+	CHECK(stats.misses - stats0.misses == 1);
+	CHECK(stats.hits - stats0.hits == 1);
+
+	SECTION("changes are compiled again") {
+		CHECK(run("return 1 + 2", "@a.lua") == 3);
+		CHECK(run("return 1 + 1", "@b.lua") == 2);
+		CHECK(ChunkCache::getStats().misses - stats.misses == 2);
+	}
+
+	SECTION("chunk name is kept") {
+		REQUIRE(ChunkCache::load(L, "\nerror('x')", "@c.lua") == 0);
+		REQUIRE(ChunkCache::load(L, "\nerror('x')", "@c.lua") == 0);
+		REQUIRE(lua_pcall(L, 0, 0, 0) != 0);
+		CHECK(std::string(lua_tostring(L, -1)) == "c.lua:2: x");
+		lua_pop(L, 2);
+	}
+
+	SECTION("syntax errors") {
+		CHECK(ChunkCache::load(L, "return +", "@d.lua") == LUA_ERRSYNTAX);
+		lua_pop(L, 1);
+	}
+
+	lua_close(L);
+	ChunkCache::setDirectory("");
+	fs::RecursiveDelete(dir);
+}
@@ -12,6 +12,8 @@
 #include "network/mtp/internal.h"
 #include "network/networkexceptions.h"
 #include "network/networkpacket.h"
+#include "network/packetcapture.h"
+#include "server/packetreplay.h"
 
 class TestConnection : public TestBase {
 public:
@@ -28,6 +30,7 @@ class TestConnection : public TestBase {
 	void testNetworkPacketSerialize();
 	void testHelpers();
 	void testConnectSendReceive();
+	void testPacketCaptureReplay();
 };
 
 static TestConnection g_test_instance;
@@ -37,6 +40,7 @@ void TestConnection::runTests(IGameDef *gamedef)
 	TEST(testNetworkPacketSerialize);
 	TEST(testHelpers);
 	TEST(testConnectSendReceive);
+	TEST(testPacketCaptureReplay);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -355,3 +359,53 @@ void TestConnection::testConnectSendReceive()
 	UASSERT(hand_server.count == 1);
 	UASSERT(hand_server.last_id >= 2);
 }
+
+void TestConnection::testPacketCaptureReplay()
+{
+	const std::string path = getTestTempFile();
+	const std::string pkt_data("\x00\x32hello", 7);
+	{
+		con::PacketCaptureWriter writer(path);
+		UASSERT(writer.isOpen());
+		std::string address("127.0.0.1\0\x75\x30", 12);
+		writer.write(con::PacketCaptureEvent::PEER_ADDED, 2, address);
+		writer.write(con::PacketCaptureEvent::DATA, 2, pkt_data);
+		// not connected, must be skipped on replay
+		writer.write(con::PacketCaptureEvent::DATA, 3, pkt_data);
+		writer.write(con::PacketCaptureEvent::PEER_REMOVED, 2, std::string(1, 1));
+	}
+
+	{
+		con::PacketCaptureReader reader(path);
+		UASSERT(reader.isOpen());
+		UASSERTEQ(u16, reader.getProtocolVersion(), LATEST_PROTOCOL_VERSION);
+		con::PacketCaptureEvent e;
+		UASSERT(reader.read(e));
+		UASSERT(e.type == con::PacketCaptureEvent::PEER_ADDED);
+		UASSERT(reader.read(e));
+		UASSERT(e.type == con::PacketCaptureEvent::DATA);
+		UASSERTEQ(session_t, e.peer_id, 2);
+		UASSERT(e.data == pkt_data);
+		UASSERT(reader.read(e));
+		UASSERT(reader.read(e));
+		UASSERT(e.type == con::PacketCaptureEvent::PEER_REMOVED);
+		UASSERT(!reader.read(e));
+	}
+
+	Handler handler("replay");
+	ReplayConnection con(std::make_unique<con::PacketCaptureReader>(path), false);
+	con.setPeerHandler(&handler);
+
+	NetworkPacket pkt;
+	UASSERT(con.ReceiveTimeoutMs(&pkt, 10));
+	UASSERTEQ(s32, handler.count, 1);
+	UASSERTEQ(session_t, pkt.getPeerId(), 2);
+	UASSERTEQ(u16, pkt.getCommand(), 0x32);
+	UASSERTEQ(u32, pkt.getSize(), 5);
+	UASSERT(con.GetPeerAddress(2).getPort() == 30000);
+
+	UASSERT(!con.ReceiveTimeoutMs(&pkt, 0));
+	UASSERT(!con.ReceiveTimeoutMs(&pkt, 1));
+	UASSERTEQ(s32, handler.count, 0);
+	UASSERT(con.isFinished());
+}
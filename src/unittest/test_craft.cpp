@@ -21,6 +21,7 @@ class TestCraft : public TestBase
 			const std::vector<std::string> &groups, IGameDef *gamedef);
 
 	void testShapeless(IGameDef *gamedef);
+	void testLookup(IGameDef *gamedef);
 };
 
 static TestCraft g_test_instance;
@@ -28,6 +29,7 @@ static TestCraft g_test_instance;
 void TestCraft::runTests(IGameDef *gamedef)
 {
 	TEST(testShapeless, gamedef);
+	TEST(testLookup, gamedef);
 }
 
 std::string TestCraft::getDumpedCraftResult(CraftInput input, IGameDef *gamedef)
@@ -260,3 +262,84 @@ void TestCraft::testShapeless(IGameDef *gamedef)
 			}), gamedef),
 			"(item=\"crafttest:i4\", time=0)");
 }
+
+void TestCraft::testLookup(IGameDef *gamedef)
+{
+	IWritableItemDefManager *idef = (IWritableItemDefManager *)gamedef->getItemDefManager();
+	IWritableCraftDefManager *cdef = (IWritableCraftDefManager *)gamedef->getCraftDefManager();
+
+	auto to_item = [&](const std::string &itemstring) -> ItemStack {
+		ItemStack item;
+		item.deSerialize(itemstring, idef);
+		return item;
+	};
+
+	cdef->clear();
+
+	registerItemWithGroups("crafttest:i1", {}, gamedef);
+	registerItemWithGroups("crafttest:i2", {}, gamedef);
+	registerItemWithGroups("crafttest:i3", {}, gamedef);
+	registerItemWithGroups("crafttest:i4", {}, gamedef);
+	registerItemWithGroups("crafttest:g1g2", {"crafttest_g1", "crafttest_g2"}, gamedef);
+	if (!idef->isKnown("crafttest:tool")) {
+		ItemDefinition itemdef{};
+		itemdef.type = ITEM_TOOL;
+		itemdef.name = "crafttest:tool";
+		idef->registerItem(itemdef);
+	}
+
+	// Group recipes indexed by an item, by a group and by a group string
+	cdef->registerCraft(new CraftDefinitionShaped("crafttest:i1", 2,
+			{"crafttest:i2", "group:crafttest_g1"}, CraftReplacements{}), gamedef);
+	cdef->registerCraft(new CraftDefinitionShaped("crafttest:i3", 2,
+			{"group:crafttest_g1", "group:crafttest_g1"}, CraftReplacements{}), gamedef);
+	cdef->registerCraft(new CraftDefinitionShapeless("crafttest:i4",
+			{"group:crafttest_g2,crafttest_g1", "crafttest:i1"}, CraftReplacements{}), gamedef);
+	// Later recipes override earlier ones
+	cdef->registerCraft(new CraftDefinitionShaped("crafttest:i2", 2,
+			{"group:crafttest_g2", "group:crafttest_g1"}, CraftReplacements{}), gamedef);
+	cdef->registerCraft(new CraftDefinitionToolRepair(0.5f), gamedef);
+	cdef->initHashes(gamedef);
+
+	// Twice each, the second one is cached
+	for (int i = 0; i < 2; i++) {
+		UASSERTEQ(std::string, getDumpedCraftResult(CraftInput(CRAFT_METHOD_NORMAL, 2,
+				{to_item("crafttest:i2"), to_item("crafttest:g1g2")}), gamedef),
+				"(item=\"crafttest:i1\", time=0)");
+		UASSERTEQ(std::string, getDumpedCraftResult(CraftInput(CRAFT_METHOD_NORMAL, 2,
+				{to_item("crafttest:g1g2"), to_item("crafttest:g1g2")}), gamedef),
+				"(item=\"crafttest:i2\", time=0)");
+		UASSERTEQ(std::string, getDumpedCraftResult(CraftInput(CRAFT_METHOD_NORMAL, 2,
+				{to_item("crafttest:i1"), to_item("crafttest:g1g2")}), gamedef),
+				"(item=\"crafttest:i4\", time=0)");
+		UASSERTEQ(std::string, getDumpedCraftResult(CraftInput(CRAFT_METHOD_NORMAL, 2,
+				{to_item("crafttest:i3"), to_item("crafttest:g1g2")}), gamedef),
+				"(item=\"\", time=0)");
+		// Not a group recipe for cooking
+		UASSERTEQ(std::string, getDumpedCraftResult(CraftInput(CRAFT_METHOD_COOKING, 2,
+				{to_item("crafttest:g1g2"), to_item("crafttest:g1g2")}), gamedef),
+				"(item=\"\", time=0)");
+	}
+
+	// Tool repair depends on the wear, which the cache must not hide
+	ItemStack tool = to_item("crafttest:tool");
+	ItemStack worn_tool = to_item("crafttest:tool 1 60000");
+	UASSERTEQ(std::string, getDumpedCraftResult(CraftInput(CRAFT_METHOD_NORMAL, 2,
+			{tool, tool}), gamedef),
+			"(item=\"crafttest:tool\", time=0)");
+	UASSERTEQ(std::string, getDumpedCraftResult(CraftInput(CRAFT_METHOD_NORMAL, 2,
+			{worn_tool, worn_tool}), gamedef),
+			"(item=\"\", time=0)");
+	UASSERTEQ(std::string, getDumpedCraftResult(CraftInput(CRAFT_METHOD_NORMAL, 2,
+			{tool, tool}), gamedef),
+			"(item=\"crafttest:tool\", time=0)");
+
+	// Changing the recipes invalidates the cache
+	cdef->clear();
+	cdef->registerCraft(new CraftDefinitionShapeless("crafttest:i3",
+			{"crafttest:i2", "group:crafttest_g2"}, CraftReplacements{}), gamedef);
+	cdef->initHashes(gamedef);
+	UASSERTEQ(std::string, getDumpedCraftResult(CraftInput(CRAFT_METHOD_NORMAL, 2,
+			{to_item("crafttest:i2"), to_item("crafttest:g1g2")}), gamedef),
+			"(item=\"crafttest:i3\", time=0)");
+}
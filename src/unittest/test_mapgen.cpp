@@ -8,7 +8,11 @@
 #include "mapgen/mapgen.h"
 #include "mapgen/mg_biome.h"
 #include "irrlicht_changes/printing.h"
+#include "settings.h"
 #include "mock_server.h"
+#include "mock_mapgen.h"
+#include "mapgen/mapgen_carpathian.h"
+#include "mapgen/mapgen_v7.h"
 
 class TestMapgen : public TestBase
 {
@@ -20,6 +24,10 @@ class TestMapgen : public TestBase
 
 	void testBiomeGen(IGameDef *gamedef);
 	void testMapgenEdges();
+	void testMapgenOutput();
+	void testColumnNoiseCache();
+	void testBiomeLookup(IGameDef *gamedef);
+	void testDecorationOutput();
 };
 
 static TestMapgen g_test_instance;
@@ -40,6 +48,10 @@ void TestMapgen::runTests(IGameDef *gamedef)
 {
 	TEST(testBiomeGen, gamedef);
 	TEST(testMapgenEdges);
+	TEST(testMapgenOutput);
+	TEST(testColumnNoiseCache);
+	TEST(testBiomeLookup, gamedef);
+	TEST(testDecorationOutput);
 }
 
 void TestMapgen::testBiomeGen(IGameDef *gamedef)
@@ -138,3 +150,194 @@ void TestMapgen::testMapgenEdges()
 	UASSERTEQ(auto, emin, v3s16(-8016));
 	UASSERTEQ(auto, emax, v3s16(8031, 8015, 8031));
 }
+
+void TestMapgen::testMapgenOutput()
+{
+	// Optimizations must not change the generated nodes. The chunks cover
+	// the surface, mountains, floatlands, the sky and deep caverns. Some
+	// are above each other, so their column noise comes from the cache.
+	// Like the noise, the hashes are only checked with SSE float math.
+	constexpr u32 V7_FLAGS = MGV7_MOUNTAINS | MGV7_RIDGES | MGV7_FLOATLANDS |
+		MGV7_CAVERNS;
+	constexpr u32 CARPATHIAN_FLAGS = MGCARPATHIAN_CAVERNS | MGCARPATHIAN_RIVERS;
+	const struct {
+		MapgenType type;
+		u32 spflags;
+		v3s16 blockpos;
+		u64 hash;
+	} expected_chunks[] = {
+		{ MAPGEN_V7, V7_FLAGS, v3s16(-7, 0, 12), 0xace98d977e08bec1 },
+		{ MAPGEN_V7, V7_FLAGS, v3s16(25, 10, 0), 0x517e4e0675b5dbb8 },
+		{ MAPGEN_V7, V7_FLAGS, v3s16(50, 10, 25), 0xfb39e12b306a1281 },
+		{ MAPGEN_V7, V7_FLAGS, v3s16(25, 40, 0), 0x22a129996670fe8c },
+		{ MAPGEN_V7, V7_FLAGS, v3s16(0, 80, -25), 0xbe36b148411d9436 },
+		{ MAPGEN_V7, V7_FLAGS, v3s16(0, 300, 0), 0x22a129996670fe8c },
+		{ MAPGEN_V7, V7_FLAGS, v3s16(-7, -100, 12), 0xf9fcfc94aabfa9be },
+		{ MAPGEN_CARPATHIAN, CARPATHIAN_FLAGS, v3s16(-7, 0, 12), 0x645ef3ef23de8971 },
+		{ MAPGEN_CARPATHIAN, CARPATHIAN_FLAGS, v3s16(-50, 10, -50), 0x7d2f8fe6fde154c7 },
+		{ MAPGEN_CARPATHIAN, CARPATHIAN_FLAGS, v3s16(0, 10, 25), 0x19fc7f4922df41b9 },
+		{ MAPGEN_CARPATHIAN, CARPATHIAN_FLAGS, v3s16(-50, 40, -50), 0x22a129996670fe8c },
+		{ MAPGEN_CARPATHIAN, CARPATHIAN_FLAGS, v3s16(-7, -100, 12), 0xf9fcfc94aabfa9be },
+	};
+
+	// Also with the chunks split between threads
+	for (const char *chunk_threads : {"1", "4"}) {
+		g_settings->set("mapgen_chunk_threads", chunk_threads);
+		std::unique_ptr<MockMapgen> mg;
+		MapgenType mg_type = MAPGEN_INVALID;
+		for (const auto &expected : expected_chunks) {
+			if (expected.type != mg_type) {
+				mg = std::make_unique<MockMapgen>();
+				mg_type = expected.type;
+				MapgenParams *params = Mapgen::createMapgenParams(mg_type);
+				params->mgtype = mg_type;
+				params->seed = 1234567;
+				params->flags = MG_CAVES | MG_DUNGEONS | MG_LIGHT | MG_DECORATIONS |
+					MG_BIOMES | MG_ORES;
+				params->spflags = expected.spflags;
+				mg->init(params);
+			}
+
+			auto data = mg->makeChunk(expected.blockpos);
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+			u64 hash = MockMapgen::hashNodes(data->vmanip);
+			if (hash != expected.hash) {
+				errorstream << Mapgen::getMapgenName(expected.type) << " chunk at "
+					<< expected.blockpos << " has hash 0x" << std::hex << hash
+					<< std::dec << std::endl;
+			}
+			UASSERTEQ(u64, hash, expected.hash);
+#endif
+		}
+	}
+	g_settings->remove("mapgen_chunk_threads");
+}
+
+void TestMapgen::testColumnNoiseCache()
+{
+	NoiseParams np(0, 1, v3f(20, 20, 20), 1, 2, 0.5f, 2.0f);
+	Noise noise(&np, 42, 4, 4);
+	ColumnNoiseCache cache("TestMapgen", {&noise}, 2);
+
+	auto calc = [&] (v2s16 pos) {
+		noise.noiseMap2D(pos.X, pos.Y);
+		return std::vector<float>(noise.result, noise.result + 16);
+	};
+	const v2s16 a(0, 0), b(80, 0), c(0, -80);
+	const std::vector<float> result_a = calc(a);
+	UASSERT(!cache.load(a));
+	cache.store(a);
+	calc(b);
+	UASSERT(!cache.load(b));
+	cache.store(b);
+
+	UASSERT(cache.load(a));
+	UASSERT(std::vector<float>(noise.result, noise.result + 16) == result_a);
+
+	// Replaces b, which was used less recently than a
+	calc(c);
+	cache.store(c);
+	UASSERT(!cache.load(b));
+	UASSERT(cache.load(c));
+	UASSERT(cache.load(a));
+	UASSERT(std::vector<float>(noise.result, noise.result + 16) == result_a);
+
+	UASSERTEQ(u32, cache.getHits(), 3);
+	UASSERTEQ(u32, cache.getMisses(), 3);
+}
+
+void TestMapgen::testBiomeLookup(IGameDef *gamedef)
+{
+	// The lookup tables must find the same biomes as checking all of them,
+	// also for ties, weights, vertical blend and X/Z limits
+	MockServer server(getTestTempDirectory());
+	std::unique_ptr<BiomeParams> params(BiomeManager::createBiomeParams(BIOMEGEN_ORIGINAL));
+
+	for (u32 num_biomes : {5, 60}) {
+		MockBiomeManager bmgr(&server);
+		bmgr.setNodeDefManager(gamedef->getNodeDefManager());
+		PcgRandom pr(num_biomes);
+		for (u32 i = 0; i < num_biomes; i++) {
+			Biome *b = BiomeManager::create(BIOMETYPE_NORMAL);
+			b->name = "biome" + std::to_string(i);
+			if (i % 7 == 6) {
+				// Same point as another biome
+				Biome *other = (Biome *)bmgr.getRaw(1 + pr.range(0, i - 1));
+				b->heat_point = other->heat_point;
+				b->humidity_point = other->humidity_point;
+			} else {
+				b->heat_point = pr.range(0, 100);
+				b->humidity_point = pr.range(0, 1000) / 10.0f;
+			}
+			b->weight = i % 5 == 0 ? 0.0f : pr.range(5, 20) / 10.0f;
+			b->min_pos.Y = pr.range(-150, 50);
+			b->max_pos.Y = b->min_pos.Y + pr.range(0, 150);
+			if (i % 3 == 0)
+				b->vertical_blend = pr.range(1, 20);
+			if (i % 11 == 0) {
+				b->min_pos.X = pr.range(-100, 0);
+				b->max_pos.Z = pr.range(0, 100);
+			}
+			UASSERT(bmgr.add(b) != OBJDEF_INVALID_HANDLE);
+		}
+
+		BiomeGenOriginal biomegen(&bmgr,
+			static_cast<BiomeParamsOriginal *>(params.get()), v3s16(16, 16, 16));
+		for (u32 i = 0; i < 50000; i++) {
+			float heat = pr.range(-500, 1500) / 10.0f;
+			float humidity = pr.range(-500, 1500) / 10.0f;
+			if (i % 4 == 0) {
+				// Exactly at or between biome points
+				Biome *b1 = (Biome *)bmgr.getRaw(1 + pr.range(0, num_biomes - 1));
+				Biome *b2 = (Biome *)bmgr.getRaw(1 + pr.range(0, num_biomes - 1));
+				heat = (b1->heat_point + b2->heat_point) / 2;
+				humidity = i % 8 == 0 ? b1->humidity_point :
+					(b1->humidity_point + b2->humidity_point) / 2;
+			}
+			v3s16 pos(pr.range(-200, 200), pr.range(-200, 200), pr.range(-200, 200));
+			if (i % 100 == 0)
+				pos.X = 32000;
+			UASSERT(biomegen.calcBiomeFromNoise(heat, humidity, pos) ==
+				biomegen.calcBiomeFromNoiseLinear(heat, humidity, pos));
+		}
+	}
+}
+
+void TestMapgen::testDecorationOutput()
+{
+	// Decorations on the surface, in water, in caves and in caverns must not
+	// change either when they share the surfaces of the columns
+	const struct {
+		v3s16 blockpos;
+		u64 hash;
+	} expected_chunks[] = {
+		{ v3s16(-7, 0, 12), 0x6968657294285582 },
+		{ v3s16(-30, 0, 30), 0x09f04c3bac41011f },
+		{ v3s16(25, 10, 0), 0xf995ed14027fe807 },
+		{ v3s16(50, 10, 25), 0x33caa3d12bdebd37 },
+		{ v3s16(-7, -5, 12), 0xbcaa9b8a25841c21 },
+		{ v3s16(-7, -100, 12), 0x0a6ed75c96f4a229 },
+	};
+
+	MockMapgen mg;
+	mg.addDecorations(60);
+	MapgenParams *params = Mapgen::createMapgenParams(MAPGEN_V7);
+	params->mgtype = MAPGEN_V7;
+	params->seed = 1234567;
+	params->flags = MG_CAVES | MG_DUNGEONS | MG_LIGHT | MG_DECORATIONS |
+		MG_BIOMES | MG_ORES;
+	params->spflags = MGV7_MOUNTAINS | MGV7_RIDGES | MGV7_CAVERNS;
+	mg.init(params);
+
+	for (const auto &expected : expected_chunks) {
+		auto data = mg.makeChunk(expected.blockpos);
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+		u64 hash = MockMapgen::hashNodes(data->vmanip);
+		if (hash != expected.hash) {
+			errorstream << "Chunk at " << expected.blockpos << " has hash 0x"
+				<< std::hex << hash << std::dec << std::endl;
+		}
+		UASSERTEQ(u64, hash, expected.hash);
+#endif
+	}
+}
@@ -0,0 +1,99 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "dummygamedef.h"
+#include "mapblock.h"
+#include "voxel.h"
+#include "server/mapsnapshot.h"
+
+TEST_CASE("MapSnapshot")
+{
+	DummyGameDef gamedef;
+	const v3s16 blockpos(1, -2, 3);
+	const v3s16 base = blockpos * MAP_BLOCKSIZE;
+	MapBlock block(blockpos, &gamedef);
+	for (u32 i = 0; i < MAP_BLOCKSIZE * MAP_BLOCKSIZE * MAP_BLOCKSIZE; i++)
+		block.setNodeNoCheck(i % 16, i / 16 % 16, i / 256, MapNode(CONTENT_AIR));
+	block.setNode(v3s16(1, 2, 3), MapNode(10, 0, 4));
+
+	MapSnapshot snapshot;
+	snapshot.update(&block);
+	CHECK(snapshot.size() == 1);
+
+	SECTION("nodes are copied") {
+		MapSnapshotView view(snapshot);
+		bool valid = false;
+		MapNode n = view.getNode(base + v3s16(1, 2, 3), &valid);
+		CHECK(valid);
+		CHECK(n.getContent() == 10);
+		CHECK(n.getParam2() == 4);
+		CHECK(view.getNode(base).getContent() == CONTENT_AIR);
+
+		n = view.getNode(base - v3s16(1, 0, 0), &valid);
+		CHECK(!valid);
+		CHECK(n.getContent() == CONTENT_IGNORE);
+	}
+
+	SECTION("views keep their copy") {
+		MapSnapshotView old_view(snapshot);
+		CHECK(old_view.getNode(base).getContent() == CONTENT_AIR);
+
+		block.setNode(v3s16(0, 0, 0), MapNode(11));
+		snapshot.update(&block);
+
+		CHECK(old_view.getNode(base).getContent() == CONTENT_AIR);
+		MapSnapshotView new_view(snapshot);
+		CHECK(new_view.getNode(base).getContent() == 11);
+	}
+
+	SECTION("removed blocks are gone") {
+		snapshot.remove(blockpos);
+		CHECK(snapshot.size() == 0);
+		MapSnapshotView view(snapshot);
+		bool valid = true;
+		view.getNode(base, &valid);
+		CHECK(!valid);
+	}
+
+	SECTION("iterating an area") {
+		// One node in the block, one outside of it
+		MapSnapshotView view(snapshot);
+		u32 count = 0, found = 0, ignore = 0;
+		view.forEachNodeInArea(base + v3s16(-1, 2, 3), base + v3s16(1, 2, 3),
+			[&] (v3s16 p, MapNode n) {
+				count++;
+				if (n.getContent() == 10) {
+					CHECK(p == base + v3s16(1, 2, 3));
+					found++;
+				} else if (n.getContent() == CONTENT_IGNORE) {
+					CHECK(p == base + v3s16(-1, 2, 3));
+					ignore++;
+				}
+				return true;
+			});
+		CHECK(count == 3);
+		CHECK(found == 1);
+		CHECK(ignore == 1);
+	}
+
+	SECTION("uniform blocks are stored compactly") {
+		const v3s16 airpos = blockpos + v3s16(1, 0, 0);
+		MapBlock air(airpos, &gamedef);
+		VoxelManipulator vm;
+		const VoxelArea area(air.getPosRelative(),
+				air.getPosRelative() + v3s16(MAP_BLOCKSIZE - 1));
+		vm.addArea(area);
+		for (u32 i = 0; i < area.getVolume(); i++)
+			vm.m_data[i] = MapNode(CONTENT_AIR);
+		air.copyFrom(vm);
+
+		snapshot.update(&air);
+		auto copy = snapshot.get(airpos);
+		REQUIRE(copy);
+		CHECK(copy->nodes.size() == 1);
+		MapSnapshotView view(snapshot);
+		CHECK(view.getNode(air.getPosRelative() + v3s16(5, 6, 7)).getContent() == CONTENT_AIR);
+	}
+}
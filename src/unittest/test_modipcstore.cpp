@@ -0,0 +1,74 @@
+// Luanti
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// Copyright (C) 2026 Luanti developers
+
+#include "catch.h"
+#include "script/common/c_packer.h"
+#include "server/modipcstore.h"
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("ModIPCStore")
+{
+	ModIPCStore store;
+	auto value1 = std::make_shared<PackedValue>();
+	auto value2 = std::make_shared<PackedValue>();
+
+	SECTION("get and set") {
+		u64 version = 123;
+		CHECK(store.get("a", &version) == nullptr);
+		CHECK(version == ModIPCStore::NO_VERSION);
+
+		u64 v1 = store.set("a", value1);
+		CHECK(v1 != ModIPCStore::NO_VERSION);
+		CHECK(store.get("a", &version) == value1);
+		CHECK(version == v1);
+
+		u64 v2 = store.set("a", value2);
+		CHECK(v2 > v1);
+		CHECK(store.get("a") == value2);
+		CHECK(store.getVersion("b") == ModIPCStore::NO_VERSION);
+
+		CHECK(store.set("a", nullptr) == ModIPCStore::NO_VERSION);
+		CHECK(store.get("a") == nullptr);
+		CHECK(store.getVersion("a") == ModIPCStore::NO_VERSION);
+	}
+
+	SECTION("set if version") {
+		CHECK(!store.setIfVersion("a", 1, value1));
+		CHECK(store.setIfVersion("a", ModIPCStore::NO_VERSION, value1));
+		u64 v1 = store.getVersion("a");
+		CHECK(!store.setIfVersion("a", ModIPCStore::NO_VERSION, value2));
+		CHECK(store.setIfVersion("a", v1, value2));
+		CHECK(!store.setIfVersion("a", v1, value1));
+		CHECK(store.get("a") == value2);
+	}
+
+	SECTION("wait") {
+		CHECK(!store.waitForValue("a", 0ms));
+		CHECK(!store.waitForChange("a", ModIPCStore::NO_VERSION, 0ms));
+
+		u64 v1 = store.set("a", value1);
+		CHECK(store.waitForValue("a", 0ms));
+		CHECK(store.waitForChange("a", ModIPCStore::NO_VERSION, 0ms));
+		CHECK(!store.waitForChange("a", v1, 0ms));
+
+		std::thread writer([&] {
+			std::this_thread::sleep_for(10ms);
+			store.set("b", value1); // other key
+			store.set("a", value2);
+		});
+		CHECK(store.waitForChange("a", v1, 10s));
+		CHECK(store.get("a") == value2);
+		writer.join();
+
+		std::thread remover([&] {
+			std::this_thread::sleep_for(10ms);
+			store.set("a", nullptr);
+		});
+		CHECK(store.waitForChange("a", store.getVersion("a"), 10s));
+		CHECK(store.get("a") == nullptr);
+		remover.join();
+	}
+}
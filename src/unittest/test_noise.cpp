@@ -7,6 +7,7 @@
 #include <cmath>
 #include "exceptions.h"
 #include "noise.h"
+#include "util/numeric.h"
 
 class TestNoise : public TestBase {
 public:
@@ -26,6 +27,9 @@ class TestNoise : public TestBase {
 	void testNoise3dPoint();
 	void testNoise3dBulk();
 	void testNoiseInvalidParams();
+	void testNoiseMapsExact();
+	void testNoiseFractalBounds();
+	void testNoiseFractal2DGrid();
 
 	static const float expected_2d_results[10 * 10];
 	static const float expected_3d_results[10 * 10 * 10];
@@ -46,6 +50,9 @@ void TestNoise::runTests(IGameDef *gamedef)
 	TEST(testNoise3dPoint);
 	TEST(testNoise3dBulk);
 	TEST(testNoiseInvalidParams);
+	TEST(testNoiseMapsExact);
+	TEST(testNoiseFractalBounds);
+	TEST(testNoiseFractal2DGrid);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -160,6 +167,63 @@ void TestNoise::testNoiseInvalidParams()
 	UASSERT(exception_thrown);
 }
 
+void TestNoise::testNoiseMapsExact()
+{
+	// Hashes of the noise maps of earlier versions, these must not change
+	// as they decide the terrain of existing worlds. They were calculated
+	// with SSE float math, other platforms may round differently.
+	struct Case {
+		NoiseParams np;
+		v3s16 size;
+		v3f pos;
+		bool persistence;
+		u64 expected;
+	};
+	const Case cases[] = {
+		// Mapgen v7 mountains, with a chunk and the overgeneration
+		{NoiseParams(-0.6f, 1.0f, v3f(250, 350, 250), 5333, 5, 0.63f, 2.0f),
+			v3s16(80, 82, 80), v3f(-32, -33, -32), false, 0xbba32741d82597c5ULL},
+		// Cave noise
+		{NoiseParams(0, 12, v3f(61, 61, 61), 52534, 3, 0.5f, 2.0f, NOISE_FLAG_EASED),
+			v3s16(80, 82, 80), v3f(48, -113, 208), false, 0x84cbdbca989a7c54ULL},
+		{NoiseParams(0, 1, v3f(30, 40, 30), 2, 4, 0.7f, 2.0f, NOISE_FLAG_ABSVALUE),
+			v3s16(17, 9, 13), v3f(-1000.3f, 2.7f, 53.1f), true, 0xbc3c6ccd145a7dadULL},
+		// Terrain height, eased by default
+		{NoiseParams(4, 70, v3f(600, 600, 600), 82341, 8, 0.7f, 2.0f),
+			v3s16(80, 80, 1), v3f(-32, -32, 0), false, 0x5d3ae3ec04124b68ULL},
+		{NoiseParams(0, 1, v3f(32, 32, 32), 7, 5, 0.6f, 2.0f,
+				NOISE_FLAG_DEFAULTS | NOISE_FLAG_ABSVALUE),
+			v3s16(23, 7, 1), v3f(4000.5f, -77.25f, 0), true, 0xd202053d89bf3111ULL},
+	};
+
+	for (const Case &c : cases) {
+		const u32 size = c.size.X * c.size.Y * c.size.Z;
+		std::vector<float> persistence(size);
+		for (u32 i = 0; i < size; i++)
+			persistence[i] = 0.4f + 0.5f * (i % 7) / 7;
+
+		Noise noise(&c.np, 1337, c.size.X, c.size.Y, c.size.Z);
+		auto calculate = [&] (bool simd) {
+			noise_simd_enable(simd);
+			float *result = c.size.Z > 1 ?
+				noise.noiseMap3D(c.pos.X, c.pos.Y, c.pos.Z,
+					c.persistence ? persistence.data() : nullptr) :
+				noise.noiseMap2D(c.pos.X, c.pos.Y,
+					c.persistence ? persistence.data() : nullptr);
+			noise_simd_enable(true);
+			return std::vector<float>(result, result + size);
+		};
+		std::vector<float> values = calculate(false);
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+		u64 hash = murmur_hash_64_ua(values.data(), size * sizeof(float), 0);
+		UASSERTEQ(u64, hash, c.expected);
+#endif
+		// Identical with SIMD
+		UASSERT(calculate(true) == values);
+	}
+}
+
 const float TestNoise::expected_2d_results[10 * 10] = {
 	19.11726, 18.49626, 16.48476, 15.02135, 14.75713, 16.26008, 17.54822,
 	18.06860, 18.57016, 18.48407, 18.49649, 17.89160, 15.94162, 14.54901,
@@ -323,3 +387,49 @@ const float TestNoise::expected_3d_results[10 * 10 * 10] = {
 	24.76337, 25.94205, 27.12073, 18.80933, 18.35777, 17.90622, 17.45466,
 	18.91445, 20.64729, 22.38013, 24.32880, 26.34941, 28.37003,
 };
+
+void TestNoise::testNoiseFractalBounds()
+{
+	const NoiseParams params[] = {
+		NoiseParams(-0.6f, 1.0f, v3f(25, 35, 25), 5333, 5, 0.63f, 2.0f),
+		NoiseParams(256.0f, -112.0f, v3f(100, 100, 100), 72449, 3, 0.6f, 2.0f),
+		NoiseParams(0.0f, 1.0f, v3f(10, 10, 10), 6467, 4, 1.2f, 2.0f, NOISE_FLAG_EASED),
+		NoiseParams(5.0f, 3.0f, v3f(20, 20, 20), 85039, 5, -0.6f, 2.0f, NOISE_FLAG_ABSVALUE),
+	};
+
+	for (const NoiseParams &np : params) {
+		float min, max;
+		NoiseFractalBounds(&np, min, max);
+		UASSERT(min < max);
+
+		Noise noise(&np, 1337, 20, 20, 20);
+		const float *values = noise.noiseMap3D(-17.5f, 3.0f, 1000.0f);
+		for (u32 i = 0; i < 20 * 20 * 20; i++)
+			UASSERT(values[i] >= min && values[i] <= max);
+	}
+}
+
+void TestNoise::testNoiseFractal2DGrid()
+{
+	const NoiseParams params[] = {
+		NoiseParams(0.0f, 0.02f, v3f(60, 60, 60), 17, 3, 0.6f, 2.0f),
+		NoiseParams(0.5f, 1.0f, v3f(10, 30, 10), 6467, 4, 0.5f, 2.0f, NOISE_FLAG_EASED),
+		NoiseParams(-1.0f, 3.0f, v3f(20, 20, 20), 85039, 5, -0.6f, 2.5f,
+			NOISE_FLAG_DEFAULTS | NOISE_FLAG_ABSVALUE),
+		NoiseParams(0.0f, 1.0f, v3f(7, 7, 7), 3, 2, 0.7f, 2.0f, 0),
+	};
+
+	// Identical to NoiseFractal2D, also with SIMD
+	for (const NoiseParams &np : params)
+	for (bool simd : {false, true}) {
+		noise_simd_enable(simd);
+		float result[17 * 5];
+		NoiseFractal2DGrid(&np, -4000, 115, 5, 17, 5, 1337, result);
+		for (u32 j = 0; j < 5; j++)
+		for (u32 i = 0; i < 17; i++) {
+			UASSERT(result[j * 17 + i] ==
+				NoiseFractal2D(&np, -4000 + 5 * (s32)i, 115 + 5 * (s32)j, 1337));
+		}
+	}
+	noise_simd_enable(true);
+}
@@ -6,7 +6,10 @@
 
 #include <atomic>
 #include <iostream>
+#include <stdexcept>
+#include "threading/parallel.h"
 #include "threading/semaphore.h"
+#include "threading/taskpool.h"
 #include "threading/thread.h"
 
 
@@ -19,6 +22,8 @@ class TestThreading : public TestBase {
 	void testStartStopWait();
 	void testAtomicSemaphoreThread();
 	void testTLS();
+	void testParallelFor();
+	void testTaskGraph();
 };
 
 static TestThreading g_test_instance;
@@ -28,6 +33,8 @@ void TestThreading::runTests(IGameDef *gamedef)
 	TEST(testStartStopWait);
 	TEST(testAtomicSemaphoreThread);
 	TEST(testTLS);
+	TEST(testParallelFor);
+	TEST(testTaskGraph);
 }
 
 class SimpleTestThread : public Thread {
@@ -227,3 +234,86 @@ void TestThreading::testTLS()
 		}
 	}
 }
+
+void TestThreading::testParallelFor()
+{
+	for (size_t count : {0, 1, 7, 1000, 1001}) {
+		std::vector<std::atomic<u32>> visits(count);
+		for (auto &v : visits)
+			v = 0;
+		parallel_for(count, 10, [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+				visits[i]++;
+		});
+		for (auto &v : visits)
+			UASSERTEQ(u32, v, 1);
+	}
+
+	bool thrown = false;
+	try {
+		parallel_for(1000, 1, [] (size_t begin, size_t end) {
+			if (begin <= 500 && 500 < end)
+				throw std::runtime_error("test");
+		});
+	} catch (std::runtime_error &e) {
+		thrown = true;
+	}
+	UASSERT(thrown);
+}
+
+void TestThreading::testTaskGraph()
+{
+	TaskPool pool(3);
+	for (TaskPool *p : {&pool, (TaskPool *)nullptr}) {
+		// Chains of tasks that each depend on the one before and on a
+		// shared first task
+		std::atomic<u32> first_done{0};
+		std::vector<u32> chains(8, 0);
+		std::atomic<bool> order_ok{true};
+		TaskGraph graph(p);
+		auto first = graph.add([&] { first_done = 1; });
+		for (u32 c = 0; c < chains.size(); c++) {
+			auto prev = first;
+			for (u32 i = 0; i < 20; i++) {
+				prev = graph.add([&, c, i] {
+					if (first_done != 1 || chains[c] != i)
+						order_ok = false;
+					chains[c]++;
+				}, {first, prev});
+			}
+		}
+		graph.run();
+		UASSERT(order_ok);
+		for (u32 n : chains)
+			UASSERTEQ(u32, n, 20);
+
+		// Nested graphs and parallel_for
+		std::vector<std::atomic<u32>> visits(1000);
+		for (auto &v : visits)
+			v = 0;
+		parallel_for(p, 10, 1, [&] (size_t begin, size_t end) {
+			for (size_t j = begin; j < end; j++) {
+				parallel_for(p, 100, 7, [&] (size_t begin2, size_t end2) {
+					for (size_t i = begin2; i < end2; i++)
+						visits[j * 100 + i]++;
+				});
+			}
+		});
+		for (auto &v : visits)
+			UASSERTEQ(u32, v, 1);
+
+		// Exceptions skip the remaining tasks
+		std::atomic<bool> after_ran{false};
+		TaskGraph failing(p);
+		auto throwing = failing.add([] { throw std::runtime_error("test"); });
+		failing.add([&] { after_ran = true; }, {throwing});
+		bool thrown = false;
+		try {
+			failing.run();
+		} catch (std::runtime_error &e) {
+			thrown = true;
+		}
+		UASSERT(thrown);
+		UASSERT(!after_ran);
+	}
+}